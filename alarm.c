@@ -0,0 +1,198 @@
+/**
+ * Threshold alarm engine
+ *
+ * Output patterns are 32-bit masks stepped every ALARM_TICK_MS by a
+ * repeating timer, so one bit is one 100 ms slot and a pattern repeats
+ * every 3.2 s.
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "alarm.h"
+#include "log.h"
+
+#ifdef BUZZER_PIN
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+
+#define BUZZER_FREQ_HZ 2700
+#endif
+
+#define ALARM_TICK_MS 100
+#define ALARM_BLIP_MS 50
+
+// LED and buzzer patterns per level
+static const uint32_t led_patterns[] = {
+    [ALARM_OK]   = 0x00000000,
+    [ALARM_WARN] = 0x000F000F,  // Slow blink
+    [ALARM_CRIT] = 0x33333333,  // Fast blink
+};
+
+static const uint32_t buzzer_patterns[] = {
+    [ALARM_OK]   = 0x00000000,
+    [ALARM_WARN] = 0x00000000,
+    [ALARM_CRIT] = 0x00050005,  // Two chirps every 1.6 s
+};
+
+typedef struct {
+    alarm_config cfg;
+    alarm_level level;
+    alarm_level pending;    // Level waiting out its hold time
+    uint32_t pending_since;
+} alarm_state;
+
+static alarm_state channels[ALARM_CH_COUNT];
+static const char *channel_names[ALARM_CH_COUNT] = {"Temperature", "Humidity", "CO2"};
+
+static unsigned int led;
+static volatile alarm_level output_level = ALARM_OK;
+static volatile bool blip_active = false;
+static uint8_t pattern_slot = 0;
+static repeating_timer_t pattern_timer;
+
+#ifdef BUZZER_PIN
+static uint buzzer_slice;
+static uint16_t buzzer_wrap;
+
+static void buzzer_set(bool on) {
+    pwm_set_gpio_level(BUZZER_PIN, on ? buzzer_wrap / 2 : 0);
+}
+#endif
+
+static bool pattern_tick(repeating_timer_t *rt) {
+    (void)rt;
+    uint32_t bit = 1u << pattern_slot;
+    pattern_slot = (pattern_slot + 1) % 32;
+
+    alarm_level level = output_level;
+    if (!blip_active) {
+        gpio_put(led, (led_patterns[level] & bit) != 0);
+    }
+#ifdef BUZZER_PIN
+    buzzer_set((buzzer_patterns[level] & bit) != 0);
+#else
+    (void)buzzer_patterns;
+#endif
+    return true;
+}
+
+static int64_t blip_end(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    blip_active = false;
+    gpio_put(led, 0);
+    return 0;
+}
+
+void alarm_init(unsigned int led_pin) {
+    led = led_pin;
+    gpio_init(led);
+    gpio_set_dir(led, GPIO_OUT);
+
+#ifdef BUZZER_PIN
+    gpio_set_function(BUZZER_PIN, GPIO_FUNC_PWM);
+    buzzer_slice = pwm_gpio_to_slice_num(BUZZER_PIN);
+    // Count at 1 MHz and wrap at the tone frequency
+    pwm_set_clkdiv(buzzer_slice, clock_get_hz(clk_sys) / 1000000.0f);
+    buzzer_wrap = 1000000 / BUZZER_FREQ_HZ - 1;
+    pwm_set_wrap(buzzer_slice, buzzer_wrap);
+    buzzer_set(false);
+    pwm_set_enabled(buzzer_slice, true);
+#endif
+
+    // Defaults: CO2 follows the OK/BAD labels, the rest are comfort limits
+    const alarm_config temp = {true, 30.0f, 35.0f, 0.5f, 10000};
+    const alarm_config humidity = {true, 70.0f, 80.0f, 2.0f, 10000};
+    const alarm_config co2 = {true, 1000.0f, 2000.0f, 50.0f, 0};
+    alarm_configure(ALARM_CH_TEMP, &temp);
+    alarm_configure(ALARM_CH_HUMIDITY, &humidity);
+    alarm_configure(ALARM_CH_CO2, &co2);
+
+    add_repeating_timer_ms(ALARM_TICK_MS, pattern_tick, NULL, &pattern_timer);
+}
+
+void alarm_configure(alarm_channel ch, const alarm_config *cfg) {
+    channels[ch].cfg = *cfg;
+    channels[ch].level = ALARM_OK;
+    channels[ch].pending = ALARM_OK;
+}
+
+// Level the value asks for, given the level the channel is in now
+static alarm_level target_level(const alarm_config *cfg, alarm_level current, float value) {
+    // Thresholds at or below the current level only clear past the hysteresis band
+    float crit = current >= ALARM_CRIT ? cfg->crit - cfg->hysteresis : cfg->crit;
+    float warn = current >= ALARM_WARN ? cfg->warn - cfg->hysteresis : cfg->warn;
+
+    if (value >= crit) return ALARM_CRIT;
+    if (value >= warn) return ALARM_WARN;
+    return ALARM_OK;
+}
+
+alarm_level alarm_update(alarm_channel ch, float value, uint32_t now_ms) {
+    alarm_state *st = &channels[ch];
+    if (!st->cfg.enabled) {
+        return ALARM_OK;
+    }
+
+    alarm_level target = target_level(&st->cfg, st->level, value);
+    if (target == st->level) {
+        st->pending = st->level;
+        return st->level;
+    }
+
+    if (target != st->pending) {
+        st->pending = target;
+        st->pending_since = now_ms;
+    }
+
+    if (now_ms - st->pending_since >= st->cfg.hold_ms) {
+        LOG_WARN("%s alarm: %s -> %s (%.1f)", channel_names[ch],
+                 alarm_level_name(st->level), alarm_level_name(target), value);
+        st->level = target;
+        output_level = alarm_overall_level();
+    }
+    return st->level;
+}
+
+void alarm_update_sample(const sensor_sample *sample, uint32_t now_ms) {
+    if (sample->valid & SAMPLE_TEMP) {
+        alarm_update(ALARM_CH_TEMP, sample->temp_x10 / 10.0f, now_ms);
+    }
+    if (sample->valid & SAMPLE_HUMIDITY) {
+        alarm_update(ALARM_CH_HUMIDITY, sample->humidity_x10 / 10.0f, now_ms);
+    }
+    if (sample->valid & SAMPLE_CO2) {
+        alarm_update(ALARM_CH_CO2, sample->co2_ppm, now_ms);
+    }
+}
+
+alarm_level alarm_channel_level(alarm_channel ch) {
+    return channels[ch].level;
+}
+
+alarm_level alarm_overall_level(void) {
+    alarm_level level = ALARM_OK;
+    for (int i = 0; i < ALARM_CH_COUNT; i++) {
+        if (channels[i].level > level) level = channels[i].level;
+    }
+    return level;
+}
+
+void alarm_blip(void) {
+    // Blinking patterns already show activity
+    if (output_level != ALARM_OK) {
+        return;
+    }
+    blip_active = true;
+    gpio_put(led, 1);
+    add_alarm_in_ms(ALARM_BLIP_MS, blip_end, NULL, true);
+}
+
+const char *alarm_level_name(alarm_level level) {
+    switch (level) {
+    case ALARM_WARN: return "WARN";
+    case ALARM_CRIT: return "CRIT";
+    default:         return "OK";
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * Threshold alarm engine
+ *
+ * Each channel has a warning and a critical threshold, a hysteresis band
+ * and a hold time. Levels are re-evaluated on every sample; the LED and
+ * optional buzzer patterns run from a repeating hardware timer so nothing
+ * in the main loop ever waits on them.
+ */
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensors.h"
+
+typedef enum {
+    ALARM_CH_TEMP,
+    ALARM_CH_HUMIDITY,
+    ALARM_CH_CO2,
+    ALARM_CH_COUNT
+} alarm_channel;
+
+typedef enum {
+    ALARM_OK,
+    ALARM_WARN,
+    ALARM_CRIT
+} alarm_level;
+
+typedef struct {
+    bool enabled;
+    float warn;             // Level rises to WARN at or above this value
+    float crit;             // Level rises to CRIT at or above this value
+    float hysteresis;       // Must drop this far below a threshold to clear it
+    uint32_t hold_ms;       // A new level must persist this long before it is taken
+} alarm_config;
+
+/**
+ * Set up the LED (and buzzer, if BUZZER_PIN is defined) and start the
+ * pattern timer
+ *
+ * @param led_pin GPIO driving the status LED
+ */
+void alarm_init(unsigned int led_pin);
+
+void alarm_configure(alarm_channel ch, const alarm_config *cfg);
+
+/**
+ * Feed a new reading for one channel
+ *
+ * @return The channel's alarm level after this sample
+ */
+alarm_level alarm_update(alarm_channel ch, float value, uint32_t now_ms);
+
+/**
+ * Feed the values a combined sample shows
+ *
+ * Channels the sample has no reading for are left as they are.
+ */
+void alarm_update_sample(const sensor_sample *sample, uint32_t now_ms);
+
+alarm_level alarm_channel_level(alarm_channel ch);
+
+// Highest level over all channels
+alarm_level alarm_overall_level(void);
+
+// Short LED pulse to acknowledge a reading, without blocking
+void alarm_blip(void);
+
+const char *alarm_level_name(alarm_level level);
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * Bosch BME280 temperature, humidity and pressure sensor
+ *
+ * Forced mode with 1x oversampling on every channel: each measurement
+ * triggers one conversion, waits for the measuring bit to clear, fetches
+ * the raw values in one burst and compensates them with the integer
+ * formulas from the datasheet (section 4.2.3).
+ */
+
+#include "pico/stdlib.h"
+#include "envsensor.h"
+
+#define BME280_PERIOD_MS 2000
+
+#define BME280_REG_CALIB_TP 0x88    // 26 bytes, 0x88..0xA1
+#define BME280_REG_ID 0xD0
+#define BME280_REG_RESET 0xE0
+#define BME280_REG_CALIB_H 0xE1     // 7 bytes, 0xE1..0xE7
+#define BME280_REG_CTRL_HUM 0xF2
+#define BME280_REG_STATUS 0xF3
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_DATA 0xF7        // 8 bytes: pressure, temperature, humidity
+
+#define BME280_CHIP_ID 0x60
+#define BME280_RESET_WORD 0xB6
+#define BME280_STATUS_MEASURING 0x08
+#define BME280_STATUS_IM_UPDATE 0x01
+
+#define BME280_OSRS_H_X1 0x01
+#define BME280_CTRL_MEAS_FORCED 0x25    // Temperature x1, pressure x1, forced mode
+
+#define BME280_MEASURE_MS 10        // 9.3 ms max at these settings
+#define BME280_RETRY_MS 2
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static bool bme280_probe(env_sensor *s) {
+    uint8_t id;
+    if (!env_read_reg(s, BME280_REG_ID, &id, 1) || id != BME280_CHIP_ID) {
+        return false;
+    }
+
+    // Reset, then wait for the trimming parameters to be copied in
+    if (!env_write_reg(s, BME280_REG_RESET, BME280_RESET_WORD)) {
+        return false;
+    }
+    uint8_t status = BME280_STATUS_IM_UPDATE;
+    for (int i = 0; i < 10 && (status & BME280_STATUS_IM_UPDATE); i++) {
+        sleep_ms(1);
+        if (!env_read_reg(s, BME280_REG_STATUS, &status, 1)) {
+            return false;
+        }
+    }
+
+    uint8_t tp[26], h[7];
+    if (!env_read_reg(s, BME280_REG_CALIB_TP, tp, sizeof(tp)) ||
+        !env_read_reg(s, BME280_REG_CALIB_H, h, sizeof(h))) {
+        return false;
+    }
+
+    bme280_calib *c = &s->bme280;
+    c->t1 = get_u16(&tp[0]);
+    c->t2 = (int16_t)get_u16(&tp[2]);
+    c->t3 = (int16_t)get_u16(&tp[4]);
+    c->p1 = get_u16(&tp[6]);
+    c->p2 = (int16_t)get_u16(&tp[8]);
+    c->p3 = (int16_t)get_u16(&tp[10]);
+    c->p4 = (int16_t)get_u16(&tp[12]);
+    c->p5 = (int16_t)get_u16(&tp[14]);
+    c->p6 = (int16_t)get_u16(&tp[16]);
+    c->p7 = (int16_t)get_u16(&tp[18]);
+    c->p8 = (int16_t)get_u16(&tp[20]);
+    c->p9 = (int16_t)get_u16(&tp[22]);
+    c->h1 = tp[25];
+    c->h2 = (int16_t)get_u16(&h[0]);
+    c->h3 = h[2];
+    c->h4 = (int16_t)((int8_t)h[3] * 16 | (h[4] & 0x0F));     // 12 bits, split across bytes
+    c->h5 = (int16_t)((int8_t)h[5] * 16 | h[4] >> 4);
+    c->h6 = (int8_t)h[6];
+    return true;
+}
+
+// Datasheet compensation; returns 1/100 C and sets t_fine for the others
+static int32_t compensate_temp(const bme280_calib *c, int32_t adc_t, int32_t *t_fine) {
+    int32_t var1 = (((adc_t >> 3) - ((int32_t)c->t1 * 2)) * c->t2) >> 11;
+    int32_t d = (adc_t >> 4) - c->t1;
+    int32_t var2 = (((d * d) >> 12) * c->t3) >> 14;
+    *t_fine = var1 + var2;
+    return (*t_fine * 5 + 128) >> 8;
+}
+
+// Pa in Q24.8, 0 if the calibration is unusable
+static uint32_t compensate_pressure(const bme280_calib *c, int32_t adc_p, int32_t t_fine) {
+    int64_t var1 = (int64_t)t_fine - 128000;
+    int64_t var2 = var1 * var1 * c->p6;
+    var2 += var1 * c->p5 * 131072;
+    var2 += (int64_t)c->p4 * 34359738368LL;
+    var1 = ((var1 * var1 * c->p3) >> 8) + var1 * c->p2 * 4096;
+    var1 = ((140737488355328LL + var1) * c->p1) >> 33;
+    if (var1 == 0) {
+        return 0;
+    }
+    int64_t p = 1048576 - adc_p;
+    p = ((p * 2147483648LL - var2) * 3125) / var1;
+    var1 = ((int64_t)c->p9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = ((int64_t)c->p8 * p) >> 19;
+    return (uint32_t)(((p + var1 + var2) >> 8) + (int64_t)c->p7 * 16);
+}
+
+// %RH in Q22.10
+static uint32_t compensate_humidity(const bme280_calib *c, int32_t adc_h, int32_t t_fine) {
+    int32_t v = t_fine - 76800;
+    v = ((((adc_h * 16384) - ((int32_t)c->h4 * 1048576) - (c->h5 * v)) + 16384) >> 15) *
+        (((((((v * c->h6) >> 10) * (((v * c->h3) >> 11) + 32768)) >> 10) + 2097152) *
+          c->h2 + 8192) >> 14);
+    v -= ((((v >> 15) * (v >> 15)) >> 7) * c->h1) >> 4;
+    if (v < 0) v = 0;
+    if (v > 419430400) v = 419430400;
+    return (uint32_t)(v >> 12);
+}
+
+static pt_status bme280_measure(env_sensor *s, env_reading *out) {
+    uint8_t status, d[8];
+
+    PT_BEGIN(&s->thread);
+    // ctrl_hum only takes effect with the following ctrl_meas write
+    if (!env_write_reg(s, BME280_REG_CTRL_HUM, BME280_OSRS_H_X1) ||
+        !env_write_reg(s, BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED)) {
+        PT_FAIL(&s->thread);
+    }
+    PT_SLEEP_MS(&s->thread, BME280_MEASURE_MS);
+    for (;;) {
+        if (!env_read_reg(s, BME280_REG_STATUS, &status, 1)) {
+            PT_FAIL(&s->thread);
+        }
+        if (!(status & BME280_STATUS_MEASURING)) break;
+        PT_SLEEP_MS(&s->thread, BME280_RETRY_MS);
+    }
+
+    if (!env_read_reg(s, BME280_REG_DATA, d, sizeof(d))) {
+        PT_FAIL(&s->thread);
+    }
+    int32_t adc_p = (int32_t)((uint32_t)d[0] << 12 | d[1] << 4 | d[2] >> 4);
+    int32_t adc_t = (int32_t)((uint32_t)d[3] << 12 | d[4] << 4 | d[5] >> 4);
+    int32_t adc_h = d[6] << 8 | d[7];
+
+    int32_t t_fine;
+    int32_t temp = compensate_temp(&s->bme280, adc_t, &t_fine);
+    uint32_t pressure = compensate_pressure(&s->bme280, adc_p, t_fine);
+    uint32_t humidity = compensate_humidity(&s->bme280, adc_h, t_fine);
+
+    out->value[ENV_TEMP] = (temp + (temp >= 0 ? 5 : -5)) / 10;
+    out->value[ENV_HUMIDITY] = (int32_t)((humidity * 10 + 512) >> 10);
+    out->value[ENV_PRESSURE] = (int32_t)((pressure + 128) >> 8);
+    out->valid = 1u << ENV_TEMP | 1u << ENV_HUMIDITY;
+    if (pressure != 0) {
+        out->valid |= 1u << ENV_PRESSURE;
+    }
+    PT_END(&s->thread);
+}
+
+const env_driver bme280_driver = {
+    .name = "BME280",
+    .addresses = {0x76, 0x77},
+    .provides = 1u << ENV_TEMP | 1u << ENV_HUMIDITY | 1u << ENV_PRESSURE,
+    .period_ms = BME280_PERIOD_MS,
+    .probe = bme280_probe,
+    .measure = bme280_measure
+};
@@ -0,0 +1,84 @@
+/**
+ * Boot timing and warm restart detection
+ *
+ * Watchdog scratch registers 0 and 1 survive soft and watchdog resets but
+ * are cleared on power-on and brown-out, which is exactly when the sensor
+ * heater has cooled down. Registers 4-7 are left to the SDK.
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/watchdog.h"
+#include "boot.h"
+
+#if LIB_PICO_STDIO_USB
+#include "pico/stdio_usb.h"
+#endif
+
+#define BOOT_SCRATCH_MAGIC 0
+#define BOOT_SCRATCH_POWERED_MS 1
+#define BOOT_MAGIC 0x454D4243  // "EMBC"
+
+typedef struct {
+    const char *name;
+    uint64_t end_us;
+} boot_phase;
+
+static boot_phase phases[BOOT_MAX_PHASES];
+static int phase_count = 0;
+static uint32_t warm_start_ms = 0;
+
+void boot_mark(const char *phase) {
+    if (phase_count < BOOT_MAX_PHASES) {
+        phases[phase_count].name = phase;
+        phases[phase_count].end_us = time_us_64();
+        phase_count++;
+    }
+}
+
+void boot_report(void) {
+    uint64_t start_us = 0;
+    printf("Boot phases:\n");
+    for (int i = 0; i < phase_count; i++) {
+        printf("  %-12s %6lu ms\n", phases[i].name,
+               (unsigned long)((phases[i].end_us - start_us) / 1000));
+        start_us = phases[i].end_us;
+    }
+    printf("  %-12s %6lu ms\n", "total", (unsigned long)(start_us / 1000));
+}
+
+bool boot_wait_for_usb(uint32_t timeout_ms) {
+#if LIB_PICO_STDIO_USB
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+    while (!stdio_usb_connected()) {
+        if (time_reached(deadline)) {
+            return false;
+        }
+        sleep_ms(10);
+    }
+    return true;
+#else
+    (void)timeout_ms;
+    return false;
+#endif
+}
+
+uint32_t boot_warm_start_ms(void) {
+    if (watchdog_hw->scratch[BOOT_SCRATCH_MAGIC] == BOOT_MAGIC) {
+        warm_start_ms = watchdog_hw->scratch[BOOT_SCRATCH_POWERED_MS];
+    } else {
+        warm_start_ms = 0;
+        watchdog_hw->scratch[BOOT_SCRATCH_MAGIC] = BOOT_MAGIC;
+    }
+    watchdog_hw->scratch[BOOT_SCRATCH_POWERED_MS] = warm_start_ms;
+    return warm_start_ms;
+}
+
+void boot_heartbeat(uint32_t now_ms) {
+    uint32_t powered_ms = warm_start_ms + now_ms;
+    // Saturate rather than wrap after ~49 days
+    if (powered_ms < warm_start_ms) {
+        powered_ms = UINT32_MAX;
+    }
+    watchdog_hw->scratch[BOOT_SCRATCH_POWERED_MS] = powered_ms;
+}
@@ -0,0 +1,41 @@
+/**
+ * Boot timing and warm restart detection
+ *
+ * Records how long each start-up phase takes, waits for the USB serial
+ * host only as long as needed, and remembers across soft and watchdog
+ * resets how long the MQ135 heater has already been powered.
+ */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BOOT_MAX_PHASES 8
+
+// Mark the end of a start-up phase
+void boot_mark(const char *phase);
+
+// Print the time taken by each phase since power-up
+void boot_report(void);
+
+/**
+ * Wait for a USB serial host to connect
+ *
+ * @return true if a host connected before the timeout
+ */
+bool boot_wait_for_usb(uint32_t timeout_ms);
+
+/**
+ * Check the watchdog scratch registers for state left by a previous run
+ *
+ * @return How long the sensors had already been powered when the previous
+ *         run stopped, or 0 after a power-on reset
+ */
+uint32_t boot_warm_start_ms(void);
+
+// Save the current powered time so a reset can pick it up; call regularly
+void boot_heartbeat(uint32_t now_ms);
+
+#endif
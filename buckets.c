@@ -0,0 +1,42 @@
+/**
+ * Ring of fixed-width time buckets
+ */
+
+#include "buckets.h"
+
+void bucket_ring_init(bucket_ring *r, uint32_t window_ms, uint8_t buckets) {
+    *r = (bucket_ring){.bucket_ms = window_ms / buckets, .buckets = buckets};
+}
+
+bool bucket_ring_keep(bucket_ring *r, uint32_t now_ms) {
+    if (r->started) {
+        uint32_t elapsed = now_ms - r->open_start_ms;
+        // A sample from before the open bucket counts there
+        if ((int32_t)elapsed < 0 || elapsed / r->bucket_ms <= r->buckets) {
+            return true;
+        }
+    }
+
+    // Not started, or everything has expired
+    r->open_start_ms = now_ms - now_ms % r->bucket_ms;
+    r->seq = 0;
+    r->closed = 0;
+    r->started = true;
+    return false;
+}
+
+bool bucket_ring_close(bucket_ring *r, uint32_t now_ms, uint32_t *seq, bool *evicted) {
+    uint32_t elapsed = now_ms - r->open_start_ms;
+    if ((int32_t)elapsed < 0 || elapsed < r->bucket_ms) {
+        return false;
+    }
+
+    *seq = r->seq;
+    *evicted = r->closed == r->buckets;
+    if (!*evicted) {
+        r->closed++;
+    }
+    r->seq++;
+    r->open_start_ms += r->bucket_ms;
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * Ring of fixed-width time buckets
+ *
+ * The stepping shared by the sliding windows in stats.h and trend.h. A
+ * window spans `buckets` closed buckets plus the one being filled; this
+ * keeps track of where the open bucket starts, its sequence number and
+ * how many closed buckets there are. The window keeps the bucket contents
+ * and its totals and updates them as each bucket closes.
+ */
+
+#ifndef BUCKETS_H
+#define BUCKETS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t bucket_ms;         // Width of one bucket
+    uint32_t open_start_ms;     // Start of the bucket being filled
+    uint32_t seq;               // Sequence number of the open bucket
+    uint8_t buckets;            // Closed buckets the window spans
+    uint8_t closed;             // Closed buckets in the ring
+    bool started;
+} bucket_ring;
+
+// Split window_ms into `buckets` buckets; nothing started yet
+void bucket_ring_init(bucket_ring *r, uint32_t window_ms, uint8_t buckets);
+
+/**
+ * Check that the ring still holds something as of now_ms
+ *
+ * @return false on the first call and once every bucket has expired; the
+ *         ring has then started afresh at the bucket containing now_ms and
+ *         the caller clears its contents
+ */
+bool bucket_ring_keep(bucket_ring *r, uint32_t now_ms);
+
+/**
+ * Close the open bucket if now_ms is past it
+ *
+ * Called until it returns false, after bucket_ring_keep(). On true the
+ * bucket with sequence number *seq has closed and goes into slot
+ * *seq % buckets, and r->seq and r->closed have moved on.
+ *
+ * @param evicted Set if that slot held the oldest bucket, which leaves
+ *                the window
+ */
+bool bucket_ring_close(bucket_ring *r, uint32_t now_ms, uint32_t *seq, bool *evicted);
+
+#endif
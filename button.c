@@ -0,0 +1,103 @@
+/**
+ * Debounced push button
+ */
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "button.h"
+
+#define BUTTON_QUEUE_SIZE 8     // Power of two
+
+static unsigned int button_pin;
+static bool pressed = false;            // Debounced state
+static alarm_id_t debounce_alarm = 0;
+static alarm_id_t long_alarm = 0;
+
+// Single producer (interrupts) single consumer (main loop) queue
+static volatile button_event queue[BUTTON_QUEUE_SIZE];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+
+// The interrupt and alarm callbacks below stay in flash: a cache miss is
+// nothing next to the debounce time, and the SDK alarm calls they make run
+// from flash anyway
+static void push_event(button_event event) {
+    uint8_t next = (queue_head + 1) & (BUTTON_QUEUE_SIZE - 1);
+    if (next == queue_tail) {
+        return;     // Full, drop the event
+    }
+    queue[queue_head] = event;
+    queue_head = next;
+
+    // Wake the main loop if it is waiting for an event
+    __sev();
+}
+
+static int64_t long_press_check(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    long_alarm = 0;
+    if (pressed) {
+        push_event(BUTTON_LONG);
+    }
+    return 0;
+}
+
+static int64_t debounce_check(alarm_id_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    debounce_alarm = 0;
+
+    bool level_pressed = !gpio_get(button_pin);
+    if (level_pressed == pressed) {
+        return 0;   // Bounce that settled back, nothing changed
+    }
+    pressed = level_pressed;
+
+    if (pressed) {
+        push_event(BUTTON_PRESS);
+        long_alarm = add_alarm_in_ms(BUTTON_LONG_PRESS_MS - BUTTON_DEBOUNCE_MS,
+                                     long_press_check, NULL, true);
+    } else if (long_alarm > 0) {
+        cancel_alarm(long_alarm);
+        long_alarm = 0;
+    }
+    return 0;
+}
+
+static void button_irq(unsigned int gpio, uint32_t events) {
+    (void)events;
+    if (gpio != button_pin) {
+        return;
+    }
+
+    // Every edge restarts the debounce window
+    if (debounce_alarm > 0) {
+        cancel_alarm(debounce_alarm);
+    }
+    debounce_alarm = add_alarm_in_ms(BUTTON_DEBOUNCE_MS, debounce_check, NULL, true);
+}
+
+void button_init(unsigned int pin) {
+    button_pin = pin;
+    gpio_init(button_pin);
+    gpio_set_dir(button_pin, GPIO_IN);
+    gpio_pull_up(button_pin);
+
+    gpio_set_irq_enabled_with_callback(button_pin, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
+                                       true, button_irq);
+}
+
+button_event button_poll(void) {
+    if (queue_tail == queue_head) {
+        return BUTTON_NONE;
+    }
+    button_event event = queue[queue_tail];
+    queue_tail = (queue_tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+    return event;
+}
+
+bool button_pending(void) {
+    return queue_tail != queue_head;
+}
@@ -0,0 +1,38 @@
+/**
+ * Debounced push button
+ *
+ * The button pulls its GPIO to ground (internal pull-up). Edges raise a
+ * GPIO interrupt, and the level is sampled again after BUTTON_DEBOUNCE_MS
+ * from a timer alarm, so contact bounce never reaches the application.
+ * A press is reported as soon as it is debounced, so the application can
+ * react within BUTTON_DEBOUNCE_MS. If the button is still held after
+ * BUTTON_LONG_PRESS_MS a long press follows.
+ *
+ * Events are queued from interrupt context and read with button_poll()
+ * from the main loop.
+ */
+
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BUTTON_DEBOUNCE_MS 20
+#define BUTTON_LONG_PRESS_MS 800
+
+typedef enum {
+    BUTTON_NONE,
+    BUTTON_PRESS,       // Button went down
+    BUTTON_LONG         // Still held after BUTTON_LONG_PRESS_MS
+} button_event;
+
+void button_init(unsigned int pin);
+
+// Next queued event, or BUTTON_NONE
+button_event button_poll(void);
+
+// True if an event is waiting, cheap enough to call while sleeping
+bool button_pending(void);
+
+#endif
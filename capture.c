@@ -0,0 +1,146 @@
+/**
+ * Raw acquisition capture
+ */
+
+#include <stdio.h>
+#include "crc32.h"
+#include "capture.h"
+
+// Largest record: DHT header + 40 timings + type + varint
+#define CAPTURE_MAX_RECORD 64
+
+typedef struct {
+    uint8_t data[CAPTURE_MAX_RECORD];
+    int len;
+} record_buf;
+
+static bool active = false;
+static uint32_t last_ms = 0;
+
+static void put_u8(record_buf *rec, uint8_t v) {
+    rec->data[rec->len++] = v;
+}
+
+static void put_u16(record_buf *rec, uint16_t v) {
+    put_u8(rec, v & 0xFF);
+    put_u8(rec, v >> 8);
+}
+
+static void put_u32(record_buf *rec, uint32_t v) {
+    put_u16(rec, v & 0xFFFF);
+    put_u16(rec, v >> 16);
+}
+
+static void begin(record_buf *rec, capture_record type, uint32_t now_ms) {
+    uint32_t dt = now_ms - last_ms;
+    last_ms = now_ms;
+
+    rec->len = 0;
+    put_u8(rec, type);
+    do {
+        put_u8(rec, (dt & 0x7F) | (dt > 0x7F ? 0x80 : 0));
+        dt >>= 7;
+    } while (dt);
+}
+
+static void emit(const record_buf *rec) {
+    static const char hex[] = "0123456789ABCDEF";
+    char line[3 + CAPTURE_MAX_RECORD * 2 + 2];
+    int pos = 0;
+
+    line[pos++] = '#';
+    line[pos++] = 'C';
+    line[pos++] = ' ';
+    for (int i = 0; i < rec->len; i++) {
+        line[pos++] = hex[rec->data[i] >> 4];
+        line[pos++] = hex[rec->data[i] & 0x0F];
+    }
+    line[pos++] = '\n';
+    line[pos] = '\0';
+    fputs(line, stdout);
+}
+
+void capture_start(uint32_t now_ms) {
+    record_buf rec;
+    active = true;
+    last_ms = now_ms;
+    begin(&rec, CAP_START, now_ms);
+    put_u8(&rec, CAPTURE_VERSION);
+    put_u32(&rec, now_ms);
+    emit(&rec);
+}
+
+void capture_stop(void) {
+    active = false;
+}
+
+bool capture_active(void) {
+    return active;
+}
+
+void capture_warmup(uint32_t now_ms, uint32_t start_ms, uint32_t warmup_ms) {
+    if (!active) return;
+
+    record_buf rec;
+    begin(&rec, CAP_WARMUP, now_ms);
+    put_u32(&rec, start_ms);
+    put_u32(&rec, warmup_ms);
+    emit(&rec);
+}
+
+void capture_dht(uint32_t now_ms, const dht_pulses *pulses) {
+    if (!active) return;
+
+    record_buf rec;
+    begin(&rec, CAP_DHT, now_ms);
+    put_u8(&rec, pulses->status);
+    put_u8(&rec, pulses->bits);
+    for (int i = 0; i < pulses->bits; i++) {
+        put_u8(&rec, pulses->high_us[i]);
+    }
+    emit(&rec);
+}
+
+void capture_adc(uint32_t now_ms, uint16_t code) {
+    if (!active) return;
+
+    record_buf rec;
+    begin(&rec, CAP_ADC, now_ms);
+    put_u16(&rec, code);
+    emit(&rec);
+}
+
+void capture_i2c(uint32_t now_ms, uint8_t address, bool ack) {
+    if (!active) return;
+
+    record_buf rec;
+    begin(&rec, CAP_I2C, now_ms);
+    put_u8(&rec, address);
+    put_u8(&rec, ack);
+    emit(&rec);
+}
+
+void capture_frame(uint32_t now_ms, uint8_t screen, const uint8_t *buffer, size_t len) {
+    if (!active) return;
+
+    record_buf rec;
+    begin(&rec, CAP_FRAME, now_ms);
+    put_u8(&rec, screen);
+    put_u32(&rec, crc32_update(0, buffer, len));
+    emit(&rec);
+}
+
+void capture_env(uint32_t now_ms, const env_reading *latest, uint8_t updated) {
+    if (!active) return;
+
+    record_buf rec;
+    begin(&rec, CAP_ENV, now_ms);
+    put_u8(&rec, updated);
+    put_u8(&rec, latest->valid);
+    for (int q = 0; q < ENV_QUANTITY_COUNT; q++) {
+        if (latest->valid & (1u << q)) {
+            put_u32(&rec, (uint32_t)latest->value[q]);
+        }
+    }
+    emit(&rec);
+}
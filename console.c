@@ -0,0 +1,58 @@
+/**
+ * Serial command console
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "console.h"
+
+static char line[CONSOLE_LINE_MAX];
+static int line_len = 0;
+static bool line_ready = false;
+static uint64_t line_time_us = 0;
+static volatile bool input_pending = false;
+
+// Called from the USB interrupt, kept in RAM
+static void __not_in_flash_func(chars_available)(void *param) {
+    (void)param;
+    input_pending = true;
+    __sev();
+}
+
+void console_init(void) {
+    stdio_set_chars_available_callback(chars_available, NULL);
+}
+
+bool console_pending(void) {
+    return input_pending;
+}
+
+uint64_t console_line_time_us(void) {
+    return line_time_us;
+}
+
+const char *console_poll(void) {
+    if (line_ready) {
+        line_ready = false;
+        line_len = 0;
+    }
+    input_pending = false;
+
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == '\r' || c == '\n') {
+            if (line_len == 0) continue;
+            line_time_us = time_us_64();
+            line[line_len] = '\0';
+            line_ready = true;
+            input_pending = true;   // More may be waiting behind this line
+            return line;
+        }
+        // Overlong lines are truncated
+        if (line_len < CONSOLE_LINE_MAX - 1) {
+            line[line_len++] = (char)c;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,34 @@
+/**
+ * Serial command console
+ *
+ * Collects characters from stdin without blocking and hands back
+ * complete lines. Incoming characters wake the main loop (see
+ * console_pending()), and each line is timestamped when its end arrives.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CONSOLE_LINE_MAX 64
+
+// Register for input notifications
+void console_init(void);
+
+// True if input arrived since the last console_poll(), cheap enough to call while sleeping
+bool console_pending(void);
+
+/**
+ * Read whatever input is pending
+ *
+ * @return A complete line without its line ending, or NULL if no line has
+ *         been completed yet. The string is valid until the next call.
+ */
+const char *console_poll(void);
+
+// time_us_64() when the end of the last returned line was read
+uint64_t console_line_time_us(void);
+
+#endif
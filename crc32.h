@@ -0,0 +1,14 @@
+/**
+ * CRC-32 (IEEE 802.3, as used by zlib and PNG)
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Continue a CRC over more data; start with crc = 0
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+#endif
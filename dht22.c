@@ -0,0 +1,224 @@
+/**
+ * DHT22 temperature and humidity sensor
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "dht22.h"
+
+// Per-phase timeouts: the nominal pulse length plus margin for jitter
+#define DHT_RESPONSE_WAIT_US 100    // Sensor pulls low 20-40us after release
+#define DHT_RESPONSE_LOW_US 110     // 80us response low
+#define DHT_RESPONSE_HIGH_US 110    // 80us response high
+#define DHT_BIT_LOW_US 80           // 50us low before each bit
+#define DHT_BIT_HIGH_US 100         // 26-28us for '0', 70us for '1'
+
+// Retries after a failed read, with the delay doubling each time
+#define DHT_MAX_RETRIES 3
+#define DHT_RETRY_BASE_MS 50
+
+// Open the circuit breaker after this many failed samples with no response
+#define DHT_BREAKER_THRESHOLD 2
+#define DHT_BREAKER_MIN_MS 10000
+#define DHT_BREAKER_MAX_MS 120000
+
+// High pulses longer than this are '1' bits (~26-28us for '0', ~70us for '1')
+#define DHT_ONE_THRESHOLD_US 40
+
+static unsigned int dht_pin;
+
+void dht22_init(unsigned int pin) {
+    dht_pin = pin;
+    gpio_init(dht_pin);
+    gpio_set_pulls(dht_pin, true, false);  // Enable pull-up
+}
+
+// Wait while the line is at `level` for at most timeout_us, returns false on timeout
+static bool __not_in_flash_func(wait_while)(bool level, uint32_t timeout_us) {
+    uint32_t start = time_us_32();
+    while (gpio_get(dht_pin) == level) {
+        if (time_us_32() - start > timeout_us) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs from RAM: an XIP cache miss in the edge loops would add
+// microseconds to the measured pulses
+bool __not_in_flash_func(dht22_capture)(dht_pulses *pulses) {
+    pulses->status = DHT22_OK;
+    pulses->bits = 0;
+
+    // Start signal: pull low for at least 1ms, then pull high
+    gpio_set_dir(dht_pin, GPIO_OUT);
+    gpio_put(dht_pin, 0);
+    sleep_ms(1);               // Pull low for 1ms
+
+    // Enable the internal pull-up
+    gpio_set_pulls(dht_pin, true, false);
+
+    // Release the line and switch to input
+    gpio_put(dht_pin, 1);
+    sleep_us(40);              // Wait for 40us
+    gpio_set_dir(dht_pin, GPIO_IN);
+
+    // Wait for DHT22 to pull low (response signal)
+    if (!wait_while(1, DHT_RESPONSE_WAIT_US)) {
+        pulses->status = DHT22_NO_RESPONSE;
+        return false;
+    }
+
+    // DHT22 pulls low for 80us, then high for 80us
+    if (!wait_while(0, DHT_RESPONSE_LOW_US)) {
+        pulses->status = DHT22_RESPONSE_LOW;
+        return false;
+    }
+    if (!wait_while(1, DHT_RESPONSE_HIGH_US)) {
+        pulses->status = DHT22_RESPONSE_HIGH;
+        return false;
+    }
+
+    // Read the 40 bits (5 bytes) of data
+    for (int i = 0; i < DHT22_BITS; i++) {
+        // Each bit starts with a 50us low pulse
+        if (!wait_while(0, DHT_BIT_LOW_US)) {
+            pulses->status = DHT22_BIT_LOW;
+            return false;
+        }
+
+        // Duration of high pulse determines bit value
+        uint32_t high_start = time_us_32();
+        if (!wait_while(1, DHT_BIT_HIGH_US)) {
+            pulses->status = DHT22_BIT_HIGH;
+            return false;
+        }
+        uint32_t high_duration = time_us_32() - high_start;
+
+        pulses->high_us[i] = high_duration > 255 ? 255 : (uint8_t)high_duration;
+        pulses->bits++;
+    }
+
+    return true;
+}
+
+dht_reading dht22_decode(const dht_pulses *pulses) {
+    dht_reading result = {0.0f, 0.0f, 0, 0, false};
+    uint8_t data[5] = {0, 0, 0, 0, 0};
+
+    if (pulses->status != DHT22_OK || pulses->bits != DHT22_BITS) {
+        result.error = true;
+        return result;
+    }
+
+    for (int i = 0; i < DHT22_BITS; i++) {
+        if (pulses->high_us[i] > DHT_ONE_THRESHOLD_US) {
+            data[i / 8] |= 0x80 >> (i % 8);
+        }
+    }
+
+    // Verify checksum (last byte should equal sum of first 4 bytes)
+    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) {
+        result.error = true;
+        return result;
+    }
+
+    // Convert the data to humidity and temperature values
+    result.humidity_x10 = (data[0] << 8) | data[1];
+
+    // Temperature might be negative
+    if (data[2] & 0x80) {
+        result.temp_x10 = -(((data[2] & 0x7F) << 8) | data[3]);
+    } else {
+        result.temp_x10 = (data[2] << 8) | data[3];
+    }
+
+    result.humidity = result.humidity_x10 / 10.0f;
+    result.temp = result.temp_x10 / 10.0f;
+
+    return result;
+}
+
+dht_reading read_dht22() {
+    dht_pulses pulses;
+    dht22_capture(&pulses);
+    return dht22_decode(&pulses);
+}
+
+void dht22_link_init(dht22_link *link) {
+    *link = (dht22_link){0};
+}
+
+dht22_outcome dht22_link_result(dht22_link *link, const dht_pulses *pulses,
+                                const dht_reading *reading, uint32_t *retry_ms) {
+    dht22_counters *c = &link->counters;
+    c->attempts++;
+    *retry_ms = 0;
+
+    if (!reading->error) {
+        c->good++;
+        link->retry = 0;
+        link->missing = 0;
+        link->breaker_ms = 0;
+        return DHT22_SAMPLE_OK;
+    }
+
+    if (pulses->status != DHT22_OK) {
+        c->timeouts[pulses->status]++;
+    } else {
+        c->checksum_errors++;
+    }
+
+    // A broken breaker probe goes straight back to waiting, for longer
+    if (link->breaker_ms > 0) {
+        link->breaker_ms *= 2;
+        if (link->breaker_ms > DHT_BREAKER_MAX_MS) link->breaker_ms = DHT_BREAKER_MAX_MS;
+        *retry_ms = link->breaker_ms;
+        return DHT22_SAMPLE_FAILED;
+    }
+
+    if (link->retry < DHT_MAX_RETRIES) {
+        *retry_ms = DHT_RETRY_BASE_MS << link->retry;
+        link->retry++;
+        c->retries[pulses->status]++;
+        return DHT22_SAMPLE_RETRY;
+    }
+
+    // Out of retries; a sensor that never answers trips the breaker
+    link->retry = 0;
+    if (pulses->status == DHT22_NO_RESPONSE) {
+        if (++link->missing >= DHT_BREAKER_THRESHOLD) {
+            link->breaker_ms = DHT_BREAKER_MIN_MS;
+            *retry_ms = link->breaker_ms;
+            c->breaker_trips++;
+        }
+    } else {
+        link->missing = 0;
+    }
+    return DHT22_SAMPLE_FAILED;
+}
+
+bool dht22_link_breaker_open(const dht22_link *link) {
+    return link->breaker_ms > 0;
+}
+
+const char *dht22_status_name(uint8_t status) {
+    static const char *const names[DHT22_STATUS_COUNT] = {
+        "ok", "no response", "response low", "response high", "bit low", "bit high"
+    };
+    return status < DHT22_STATUS_COUNT ? names[status] : "?";
+}
+
+void dht22_print_counters(const dht22_link *link) {
+    const dht22_counters *c = &link->counters;
+    printf("DHT22: %lu attempts, %lu good, %lu checksum errors, %lu breaker trips%s\n",
+           (unsigned long)c->attempts, (unsigned long)c->good,
+           (unsigned long)c->checksum_errors, (unsigned long)c->breaker_trips,
+           dht22_link_breaker_open(link) ? " (breaker open)" : "");
+    for (int i = DHT22_NO_RESPONSE; i < DHT22_STATUS_COUNT; i++) {
+        printf("  %-14s %lu timeouts, %lu retries\n", dht22_status_name(i),
+               (unsigned long)c->timeouts[i], (unsigned long)c->retries[i]);
+    }
+    printf("  %-14s %lu retries\n", "checksum", (unsigned long)c->retries[DHT22_OK]);
+}
@@ -0,0 +1,101 @@
+/**
+ * DHT22 temperature and humidity sensor
+ *
+ * Reading is split in two steps: capturing the raw pulse timings from the
+ * data line, and decoding them into a reading. Decoding is plain C so
+ * recorded pulses can be replayed on the host.
+ *
+ * Every wait on the data line has a timeout sized to the protocol phase,
+ * so a missing sensor costs well under a millisecond of busy-waiting.
+ * A dht22_link decides what to do with each result: retry soon with
+ * a doubling delay, report the failure, or stop polling a sensor that
+ * never answers (circuit breaker) and probe it at growing intervals.
+ */
+
+#ifndef DHT22_H
+#define DHT22_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DHT22_BITS 40
+
+// Outcome of a capture, or the phase in which the sensor stopped answering
+typedef enum {
+    DHT22_OK,
+    DHT22_NO_RESPONSE,      // Sensor never pulled the line low
+    DHT22_RESPONSE_LOW,     // 80us low response pulse did not end
+    DHT22_RESPONSE_HIGH,    // 80us high response pulse did not end
+    DHT22_BIT_LOW,          // 50us low pulse before a data bit did not end
+    DHT22_BIT_HIGH,         // Data bit high pulse did not end
+    DHT22_STATUS_COUNT
+} dht22_status;
+
+// Raw timings of one transfer
+typedef struct {
+    uint8_t status;                 // dht22_status
+    uint8_t bits;                   // Number of data bits captured
+    uint8_t high_us[DHT22_BITS];    // Length of each data bit's high pulse
+} dht_pulses;
+
+// DHT22 data structure
+typedef struct {
+    float humidity;
+    float temp;
+    uint16_t humidity_x10;  // Raw sensor value, tenths of a percent
+    int16_t temp_x10;       // Raw sensor value, tenths of a degree C
+    bool error;
+} dht_reading;
+
+// What to do after an attempt
+typedef enum {
+    DHT22_SAMPLE_OK,        // Reading is good
+    DHT22_SAMPLE_RETRY,     // Failed; keep the previous reading and retry after retry_ms
+    DHT22_SAMPLE_FAILED     // Retries used up or breaker open; report the error
+} dht22_outcome;
+
+// Failure counters, indexed by the phase (dht22_status) that timed out
+typedef struct {
+    uint32_t attempts;
+    uint32_t good;
+    uint32_t timeouts[DHT22_STATUS_COUNT];
+    uint32_t checksum_errors;
+    uint32_t retries[DHT22_STATUS_COUNT];   // Retries by cause, DHT22_OK for checksum
+    uint32_t breaker_trips;
+} dht22_counters;
+
+// Retry and circuit breaker state
+typedef struct {
+    dht22_counters counters;
+    uint8_t retry;          // Retries used for the current sample
+    uint8_t missing;        // Consecutive failed samples with no response
+    uint32_t breaker_ms;    // Probe interval while the breaker is open, 0 when closed
+} dht22_link;
+
+void dht22_init(unsigned int pin);
+
+// Run one transfer and record the pulse timings
+bool dht22_capture(dht_pulses *pulses);
+
+// Turn captured timings into a reading, checking the checksum
+dht_reading dht22_decode(const dht_pulses *pulses);
+
+// Capture and decode in one go
+dht_reading read_dht22();
+
+void dht22_link_init(dht22_link *link);
+
+/**
+ * Account for one attempt and decide what to do next
+ *
+ * @param retry_ms Set to the delay before the next attempt, or 0 to use
+ *                 the normal sampling period
+ */
+dht22_outcome dht22_link_result(dht22_link *link, const dht_pulses *pulses,
+                                const dht_reading *reading, uint32_t *retry_ms);
+
+bool dht22_link_breaker_open(const dht22_link *link);
+const char *dht22_status_name(uint8_t status);
+void dht22_print_counters(const dht22_link *link);
+
+#endif
@@ -0,0 +1,218 @@
+/**
+ * I2C environmental sensors
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "log.h"
+#include "envsensor.h"
+
+static const env_driver *const drivers[] = {
+    &sht4x_driver, &sht3x_driver, &bme280_driver, &scd4x_driver
+};
+
+static const char *const quantity_names[ENV_QUANTITY_COUNT] = {
+    "temperature", "humidity", "pressure", "CO2"
+};
+
+uint8_t env_crc8(const uint8_t *data, int len) {
+    // Sensirion CRC-8: polynomial 0x31, initial value 0xFF
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (uint8_t)(crc << 1) ^ 0x31 : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool env_write(env_sensor *s, const uint8_t *data, int len) {
+    return i2c_write_blocking(s->i2c, s->address, data, len, false) == len;
+}
+
+bool env_read(env_sensor *s, uint8_t *data, int len) {
+    return i2c_read_blocking(s->i2c, s->address, data, len, false) == len;
+}
+
+bool env_read_reg(env_sensor *s, uint8_t reg, uint8_t *data, int len) {
+    // Repeated start between the register address and the data
+    return i2c_write_blocking(s->i2c, s->address, &reg, 1, true) == 1 &&
+           i2c_read_blocking(s->i2c, s->address, data, len, false) == len;
+}
+
+bool env_write_reg(env_sensor *s, uint8_t reg, uint8_t value) {
+    uint8_t buf[2] = {reg, value};
+    return env_write(s, buf, 2);
+}
+
+bool env_command(env_sensor *s, uint16_t command) {
+    uint8_t buf[2] = {command >> 8, command & 0xFF};
+    return env_write(s, buf, 2);
+}
+
+bool env_read_words(env_sensor *s, uint16_t *words, int count) {
+    uint8_t buf[3 * 3];
+    if (count > 3 || !env_read(s, buf, 3 * count)) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (env_crc8(&buf[3 * i], 2) != buf[3 * i + 2]) {
+            return false;
+        }
+        words[i] = (uint16_t)(buf[3 * i] << 8 | buf[3 * i + 1]);
+    }
+    return true;
+}
+
+int env_bus_probe(env_bus *bus, i2c_inst_t *i2c, uint32_t now_ms) {
+    memset(bus, 0, sizeof(*bus));
+    for (int q = 0; q < ENV_QUANTITY_COUNT; q++) {
+        bus->source[q] = -1;
+    }
+
+    for (size_t d = 0; d < sizeof(drivers) / sizeof(drivers[0]); d++) {
+        for (int a = 0; a < 2 && drivers[d]->addresses[a] != 0; a++) {
+            uint8_t address = drivers[d]->addresses[a];
+
+            // An address already claimed belongs to a higher priority driver
+            bool taken = false;
+            for (int i = 0; i < bus->count; i++) {
+                if (bus->sensors[i].address == address) taken = true;
+            }
+            if (taken || bus->count == ENV_MAX_SENSORS) continue;
+
+            env_sensor *s = &bus->sensors[bus->count];
+            memset(s, 0, sizeof(*s));
+            s->driver = drivers[d];
+            s->i2c = i2c;
+            s->address = address;
+            if (!s->driver->probe(s)) continue;
+
+            s->deadline_ms = now_ms;
+            bus->count++;
+            LOG_INFO("%s found at 0x%02X", s->driver->name, address);
+        }
+    }
+    return bus->count;
+}
+
+// Whether a sensor's last reading is recent enough to be used
+static bool fresh(const env_sensor *s, uint32_t now_ms) {
+    return s->reads > 0 && now_ms - s->read_ms <= ENV_STALE_PERIODS * s->driver->period_ms;
+}
+
+// Hand the quantities a sensor supplies to the highest priority sensor
+// with a fresh reading of them, or mark them invalid
+static uint8_t release(env_bus *bus, int index, uint32_t now_ms) {
+    uint8_t updated = 0;
+    for (int q = 0; q < ENV_QUANTITY_COUNT; q++) {
+        if (bus->source[q] != index) continue;
+        bus->source[q] = -1;
+        bus->latest.valid &= ~(1u << q);
+        for (int i = 0; i < bus->count; i++) {
+            const env_sensor *other = &bus->sensors[i];
+            if (i != index && (other->last.valid & (1u << q)) && fresh(other, now_ms)) {
+                bus->latest.value[q] = other->last.value[q];
+                bus->latest.valid |= 1u << q;
+                bus->source[q] = (int8_t)i;
+                break;
+            }
+        }
+        updated |= 1u << q;
+    }
+    return updated;
+}
+
+// Take over the quantities this sensor has priority for
+static uint8_t merge(env_bus *bus, int index, const env_reading *r) {
+    uint8_t updated = 0;
+    for (int q = 0; q < ENV_QUANTITY_COUNT; q++) {
+        if (!(r->valid & (1u << q))) continue;
+        if (bus->source[q] >= 0 && bus->source[q] < index) continue;
+        bus->latest.value[q] = r->value[q];
+        bus->latest.valid |= 1u << q;
+        bus->source[q] = (int8_t)index;
+        updated |= 1u << q;
+    }
+    return updated;
+}
+
+static uint8_t failed(env_bus *bus, int index, uint32_t now_ms) {
+    env_sensor *s = &bus->sensors[index];
+    s->errors++;
+    s->measuring = false;
+    s->deadline_ms = now_ms + ENV_RETRY_MS;
+    s->last.valid = 0;
+    return release(bus, index, now_ms);
+}
+
+uint8_t env_bus_poll(env_bus *bus, uint32_t now_ms) {
+    uint8_t updated = 0;
+
+    for (int i = 0; i < bus->count; i++) {
+        env_sensor *s = &bus->sensors[i];
+        const env_driver *drv = s->driver;
+
+        // One that stopped delivering without failing (stuck in a wait)
+        if (s->last.valid != 0 && !fresh(s, now_ms)) {
+            s->last.valid = 0;
+            updated |= release(bus, i, now_ms);
+        }
+
+        if (s->measuring ? !pt_due(&s->thread, now_ms)
+                         : (int32_t)(now_ms - s->deadline_ms) < 0) {
+            continue;
+        }
+        if (!s->measuring) {
+            PT_INIT(&s->thread);
+            s->measuring = true;
+            s->started_ms = now_ms;
+        }
+
+        env_reading r = {0};
+        s->thread.now_ms = now_ms;
+        pt_status status = drv->measure(s, &r);
+        if (status == PT_WAITING) {
+            s->deadline_ms = s->thread.wake_ms;
+            continue;
+        }
+        if (status == PT_FAILED) {
+            updated |= failed(bus, i, now_ms);
+            continue;
+        }
+
+        s->reads++;
+        s->read_ms = now_ms;
+        s->last = r;
+        updated |= merge(bus, i, &r);
+        s->measuring = false;
+        s->deadline_ms = s->started_ms + drv->period_ms;
+        if ((int32_t)(now_ms - s->deadline_ms) >= 0) {
+            s->deadline_ms = now_ms + 1;    // Overran its period, do not spin
+        }
+        LOG_DEBUG("%s: T %ld H %ld P %ld CO2 %ld", drv->name,
+                  (long)r.value[ENV_TEMP], (long)r.value[ENV_HUMIDITY],
+                  (long)r.value[ENV_PRESSURE], (long)r.value[ENV_CO2]);
+    }
+    return updated;
+}
+
+bool env_bus_next_deadline(const env_bus *bus, uint32_t *deadline_ms) {
+    if (bus->count == 0) {
+        return false;
+    }
+    uint32_t next = bus->sensors[0].deadline_ms;
+    for (int i = 1; i < bus->count; i++) {
+        if ((int32_t)(bus->sensors[i].deadline_ms - next) < 0) {
+            next = bus->sensors[i].deadline_ms;
+        }
+    }
+    *deadline_ms = next;
+    return true;
+}
+
+const char *env_quantity_name(env_quantity q) {
+    return q < ENV_QUANTITY_COUNT ? quantity_names[q] : "?";
+}
@@ -0,0 +1,152 @@
+/**
+ * I2C environmental sensors
+ *
+ * Drivers for digital sensors sharing the OLED's I2C bus:
+ *
+ *   - SHT4x / SHT3x   temperature and humidity (0x44, 0x45)
+ *   - BME280          temperature, humidity and pressure (0x76, 0x77)
+ *   - SCD4x           NDIR CO2, temperature and humidity (0x62)
+ *
+ * Every driver has two functions. probe() runs once at startup and may
+ * block briefly. measure() is a protothread (pt.h) that takes one
+ * measurement from start to finish, written as a plain sequence of
+ * commands and waits; every wait returns to the caller instead of
+ * sleeping.
+ *
+ * env_bus_poll() runs every sensor whose thread is due, so long
+ * conversions (5 s for the SCD4x) overlap with the short ones instead of
+ * queueing behind them. The main loop sleeps until env_bus_next_deadline().
+ *
+ * Temperature and humidity are in tenths (as from the DHT22), pressure in
+ * Pa and CO2 in ppm.
+ */
+
+#ifndef ENVSENSOR_H
+#define ENVSENSOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+#include "pt.h"
+
+#define ENV_MAX_SENSORS 4
+
+// Retry delay after a failed measurement
+#define ENV_RETRY_MS 5000
+
+// A sensor that has not delivered for this many periods gives up the
+// quantities it supplies
+#define ENV_STALE_PERIODS 3
+
+typedef enum {
+    ENV_TEMP,           // Tenths of a degree C
+    ENV_HUMIDITY,       // Tenths of a percent
+    ENV_PRESSURE,       // Pa
+    ENV_CO2,            // ppm
+    ENV_QUANTITY_COUNT
+} env_quantity;
+
+typedef struct {
+    int32_t value[ENV_QUANTITY_COUNT];
+    uint8_t valid;      // Bit per env_quantity
+} env_reading;
+
+// Trimming parameters read from the BME280 at probe time
+typedef struct {
+    uint16_t t1;
+    int16_t t2, t3;
+    uint16_t p1;
+    int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+    uint8_t h1, h3;
+    int16_t h2, h4, h5;
+    int8_t h6;
+} bme280_calib;
+
+typedef struct env_sensor env_sensor;
+
+typedef struct {
+    const char *name;
+    uint8_t addresses[2];   // Candidates in probe order, 0 if unused
+    uint8_t provides;       // Bit per env_quantity
+    uint32_t period_ms;     // Time between measurement starts
+
+    // Check the device at s->address is this sensor and set it up
+    bool (*probe)(env_sensor *s);
+
+    // Thread taking one measurement in s->thread; fills out before it
+    // exits, PT_FAILED on a bus or sensor error
+    pt_status (*measure)(env_sensor *s, env_reading *out);
+} env_driver;
+
+struct env_sensor {
+    const env_driver *driver;
+    i2c_inst_t *i2c;
+    uint8_t address;
+    bool measuring;         // thread is running
+    pt thread;
+    uint32_t deadline_ms;   // When the sensor needs attention next
+    uint32_t started_ms;    // Start of the current or last measurement
+    uint32_t read_ms;       // End of the last good measurement
+    uint32_t reads;
+    uint32_t errors;
+    env_reading last;
+    union {
+        bme280_calib bme280;
+        struct {
+            bool running;       // Periodic measurement started
+            bool identified;    // Serial number read after the first stop
+        } scd4x;
+    };
+};
+
+typedef struct {
+    env_sensor sensors[ENV_MAX_SENSORS];
+    int count;
+    // Merged from all sensors: each quantity from the highest priority
+    // sensor that is delivering it. A sensor that fails or goes stale
+    // hands its quantities to the next one with a fresh reading, or they
+    // become invalid.
+    env_reading latest;
+    int8_t source[ENV_QUANTITY_COUNT];  // Sensor each latest value came from, -1 if none
+} env_bus;
+
+// Drivers in probe order, which is also their priority for shared quantities
+extern const env_driver sht4x_driver;
+extern const env_driver sht3x_driver;
+extern const env_driver bme280_driver;
+extern const env_driver scd4x_driver;
+
+/**
+ * Find the supported sensors on a bus
+ *
+ * @return Number of sensors found
+ */
+int env_bus_probe(env_bus *bus, i2c_inst_t *i2c, uint32_t now_ms);
+
+/**
+ * Run every sensor that is due
+ *
+ * @return Bits of the quantities in bus->latest that were updated or
+ *         became invalid
+ */
+uint8_t env_bus_poll(env_bus *bus, uint32_t now_ms);
+
+// Earliest time a sensor needs attention; false if there are no sensors
+bool env_bus_next_deadline(const env_bus *bus, uint32_t *deadline_ms);
+
+const char *env_quantity_name(env_quantity q);
+
+// Helpers for the drivers
+uint8_t env_crc8(const uint8_t *data, int len);
+bool env_write(env_sensor *s, const uint8_t *data, int len);
+bool env_read(env_sensor *s, uint8_t *data, int len);
+bool env_read_reg(env_sensor *s, uint8_t reg, uint8_t *data, int len);
+bool env_write_reg(env_sensor *s, uint8_t reg, uint8_t value);
+
+// Send a 16-bit Sensirion command
+bool env_command(env_sensor *s, uint16_t command);
+
+// Read CRC-checked Sensirion words (2 bytes + CRC each)
+bool env_read_words(env_sensor *s, uint16_t *words, int count);
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * Publish/subscribe bus for sensor samples
+ */
+
+#include <string.h>
+#include "evbus.h"
+
+void evbus_init(evbus *bus) {
+    memset(bus, 0, sizeof(*bus));
+    // Odd stamps: no slot holds an event yet
+    for (int i = 0; i < EVBUS_SLOTS; i++) {
+        bus->slots[i].stamp = 1;
+    }
+    bus->lock = spin_lock_instance(spin_lock_claim_unused(true));
+}
+
+void evbus_publish(evbus *bus, const evbus_event *event) {
+    uint32_t irq = spin_lock_blocking(bus->lock);
+    uint32_t seq = bus->head;
+    evbus_slot *slot = &bus->slots[seq % EVBUS_SLOTS];
+
+    slot->stamp = seq * 2 + 1;
+    __dmb();
+    slot->event = *event;
+    __dmb();
+    slot->stamp = seq * 2;
+    __dmb();
+    bus->head = seq + 1;
+
+    spin_unlock(bus->lock, irq);
+}
+
+void evbus_subscribe(evbus *bus, evbus_sub *sub, uint32_t types) {
+    memset(sub, 0, sizeof(*sub));
+    sub->bus = bus;
+    sub->types = types;
+    sub->cursor = bus->head;
+}
+
+const evbus_event *evbus_peek(evbus_sub *sub) {
+    evbus *bus = sub->bus;
+
+    for (;;) {
+        uint32_t head = bus->head;
+        __dmb();
+        if (sub->cursor == head) {
+            return NULL;
+        }
+
+        // Lapped: skip to the oldest event still in the ring
+        if (head - sub->cursor > EVBUS_SLOTS) {
+            sub->dropped += head - sub->cursor - EVBUS_SLOTS;
+            sub->cursor = head - EVBUS_SLOTS;
+        }
+
+        evbus_slot *slot = &bus->slots[sub->cursor % EVBUS_SLOTS];
+        uint32_t stamp = slot->stamp;
+        __dmb();
+        if (stamp != sub->cursor * 2) {
+            // Being overwritten by a newer event
+            sub->dropped++;
+            sub->cursor++;
+            continue;
+        }
+        if (sub->types & EVBUS_MASK(slot->event.type)) {
+            return &slot->event;
+        }
+        sub->cursor++;
+    }
+}
+
+bool evbus_release(evbus_sub *sub) {
+    evbus_slot *slot = &sub->bus->slots[sub->cursor % EVBUS_SLOTS];
+    __dmb();
+    bool intact = slot->stamp == sub->cursor * 2;
+    sub->cursor++;
+    if (intact) {
+        sub->received++;
+    } else {
+        sub->dropped++;
+    }
+    return intact;
+}
@@ -0,0 +1,118 @@
+/**
+ * Publish/subscribe bus for sensor samples
+ *
+ * Acquisition publishes each sample once; any number of consumers
+ * (alarms, display, history, telemetry, ...) read it from the bus instead
+ * of being called from the acquisition code. Raw readings go out as
+ * EVBUS_DHT, EVBUS_CO2 and EVBUS_ENV; after a pass that took a reading,
+ * EVBUS_SAMPLE carries the combined values as shown.
+ *
+ * The bus is a ring of EVBUS_SLOTS preallocated slots. Every published
+ * event gets the next sequence number and goes into slot seq % EVBUS_SLOTS,
+ * overwriting the oldest event. Publishers never wait for subscribers:
+ *
+ *   - each slot is a seqlock: its stamp is odd while the event is being
+ *     written and holds the event's sequence number once it is complete
+ *   - publishers serialise on a hardware spinlock, which also keeps
+ *     interrupts off on the publishing core for the few dozen cycles of
+ *     the copy, so acquisition can publish from an interrupt handler or
+ *     the other core
+ *   - each subscriber has its own cursor; one that falls more than
+ *     EVBUS_SLOTS events behind skips to the oldest event still in the
+ *     ring and counts the ones it missed
+ *
+ * Subscribers read events in place: evbus_peek() returns a pointer into
+ * the slot and evbus_release() checks the stamp again, reporting whether
+ * the event was overwritten while it was being read. A consumer that
+ * changes its own state from an event copies the fields it needs first
+ * and only uses them if the release succeeds. A subscriber must only be used from one
+ * context.
+ */
+
+#ifndef EVBUS_H
+#define EVBUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/sync.h"
+#include "dht22.h"
+#include "envsensor.h"
+#include "sensors.h"
+
+// Power of two
+#define EVBUS_SLOTS 16
+
+typedef enum {
+    EVBUS_DHT,          // Good or failed DHT22 reading
+    EVBUS_CO2,          // MQ135 estimate
+    EVBUS_ENV,          // Merged readings of the I2C sensors
+    EVBUS_SAMPLE,       // Combined values after a pass that took a reading
+    EVBUS_TYPE_COUNT
+} evbus_type;
+
+#define EVBUS_MASK(type) (1u << (type))
+#define EVBUS_ALL ((1u << EVBUS_TYPE_COUNT) - 1)
+
+typedef struct {
+    evbus_type type;
+    uint32_t t_ms;          // Time the sample was taken
+    uint64_t t_us;
+    union {
+        dht_reading dht;
+        struct {
+            float ppm;
+            uint16_t adc_raw;
+        } co2;
+        struct {
+            env_reading reading;
+            uint8_t updated;    // Quantities that changed
+        } env;
+        sensor_sample sample;
+    };
+} evbus_event;
+
+typedef struct {
+    volatile uint32_t stamp;    // 2 * seq when complete, odd while being written
+    evbus_event event;
+} evbus_slot;
+
+typedef struct {
+    evbus_slot slots[EVBUS_SLOTS];
+    volatile uint32_t head;     // Sequence number of the next event
+    spin_lock_t *lock;
+} evbus;
+
+typedef struct {
+    evbus *bus;
+    uint32_t cursor;            // Sequence number of the next event to read
+    uint32_t types;             // EVBUS_MASK() of the types wanted
+    uint32_t dropped;           // Overwritten before they were read
+    uint32_t received;
+} evbus_sub;
+
+// Claims a hardware spinlock
+void evbus_init(evbus *bus);
+
+// Copy an event into the next slot; never blocks on subscribers
+void evbus_publish(evbus *bus, const evbus_event *event);
+
+// Start receiving events published from now on
+void evbus_subscribe(evbus *bus, evbus_sub *sub, uint32_t types);
+
+/**
+ * Next event of a wanted type, in place
+ *
+ * @return NULL if there is none; otherwise the event, valid until
+ *         evbus_release() (which must be called before the next peek)
+ */
+const evbus_event *evbus_peek(evbus_sub *sub);
+
+/**
+ * Finish with the event from evbus_peek() and move past it
+ *
+ * @return false if the event was overwritten while it was read, in which
+ *         case whatever was read from it must be discarded
+ */
+bool evbus_release(evbus_sub *sub);
+
+#endif
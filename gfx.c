@@ -0,0 +1,112 @@
+/**
+ * 2D drawing primitives for the SSD1306 framebuffer
+ */
+
+#include <stdint.h>
+#include "pico/platform.h"
+#include "gfx.h"
+
+// Word access into the byte framebuffer
+typedef uint32_t __attribute__((may_alias)) gfx_word;
+
+static inline uint8_t apply_byte(uint8_t dst, uint8_t bits, gfx_op op) {
+    if (op == GFX_SET) return dst | bits;
+    if (op == GFX_CLEAR) return dst & ~bits;
+    return dst ^ bits;
+}
+
+// Apply one mask to a run of column bytes in a page
+static void apply_run(uint8_t *p, int n, uint8_t mask, gfx_op op) {
+    // Bytes up to the first word boundary
+    while (n > 0 && ((uintptr_t)p & 3) != 0) {
+        *p = apply_byte(*p, mask, op);
+        p++;
+        n--;
+    }
+
+    // Four columns at a time
+    uint32_t mask32 = mask * 0x01010101u;
+    gfx_word *word = (gfx_word *)p;
+    if (op == GFX_SET) {
+        for (; n >= 4; n -= 4) *word++ |= mask32;
+    } else if (op == GFX_CLEAR) {
+        for (; n >= 4; n -= 4) *word++ &= ~mask32;
+    } else {
+        for (; n >= 4; n -= 4) *word++ ^= mask32;
+    }
+
+    p = (uint8_t *)word;
+    while (n-- > 0) {
+        *p = apply_byte(*p, mask, op);
+        p++;
+    }
+}
+
+void gfx_fill_rect(ssd1306_t *disp, int x, int y, int w, int h, gfx_op op) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > disp->width) w = disp->width - x;
+    if (y + h > disp->height) h = disp->height - y;
+    if (w <= 0 || h <= 0) return;
+
+    int first = y / 8, last = (y + h - 1) / 8;
+    for (int page = first; page <= last; page++) {
+        // Rows of this page inside the rectangle
+        int top = page == first ? y % 8 : 0;
+        int bottom = page == last ? (y + h - 1) % 8 + 1 : 8;
+        uint8_t mask = (uint8_t)((0xFF << top) & (0xFF >> (8 - bottom)));
+        apply_run(&disp->buffer[page * disp->width + x], w, mask, op);
+    }
+    ssd1306_mark_dirty(disp, x, y, w, h);
+}
+
+void gfx_hline(ssd1306_t *disp, int x, int y, int w, gfx_op op) {
+    gfx_fill_rect(disp, x, y, w, 1, op);
+}
+
+void gfx_vline(ssd1306_t *disp, int x, int y, int h, gfx_op op) {
+    gfx_fill_rect(disp, x, y, 1, h, op);
+}
+
+void gfx_rect(ssd1306_t *disp, int x, int y, int w, int h, gfx_op op) {
+    if (w <= 0 || h <= 0) return;
+
+    // Edges do not overlap, so inverting toggles each pixel once
+    gfx_hline(disp, x, y, w, op);
+    if (h > 1) gfx_hline(disp, x, y + h - 1, w, op);
+    if (h > 2) {
+        gfx_vline(disp, x, y + 1, h - 2, op);
+        if (w > 1) gfx_vline(disp, x + w - 1, y + 1, h - 2, op);
+    }
+}
+
+void __not_in_flash_func(gfx_blit)(ssd1306_t *disp, int x, int y, const uint8_t *bitmap, int w, int h, gfx_op op) {
+    // Columns of the bitmap on the panel
+    int c0 = x < 0 ? -x : 0;
+    int c1 = x + w > disp->width ? disp->width - x : w;
+    if (c0 >= c1 || h <= 0) return;
+
+    int src_pages = (h + 7) / 8;
+    for (int sp = 0; sp < src_pages; sp++) {
+        int top = y + sp * 8;
+        int dp = top >= 0 ? top / 8 : -((7 - top) / 8);    // Floor
+        int shift = top - dp * 8;
+        uint8_t keep = (sp + 1) * 8 > h ? 0xFF >> ((sp + 1) * 8 - h) : 0xFF;
+
+        const uint8_t *src = &bitmap[sp * w + c0];
+        int n = c1 - c0;
+        if (dp >= 0 && dp < disp->pages) {
+            uint8_t *dst = &disp->buffer[dp * disp->width + x + c0];
+            for (int i = 0; i < n; i++) {
+                dst[i] = apply_byte(dst[i], (uint8_t)((src[i] & keep) << shift), op);
+            }
+        }
+        if (shift != 0 && dp + 1 >= 0 && dp + 1 < disp->pages) {
+            uint8_t *dst = &disp->buffer[(dp + 1) * disp->width + x + c0];
+            for (int i = 0; i < n; i++) {
+                dst[i] = apply_byte(dst[i], (uint8_t)((src[i] & keep) >> (8 - shift)), op);
+            }
+        }
+    }
+    ssd1306_mark_dirty(disp, x, y, w, h);
+}
@@ -0,0 +1,45 @@
+/**
+ * 2D drawing primitives for the SSD1306 framebuffer
+ *
+ * The framebuffer is page ordered: each byte is a column of 8 vertical
+ * pixels (LSB at the top), pages of `width` bytes one after another. The
+ * primitives work on that layout directly instead of pixel by pixel:
+ *
+ *   - a rectangle is one byte mask per page, applied to a run of columns;
+ *     whole runs are done 32 bits at a time once the pointer is aligned
+ *   - a bitmap in the same page layout is blitted a byte at a time,
+ *     shifted across the two pages it straddles
+ *
+ * Everything is clipped to the panel and marks the area it touches dirty.
+ */
+
+#ifndef GFX_H
+#define GFX_H
+
+#include <stdint.h>
+#include "ssd1306.h"
+
+typedef enum {
+    GFX_CLEAR,      // Pixels off
+    GFX_SET,        // Pixels on
+    GFX_INVERT      // Pixels toggled (XOR)
+} gfx_op;
+
+void gfx_fill_rect(ssd1306_t *disp, int x, int y, int w, int h, gfx_op op);
+
+// Outline only, one pixel wide
+void gfx_rect(ssd1306_t *disp, int x, int y, int w, int h, gfx_op op);
+
+void gfx_hline(ssd1306_t *disp, int x, int y, int w, gfx_op op);
+void gfx_vline(ssd1306_t *disp, int x, int y, int h, gfx_op op);
+
+/**
+ * Draw a 1-bpp bitmap with its top left corner at (x, y)
+ *
+ * The bitmap is in framebuffer layout: (h + 7) / 8 pages of w column
+ * bytes, LSB at the top. Set bits are applied with op; clear bits leave
+ * the framebuffer alone, and rows past h in the last page are ignored.
+ */
+void gfx_blit(ssd1306_t *disp, int x, int y, const uint8_t *bitmap, int w, int h, gfx_op op);
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * In-RAM sensor history
+ */
+
+#include "history.h"
+
+static tsenc_block blocks[HISTORY_BLOCKS];
+static tsenc_encoder encoder;
+static int head = 0;        // Block currently being filled
+static int used = 0;        // Blocks holding data, including head
+static uint32_t block_seq[HISTORY_BLOCKS];  // Sequence number of each block's first sample
+static uint32_t next_seq = 0;
+
+void history_init(void) {
+    head = 0;
+    used = 1;
+    next_seq = 0;
+    block_seq[head] = 0;
+    tsenc_encoder_init(&encoder, &blocks[head]);
+}
+
+void history_append(const tsenc_sample *s) {
+    if (tsenc_append(&encoder, s)) {
+        next_seq++;
+        return;
+    }
+
+    // Block full, move on and overwrite the oldest block if needed
+    head = (head + 1) % HISTORY_BLOCKS;
+    if (used < HISTORY_BLOCKS) {
+        used++;
+    }
+    block_seq[head] = next_seq;
+    tsenc_encoder_init(&encoder, &blocks[head]);
+    tsenc_append(&encoder, s);
+    next_seq++;
+}
+
+int history_block_count(void) {
+    return blocks[head].count > 0 ? used : used - 1;
+}
+
+// Ring position of block number index, oldest first
+static int block_slot(int index) {
+    int oldest = (head - used + 1 + HISTORY_BLOCKS) % HISTORY_BLOCKS;
+    return (oldest + index) % HISTORY_BLOCKS;
+}
+
+const tsenc_block *history_block(int index) {
+    return &blocks[block_slot(index)];
+}
+
+uint32_t history_first_seq(void) {
+    return history_block_count() > 0 ? block_seq[block_slot(0)] : next_seq;
+}
+
+uint32_t history_next_seq(void) {
+    return next_seq;
+}
+
+int history_read(uint32_t seq, tsenc_sample *out, int max, uint32_t *first_seq) {
+    int copied = 0;
+    *first_seq = next_seq;
+
+    for (int i = 0; i < history_block_count() && copied < max; i++) {
+        int slot = block_slot(i);
+        const tsenc_block *block = &blocks[slot];
+        uint32_t start = block_seq[slot];
+        if ((int32_t)(seq - (start + block->count)) >= 0) {
+            continue;       // Wanted samples come later
+        }
+
+        // Skip to seq within the first block used; later blocks from the start
+        uint32_t skip = copied == 0 && (int32_t)(seq - start) > 0 ? seq - start : 0;
+        if (copied == 0) {
+            *first_seq = start + skip;
+        }
+
+        tsenc_reader rd;
+        tsenc_sample s;
+        tsenc_reader_init(&rd, block);
+        for (uint32_t n = 0; copied < max && tsenc_read(&rd, &s); n++) {
+            if (n >= skip) {
+                out[copied++] = s;
+            }
+        }
+    }
+    return copied;
+}
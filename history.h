@@ -0,0 +1,44 @@
+/**
+ * In-RAM sensor history
+ *
+ * Keeps the most recent samples as a ring of compressed tsenc blocks.
+ * When the ring is full the oldest block is dropped.
+ *
+ * Every sample gets a sequence number, counting from 0 at boot, so a
+ * reader can ask for everything after the last sample it has.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tsenc.h"
+
+// 32 blocks of 128 bytes, roughly 2000+ samples at typical indoor variation
+#define HISTORY_BLOCKS 32
+
+void history_init(void);
+void history_append(const tsenc_sample *s);
+
+// Number of blocks holding data, oldest first for history_block()
+int history_block_count(void);
+const tsenc_block *history_block(int index);
+
+// Sequence number of the oldest sample held, history_next_seq() if none
+uint32_t history_first_seq(void);
+
+// Sequence number the next appended sample will get
+uint32_t history_next_seq(void);
+
+/**
+ * Copy samples in order, starting at sequence number seq
+ *
+ * Samples already dropped are skipped: *first_seq is set to the sequence
+ * number of out[0], which is later than seq if the ring has moved past it.
+ *
+ * @return Number of samples copied, at most max
+ */
+int history_read(uint32_t seq, tsenc_sample *out, int max, uint32_t *first_seq);
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * Incremental history sync over the serial console
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "pico/rand.h"
+#include "tusb.h"
+#include "crc32.h"
+#include "history.h"
+#include "histsync.h"
+
+#define FRAME_MAX (HISTSYNC_HEADER_BYTES + HISTSYNC_BATCH * HISTSYNC_SAMPLE_BYTES + 4)
+
+// Longest a pass keeps sending frames; the rest of the main loop runs in between
+#define PASS_BUDGET_US 5000
+
+typedef struct {
+    uint8_t data[FRAME_MAX];
+    int len;
+} frame_buf;
+
+static uint32_t boot_id = 0;
+static bool active = false;
+static bool started = false;    // START frame sent
+static uint32_t cursor = 0;     // Next sequence number to send
+
+static void put_u8(frame_buf *f, uint8_t v) {
+    f->data[f->len++] = v;
+}
+
+static void put_u16(frame_buf *f, uint16_t v) {
+    put_u8(f, v & 0xFF);
+    put_u8(f, v >> 8);
+}
+
+static void put_u32(frame_buf *f, uint32_t v) {
+    put_u16(f, v & 0xFFFF);
+    put_u16(f, v >> 16);
+}
+
+static void begin(frame_buf *f, histsync_frame type, uint8_t count, uint32_t seq) {
+    f->len = 0;
+    put_u8(f, '#');
+    put_u8(f, 'H');
+    put_u8(f, type);
+    put_u8(f, count);
+    put_u32(f, boot_id);
+    put_u32(f, seq);
+}
+
+static void emit(frame_buf *f) {
+    put_u32(f, crc32_update(0, &f->data[2], f->len - 2));
+
+    // Text before the frame goes out translated, the frame as it is
+    fflush(stdout);
+    stdio_set_translate_crlf(&stdio_usb, false);
+    fwrite(f->data, 1, f->len, stdout);
+    fflush(stdout);
+    stdio_set_translate_crlf(&stdio_usb, true);
+}
+
+void histsync_init(void) {
+    boot_id = get_rand_32();
+}
+
+bool histsync_request(const char *args) {
+    char *end;
+    uint32_t seq = strtoul(args, &end, 10);
+    if (end == args) {
+        return false;
+    }
+    const char *rest = end;
+    uint32_t their_boot = strtoul(rest, &end, 10);
+    if (end != rest && their_boot != boot_id) {
+        seq = history_first_seq();      // Asked about a previous boot
+    }
+
+    // Nothing before the oldest sample held or after the newest
+    uint32_t first = history_first_seq();
+    uint32_t next = history_next_seq();
+    if ((int32_t)(seq - first) < 0) seq = first;
+    if ((int32_t)(seq - next) > 0) seq = next;
+
+    cursor = seq;
+    active = true;
+    started = false;
+    return true;
+}
+
+bool histsync_active(void) {
+    return active;
+}
+
+// Send the frame that comes next; false once the END frame has gone out
+static bool send_next(void) {
+    static frame_buf frame;
+    static tsenc_sample samples[HISTSYNC_BATCH];
+
+    if (!started) {
+        begin(&frame, HISTSYNC_START, 0, cursor);
+        emit(&frame);
+        started = true;
+        return true;
+    }
+
+    uint32_t first;
+    int count = history_read(cursor, samples, HISTSYNC_BATCH, &first);
+
+    if (count == 0) {
+        begin(&frame, HISTSYNC_END, 0, history_next_seq());
+        emit(&frame);
+        return false;
+    }
+
+    begin(&frame, HISTSYNC_SAMPLES, (uint8_t)count, first);
+    for (int i = 0; i < count; i++) {
+        put_u32(&frame, samples[i].t_ms);
+        put_u16(&frame, (uint16_t)samples[i].temp_x10);
+        put_u16(&frame, samples[i].humidity_x10);
+        put_u16(&frame, samples[i].co2_ppm);
+    }
+    emit(&frame);
+    cursor = first + count;
+    return true;
+}
+
+void histsync_poll(void) {
+    if (!active) {
+        return;
+    }
+
+    // Keep the host's reads busy: frames go out back to back while it
+    // drains them, and the pass ends once the CDC buffer stays full (the
+    // host is not reading) or the budget is used up
+    uint64_t start_us = time_us_64();
+    while (tud_cdc_write_available() > 0) {
+        if (!send_next()) {
+            active = false;
+            break;
+        }
+        if (time_us_64() - start_us >= PASS_BUDGET_US) {
+            break;
+        }
+    }
+}
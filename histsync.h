@@ -0,0 +1,64 @@
+/**
+ * Incremental history sync over the serial console
+ *
+ * A host pulls the sample history (history.h) by sequence number instead
+ * of watching the live output, so nothing is lost while it is away:
+ *
+ *   hist <seq> [<boot_id>]
+ *
+ * asks for every stored sample from sequence number seq on. If boot_id is
+ * given and is not this boot's, the device has restarted since and the
+ * transfer starts from its oldest sample instead. The reply is a series
+ * of binary frames, sent back to back for a few milliseconds per main
+ * loop pass while the host keeps reading, with CRLF translation off while
+ * they are written:
+ *
+ *   '#' 'H'        marker
+ *   type (u8)      'S' start, 'D' samples or 'E' end
+ *   count (u8)     samples in the frame
+ *   boot_id (u32)  random, new on every boot
+ *   seq (u32)      S: first sequence number that will be sent, later
+ *                  than the one asked for if those samples were dropped
+ *                  D: sequence number of the first sample
+ *                  E: sequence number to ask for next time
+ *   samples        count x (t_ms u32, temp_x10 i16, humidity_x10 u16,
+ *                  co2_ppm u16)
+ *   crc32 (u32)    CRC-32 of everything from type to the last sample
+ *
+ * All little-endian. Text output can appear between frames; a host finds
+ * frames by the marker and the CRC. Sample frames follow on from each
+ * other, so a host that sees a gap (a frame lost, or samples dropped
+ * while the transfer was running) just asks again from where it is.
+ */
+
+#ifndef HISTSYNC_H
+#define HISTSYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Samples per frame, about 1 KB
+#define HISTSYNC_BATCH 100
+
+#define HISTSYNC_HEADER_BYTES 12
+#define HISTSYNC_SAMPLE_BYTES 10
+
+typedef enum {
+    HISTSYNC_START = 'S',
+    HISTSYNC_SAMPLES = 'D',
+    HISTSYNC_END = 'E'
+} histsync_frame;
+
+// Pick this boot's id
+void histsync_init(void);
+
+// Start a transfer for a "hist" command's arguments; false if malformed
+bool histsync_request(const char *args);
+
+// A transfer is in progress; the main loop should not sleep
+bool histsync_active(void);
+
+// Send the next frames of the transfer, if any
+void histsync_poll(void);
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * Tokenized logging
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include "log.h"
+
+static const char base64_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+typedef struct {
+    uint8_t data[LOG_PAYLOAD_MAX];
+    int len;
+} log_payload;
+
+static bool put_bytes(log_payload *p, const void *bytes, int n) {
+    if (p->len + n > LOG_PAYLOAD_MAX) {
+        return false;
+    }
+    memcpy(&p->data[p->len], bytes, n);
+    p->len += n;
+    return true;
+}
+
+// Zigzag varint, so small negative numbers stay short
+static bool put_varint(log_payload *p, int64_t value) {
+    uint64_t zz = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    uint8_t buf[10];
+    int n = 0;
+    do {
+        buf[n] = zz & 0x7F;
+        zz >>= 7;
+        if (zz != 0) buf[n] |= 0x80;
+        n++;
+    } while (zz != 0);
+    return put_bytes(p, buf, n);
+}
+
+// Length byte (top bit set if cut) followed by the characters
+static bool put_string(log_payload *p, const char *s) {
+    if (s == NULL) s = "(null)";
+    size_t len = strlen(s);
+    uint8_t header = len > LOG_STRING_MAX ? LOG_STRING_MAX | 0x80 : (uint8_t)len;
+    if (len > LOG_STRING_MAX) len = LOG_STRING_MAX;
+    if (p->len + 1 + (int)len > LOG_PAYLOAD_MAX) {
+        return false;
+    }
+    put_bytes(p, &header, 1);
+    return put_bytes(p, s, len);
+}
+
+void log_emit(uint8_t level, uint32_t token, uint32_t types, ...) {
+    log_payload p = {.len = 0};
+    uint8_t header[5] = {level, token, token >> 8, token >> 16, token >> 24};
+    put_bytes(&p, header, sizeof(header));
+
+    va_list args;
+    va_start(args, types);
+    int count = types & 0x0F;
+    bool fits = true;
+    for (int i = 0; i < count && fits; i++) {
+        switch ((types >> (4 + 2 * i)) & 3) {
+        case LOG_ARG_INT:
+            fits = put_varint(&p, va_arg(args, int));
+            break;
+        case LOG_ARG_INT64:
+            fits = put_varint(&p, va_arg(args, long long));
+            break;
+        case LOG_ARG_DOUBLE: {
+            float f = (float)va_arg(args, double);
+            fits = put_bytes(&p, &f, sizeof(f));
+            break;
+        }
+        default:
+            fits = put_string(&p, va_arg(args, const char *));
+            break;
+        }
+    }
+    va_end(args);
+
+    // '$', base64 with padding, newline and terminator
+    char line[1 + (LOG_PAYLOAD_MAX + 2) / 3 * 4 + 2];
+    int n = 0;
+    line[n++] = '$';
+    for (int i = 0; i < p.len; i += 3) {
+        uint32_t group = (uint32_t)p.data[i] << 16;
+        if (i + 1 < p.len) group |= (uint32_t)p.data[i + 1] << 8;
+        if (i + 2 < p.len) group |= p.data[i + 2];
+        line[n++] = base64_chars[(group >> 18) & 0x3F];
+        line[n++] = base64_chars[(group >> 12) & 0x3F];
+        line[n++] = i + 1 < p.len ? base64_chars[(group >> 6) & 0x3F] : '=';
+        line[n++] = i + 2 < p.len ? base64_chars[group & 0x3F] : '=';
+    }
+    line[n++] = '\n';
+    line[n] = '\0';
+    fputs(line, stdout);
+}
@@ -0,0 +1,170 @@
+/**
+ * Tokenized logging
+ *
+ * LOG_ERROR/LOG_WARN/LOG_INFO/LOG_DEBUG take a printf-style format string
+ * literal (no trailing newline) and its arguments. Levels above LOG_LEVEL
+ * compile to nothing; the arguments are not evaluated.
+ *
+ * With LOG_TOKENIZE (set for the firmware in CMakeLists.txt) the format
+ * string never reaches the device. The macro hashes it at compile time
+ * into a 32-bit token, records each argument's type with _Generic, and
+ * log_emit() sends one line:
+ *
+ *   $<base64 of: level, token (4 bytes LE), arguments>
+ *
+ * Integers are zigzag varints, floating point values 4-byte floats and
+ * strings a length byte plus up to LOG_STRING_MAX bytes. The host side
+ * (tools/tokendb.py, tools/detokenize.py) rebuilds the text from a token
+ * database generated from the sources at build time.
+ *
+ * Without LOG_TOKENIZE (host builds) the macros are plain printf calls.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_TOKENIZE
+#define LOG_TOKENIZE 0
+#endif
+
+// Characters of the format string that go into the token; the length always does
+#define LOG_HASH_LEN 80
+
+// Longest string argument sent, longer ones are cut
+#define LOG_STRING_MAX 24
+
+// Encoded size limit of one message, arguments that do not fit are dropped
+#define LOG_PAYLOAD_MAX 64
+
+// Most arguments one call can take
+#define LOG_MAX_ARGS 8
+
+// Argument types, two bits each in the types word above a 4-bit count
+#define LOG_ARG_INT 0
+#define LOG_ARG_INT64 1
+#define LOG_ARG_DOUBLE 2
+#define LOG_ARG_STRING 3
+
+/**
+ * Token of a format string literal
+ *
+ * 65599 hash over the first LOG_HASH_LEN bytes plus the length, written
+ * out in full so the compiler folds it to a constant and the string
+ * itself is never emitted. tools/tokendb.py computes the same hash.
+ */
+#define LOG_HASH_C(s, i, k) \
+    ((i) < sizeof(s) - 1 ? (uint32_t)(uint8_t)(s)[(i) < sizeof(s) ? (i) : 0] * (k) : 0u)
+
+#define LOG_HASH(s) ((uint32_t)(sizeof(s) - 1) + \
+    LOG_HASH_C(s, 0, 0x0001003Fu) + LOG_HASH_C(s, 1, 0x007E0F81u) + LOG_HASH_C(s, 2, 0x2E86D0BFu) + \
+    LOG_HASH_C(s, 3, 0x43EC5F01u) + LOG_HASH_C(s, 4, 0x162C613Fu) + LOG_HASH_C(s, 5, 0xD62AEE81u) + \
+    LOG_HASH_C(s, 6, 0xA311B1BFu) + LOG_HASH_C(s, 7, 0xD319BE01u) + LOG_HASH_C(s, 8, 0xB156C23Fu) + \
+    LOG_HASH_C(s, 9, 0x6698CD81u) + LOG_HASH_C(s, 10, 0x0D1B92BFu) + LOG_HASH_C(s, 11, 0xCC881D01u) + \
+    LOG_HASH_C(s, 12, 0x7280233Fu) + LOG_HASH_C(s, 13, 0x50C7AC81u) + LOG_HASH_C(s, 14, 0x8DA473BFu) + \
+    LOG_HASH_C(s, 15, 0x4F377C01u) + LOG_HASH_C(s, 16, 0xFAA8843Fu) + LOG_HASH_C(s, 17, 0x33B78B81u) + \
+    LOG_HASH_C(s, 18, 0x45AC54BFu) + LOG_HASH_C(s, 19, 0x7A27DB01u) + LOG_HASH_C(s, 20, 0xEACFE53Fu) + \
+    LOG_HASH_C(s, 21, 0xAE686A81u) + LOG_HASH_C(s, 22, 0x563335BFu) + LOG_HASH_C(s, 23, 0x6C593A01u) + \
+    LOG_HASH_C(s, 24, 0xE3F6463Fu) + LOG_HASH_C(s, 25, 0x5FDA4981u) + LOG_HASH_C(s, 26, 0xE03916BFu) + \
+    LOG_HASH_C(s, 27, 0x44CB9901u) + LOG_HASH_C(s, 28, 0x871BA73Fu) + LOG_HASH_C(s, 29, 0xE70D2881u) + \
+    LOG_HASH_C(s, 30, 0x04BDF7BFu) + LOG_HASH_C(s, 31, 0x227EF801u) + LOG_HASH_C(s, 32, 0x7540083Fu) + \
+    LOG_HASH_C(s, 33, 0xE3010781u) + LOG_HASH_C(s, 34, 0xE4C1D8BFu) + LOG_HASH_C(s, 35, 0x24735701u) + \
+    LOG_HASH_C(s, 36, 0x4F63693Fu) + LOG_HASH_C(s, 37, 0xF2B5E681u) + LOG_HASH_C(s, 38, 0xA144B9BFu) + \
+    LOG_HASH_C(s, 39, 0x69A8B601u) + LOG_HASH_C(s, 40, 0xB685CA3Fu) + LOG_HASH_C(s, 41, 0xB52BC581u) + \
+    LOG_HASH_C(s, 42, 0x5B469ABFu) + LOG_HASH_C(s, 43, 0x111F1501u) + LOG_HASH_C(s, 44, 0x4BA72B3Fu) + \
+    LOG_HASH_C(s, 45, 0xC962A481u) + LOG_HASH_C(s, 46, 0x33C77BBFu) + LOG_HASH_C(s, 47, 0x39D67401u) + \
+    LOG_HASH_C(s, 48, 0xAFC78C3Fu) + LOG_HASH_C(s, 49, 0xCE5A8381u) + LOG_HASH_C(s, 50, 0x4BC75CBFu) + \
+    LOG_HASH_C(s, 51, 0x02CED301u) + LOG_HASH_C(s, 52, 0x83E6ED3Fu) + LOG_HASH_C(s, 53, 0x63136281u) + \
+    LOG_HASH_C(s, 54, 0xC4463DBFu) + LOG_HASH_C(s, 55, 0x8B083201u) + LOG_HASH_C(s, 56, 0x69054E3Fu) + \
+    LOG_HASH_C(s, 57, 0x268D4181u) + LOG_HASH_C(s, 58, 0xBE441EBFu) + LOG_HASH_C(s, 59, 0xF1829101u) + \
+    LOG_HASH_C(s, 60, 0x0022AF3Fu) + LOG_HASH_C(s, 61, 0xB7C82081u) + LOG_HASH_C(s, 62, 0x5AC0FFBFu) + \
+    LOG_HASH_C(s, 63, 0x553DF001u) + LOG_HASH_C(s, 64, 0xEA3F103Fu) + LOG_HASH_C(s, 65, 0xB5C3FF81u) + \
+    LOG_HASH_C(s, 66, 0xBABCE0BFu) + LOG_HASH_C(s, 67, 0xD53A4F01u) + LOG_HASH_C(s, 68, 0xC85A713Fu) + \
+    LOG_HASH_C(s, 69, 0xBF80DE81u) + LOG_HASH_C(s, 70, 0xFF37C1BFu) + LOG_HASH_C(s, 71, 0x9077AE01u) + \
+    LOG_HASH_C(s, 72, 0x3B74D23Fu) + LOG_HASH_C(s, 73, 0x73FEBD81u) + LOG_HASH_C(s, 74, 0x4931A2BFu) + \
+    LOG_HASH_C(s, 75, 0xA5F60D01u) + LOG_HASH_C(s, 76, 0xE48E333Fu) + LOG_HASH_C(s, 77, 0x723D9C81u) + \
+    LOG_HASH_C(s, 78, 0xB9AA83BFu) + LOG_HASH_C(s, 79, 0x34B56C01u))
+
+// Type of one argument; arrays and integer promotions go through the + 0
+#define LOG_ARG_TYPE(arg) _Generic((arg) + 0,                          \
+    float: LOG_ARG_DOUBLE,                                              \
+    double: LOG_ARG_DOUBLE,                                             \
+    char *: LOG_ARG_STRING,                                             \
+    const char *: LOG_ARG_STRING,                                       \
+    default: (sizeof((arg) + 0) > sizeof(int) ? LOG_ARG_INT64 : LOG_ARG_INT))
+
+#define LOG_CONCAT_(a, b) a##b
+#define LOG_CONCAT(a, b) LOG_CONCAT_(a, b)
+
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define LOG_TYPE_AT(shift, arg) ((uint32_t)LOG_ARG_TYPE(arg) << (shift))
+#define LOG_TYPES_0(s) 0u
+#define LOG_TYPES_1(s, a) LOG_TYPE_AT(s, a)
+#define LOG_TYPES_2(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_1(s + 2, __VA_ARGS__))
+#define LOG_TYPES_3(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_2(s + 2, __VA_ARGS__))
+#define LOG_TYPES_4(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_3(s + 2, __VA_ARGS__))
+#define LOG_TYPES_5(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_4(s + 2, __VA_ARGS__))
+#define LOG_TYPES_6(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_5(s + 2, __VA_ARGS__))
+#define LOG_TYPES_7(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_6(s + 2, __VA_ARGS__))
+#define LOG_TYPES_8(s, a, ...) (LOG_TYPE_AT(s, a) | LOG_TYPES_7(s + 2, __VA_ARGS__))
+
+// Count in the low 4 bits, then two type bits per argument
+#define LOG_TYPES(...) ((uint32_t)LOG_NARGS(__VA_ARGS__) | \
+    LOG_CONCAT(LOG_TYPES_, LOG_NARGS(__VA_ARGS__))(4, ##__VA_ARGS__))
+
+#if LOG_TOKENIZE
+#define LOG_AT(level, fmt, ...) \
+    log_emit(level, LOG_HASH("" fmt), LOG_TYPES(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_AT(level, fmt, ...) printf(fmt "\n", ##__VA_ARGS__)
+#endif
+
+// Disabled levels: checked by the compiler, no code generated
+#define LOG_OFF(fmt, ...) ((void)sizeof(printf(fmt, ##__VA_ARGS__)))
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) LOG_OFF(fmt, ##__VA_ARGS__)
+#endif
+
+/**
+ * Encode and send one tokenized message (use the macros)
+ *
+ * @param types Argument count and types, see LOG_TYPES
+ */
+void log_emit(uint8_t level, uint32_t token, uint32_t types, ...);
+
+#endif
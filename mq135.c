@@ -0,0 +1,148 @@
+/**
+ * MQ135 air quality sensor
+ *
+ * Converts raw ADC codes to sensor resistance, gas estimates and AQI.
+ */
+
+#include <string.h>
+#include "mq135.h"
+
+float get_resistance(uint16_t adc_value) {
+    // Convert ADC to voltage
+    float voltage = (adc_value * VOLTAGE_REF) / ADC_RESOLUTION;
+    
+    // Use voltage divider equation to calculate Rs
+    if (voltage < 0.1) {
+        return 999999.0; // Avoid division by very small numbers
+    }
+    
+    return R_LOAD * (VOLTAGE_REF - voltage) / voltage;
+}
+
+// Curve parameters per gas, with a stored as log2(a)
+typedef struct {
+    const char *name;
+    float log2_a;
+    float b;
+} gas_curve;
+
+static const gas_curve curves[MQ135_GAS_COUNT] = {
+    [MQ135_GAS_CO2]     = {"CO2",     6.865450f, -1.41f},   // a = PARA
+    [MQ135_GAS_NH3]     = {"NH3",     6.675251f, -2.473f},  // a = 102.2
+    [MQ135_GAS_ALCOHOL] = {"Alcohol", 6.271556f, -3.18f},   // a = 77.255
+    [MQ135_GAS_TOLUENE] = {"Toluene", 5.490153f, -3.445f},  // a = 44.947
+    [MQ135_GAS_ACETONE] = {"Acetone", 5.115533f, -3.369f}   // a = 34.668
+};
+
+// log2 of a positive, normal float: exponent from the bits, mantissa by series
+static float fast_log2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int exponent = (int)((bits >> 23) & 0xFF) - 127;
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+
+    // log2(m) for m in [1, 2) via atanh: s = (m - 1) / (m + 1) <= 1/3
+    float s = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    float series = s * (2.885390f + s2 * (0.961797f + s2 * (0.577078f + s2 * 0.412199f)));
+    return exponent + series;
+}
+
+// 2^x: integer part into the exponent bits, fraction by polynomial
+static float fast_exp2(float x) {
+    if (x < -126.0f) return 0.0f;
+    if (x > 127.0f) x = 127.0f;
+
+    int whole = (int)x;
+    if (whole > x) whole--;     // Floor for negative x
+    float f = x - whole;
+    float p = 1.0f + f * (0.6931472f + f * (0.2402265f + f * (0.0555041f +
+                     f * (0.0096181f + f * 0.0013333f))));
+
+    uint32_t bits = (uint32_t)(whole + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+float mq135_correction(float temp, float humidity) {
+    if (temp < 20.0f) {
+        return CORA * temp * temp - CORB * temp + CORC - (humidity - 33.0f) * CORD;
+    }
+    return CORE * temp + CORF * humidity + CORG;
+}
+
+void mq135_estimate(float ratio, float ppm[MQ135_GAS_COUNT]) {
+    if (!(ratio > 0.01f)) {
+        for (int i = 0; i < MQ135_GAS_COUNT; i++) {
+            ppm[i] = MQ135_PPM_INVALID;   // Invalid ratio
+        }
+        return;
+    }
+
+    // ppm = a * ratio^b  =>  log2(ppm) = log2(a) + b * log2(ratio)
+    float log_ratio = fast_log2(ratio);
+    for (int i = 0; i < MQ135_GAS_COUNT; i++) {
+        ppm[i] = fast_exp2(curves[i].log2_a + curves[i].b * log_ratio);
+    }
+}
+
+const char *mq135_gas_name(mq135_gas gas) {
+    return gas < MQ135_GAS_COUNT ? curves[gas].name : "?";
+}
+
+int calculate_aqi(float ppm) {
+    // Adjusted AQI calculation that's more sensitive to lower CO2 levels
+    if (ppm < 0) return 0;
+    
+    // More sensitive scale for indoor environments
+    if (ppm < 400) {
+        // For very low CO2 levels (exceptional air quality)
+        return (int)(ppm * 25 / 400);  // 0-25 range
+    } 
+    else if (ppm < 600) {
+        // Good air quality
+        return 25 + (int)((ppm - 400) * 25 / 200);  // 25-50 range
+    }
+    else if (ppm < 800) {
+        // Moderate air quality
+        return 50 + (int)((ppm - 600) * 25 / 200);  // 50-75 range
+    }
+    else if (ppm < 1000) {
+        // Acceptable
+        return 75 + (int)((ppm - 800) * 25 / 200);  // 75-100 range
+    }
+    else if (ppm < 1500) {
+        // Poor air quality
+        return 100 + (int)((ppm - 1000) * 50 / 500);  // 100-150 range
+    }
+    else if (ppm < 2000) {
+        // Very poor air quality
+        return 150 + (int)((ppm - 1500) * 50 / 500);  // 150-200 range
+    }
+    else if (ppm < 5000) {
+        // Unhealthy
+        return 200 + (int)((ppm - 2000) * 100 / 3000);  // 200-300 range
+    }
+    else {
+        // Hazardous
+        return 300 + (int)((ppm - 5000) * 200 / 5000);  // 300-500 range
+    }
+}
+
+const char* get_air_quality_label(float ppm) {
+    if (ppm < 700) {
+        return "GOOD";  // Fresh/Good air
+    } 
+    else if (ppm < 1000) {
+        return "OK";    // Acceptable
+    }
+    else if (ppm < 2000) {
+        return "BAD";   // Poor air quality
+    }
+    else {
+        return "UGLY";  // Very poor/hazardous
+    }
+}
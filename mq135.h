@@ -0,0 +1,69 @@
+/**
+ * MQ135 air quality sensor
+ *
+ * The MQ135 responds to several gases, each following its own power law
+ * in the sensor ratio: ppm = a * (Rs/R0)^b. Rs also drifts with
+ * temperature and humidity, so the measured resistance is first divided
+ * by the datasheet correction factor for the current conditions.
+ *
+ * All curves are evaluated in one pass in the log2 domain: log2 of the
+ * ratio is taken once, and each gas then costs a multiply-add and one
+ * fast exp2 instead of a pow() call.
+ */
+
+#ifndef MQ135_H
+#define MQ135_H
+
+#include <stdint.h>
+
+// MQ135 parameters
+#define VOLTAGE_REF 3.3
+#define ADC_RESOLUTION 4095
+#define R_LOAD 10.0
+#define RZERO 76.63
+#define PARA 116.6020682
+
+// Temperature/humidity correction of Rs (datasheet curve fit)
+#define CORA 0.00035f
+#define CORB 0.02718f
+#define CORC 1.39538f
+#define CORD 0.0018f
+#define CORE -0.003333333f
+#define CORF -0.001923077f
+#define CORG 1.130128205f
+
+// Reported for every gas when the ratio is out of range
+#define MQ135_PPM_INVALID 9999.0f
+
+typedef enum {
+    MQ135_GAS_CO2,
+    MQ135_GAS_NH3,
+    MQ135_GAS_ALCOHOL,
+    MQ135_GAS_TOLUENE,
+    MQ135_GAS_ACETONE,
+    MQ135_GAS_COUNT
+} mq135_gas;
+
+// Sensor resistance in kOhms for a raw ADC reading
+float get_resistance(uint16_t adc_value);
+
+/**
+ * Correction factor of Rs at a temperature (C) and relative humidity (%)
+ *
+ * 1.0 at 20 C / 33 %RH, the conditions the curves are specified at.
+ */
+float mq135_correction(float temp, float humidity);
+
+/**
+ * Estimate every gas for an Rs/R0 ratio (already corrected)
+ *
+ * @param ppm Receives MQ135_GAS_COUNT concentrations
+ */
+void mq135_estimate(float ratio, float ppm[MQ135_GAS_COUNT]);
+
+const char *mq135_gas_name(mq135_gas gas);
+
+int calculate_aqi(float ppm);
+const char* get_air_quality_label(float ppm);
+
+#endif
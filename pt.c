@@ -0,0 +1,14 @@
+/**
+ * Protothreads: stackless coroutines for driver wait states
+ */
+
+#include "hardware/sync.h"
+#include "pt.h"
+
+// In RAM with the interrupt handlers that call it (the display DMA)
+void __not_in_flash_func(pt_signal_raise)(pt_signal *sig) {
+    sig->count++;
+    // Make the count visible before waking a core waiting in __wfe()
+    __dmb();
+    __sev();
+}
@@ -0,0 +1,127 @@
+/**
+ * Protothreads: stackless coroutines for driver wait states
+ *
+ * A protothread is a function that can wait in the middle and carry on
+ * from the same place on its next call, so a device sequence is written
+ * top to bottom instead of as a hand-made state machine:
+ *
+ *   pt_status measure(my_device *d) {
+ *       PT_BEGIN(&d->pt);
+ *       if (!start_conversion(d)) PT_FAIL(&d->pt);
+ *       PT_SLEEP_MS(&d->pt, CONVERSION_MS);
+ *       PT_WAIT_SIGNAL(&d->pt, &d->data_ready, TIMEOUT_MS);
+ *       if (d->pt.timed_out) PT_FAIL(&d->pt);
+ *       read_result(d);
+ *       PT_END(&d->pt);
+ *   }
+ *
+ * Every wait returns PT_WAITING to the caller, which runs other work and
+ * calls the thread again once pt_due() says so. The resume point is a
+ * line number in a switch (Duff's device), which means:
+ *
+ *   - local variables do not survive a wait; keep state in the struct
+ *   - waits can only be in the thread function itself, not in functions
+ *     it calls, and there must be no switch statement around them
+ *
+ * Waits on interrupts (GPIO edges, I2C or DMA completion) use a
+ * pt_signal raised by the handler; raising it also wakes a core sleeping
+ * in __wfe().
+ *
+ * A thread costs a few bytes of state; one core can run as many
+ * overlapping device operations as it has threads.
+ */
+
+#ifndef PT_H
+#define PT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    PT_WAITING,     // Blocked on a wait, call again when due
+    PT_EXITED,      // Ran to PT_END or PT_EXIT
+    PT_FAILED       // Gave up with PT_FAIL
+} pt_status;
+
+// Set from interrupt handlers, waited on by threads
+typedef struct {
+    volatile uint32_t count;
+} pt_signal;
+
+typedef struct {
+    uint16_t lc;                // Resume point, 0 at the start
+    bool timed_out;             // Result of the last PT_WAIT_SIGNAL
+    uint32_t now_ms;            // Set by the caller before each run
+    uint32_t wake_ms;           // When the current wait should be checked again
+    const pt_signal *signal;    // Signal being waited on, NULL if none
+    uint32_t mark;              // Its count at the start of the wait
+} pt;
+
+// Waits fall through into their own resume point on the first run
+#if defined(__has_attribute)
+#if __has_attribute(fallthrough)
+#define PT_FALLTHROUGH __attribute__((fallthrough))
+#endif
+#endif
+#ifndef PT_FALLTHROUGH
+#define PT_FALLTHROUGH
+#endif
+
+#define PT_INIT(p) ((p)->lc = 0, (p)->signal = NULL)
+
+#define PT_BEGIN(p) switch ((p)->lc) { case 0:
+
+#define PT_END(p) } (p)->lc = 0; return PT_EXITED
+
+#define PT_EXIT(p) do { (p)->lc = 0; return PT_EXITED; } while (0)
+
+#define PT_FAIL(p) do { (p)->lc = 0; return PT_FAILED; } while (0)
+
+// Checked again on every run until it holds
+#define PT_WAIT_UNTIL(p, cond)                                          \
+    do {                                                                \
+        (p)->wake_ms = (p)->now_ms;                                     \
+        (p)->lc = __LINE__; PT_FALLTHROUGH; case __LINE__:              \
+        if (!(cond)) return PT_WAITING;                                 \
+    } while (0)
+
+// Give other work a turn, carry on with the next run
+#define PT_YIELD(p)                                                     \
+    do {                                                                \
+        (p)->wake_ms = (p)->now_ms;                                     \
+        (p)->lc = __LINE__; return PT_WAITING; case __LINE__:;          \
+    } while (0)
+
+#define PT_SLEEP_MS(p, ms)                                              \
+    do {                                                                \
+        (p)->wake_ms = (p)->now_ms + (ms);                              \
+        (p)->lc = __LINE__; PT_FALLTHROUGH; case __LINE__:              \
+        if ((int32_t)((p)->now_ms - (p)->wake_ms) < 0) return PT_WAITING; \
+    } while (0)
+
+// Wait for the signal to be raised after this point, or timeout_ms;
+// (p)->timed_out tells which
+#define PT_WAIT_SIGNAL(p, sig, timeout_ms)                              \
+    do {                                                                \
+        (p)->signal = (sig);                                            \
+        (p)->mark = (sig)->count;                                       \
+        (p)->wake_ms = (p)->now_ms + (timeout_ms);                      \
+        (p)->lc = __LINE__; PT_FALLTHROUGH; case __LINE__:              \
+        (p)->timed_out = (sig)->count == (p)->mark;                     \
+        if ((p)->timed_out && (int32_t)((p)->now_ms - (p)->wake_ms) < 0) \
+            return PT_WAITING;                                          \
+        (p)->signal = NULL;                                             \
+    } while (0)
+
+// Whether a waiting thread should run again: its wait time is up or the
+// signal it waits on was raised
+static inline bool pt_due(const pt *p, uint32_t now_ms) {
+    return (int32_t)(now_ms - p->wake_ms) >= 0 ||
+           (p->signal && p->signal->count != p->mark);
+}
+
+// From interrupt handlers (or anywhere): wake threads waiting on sig
+void pt_signal_raise(pt_signal *sig);
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * Adaptive sampling controller
+ */
+
+#include "sampler.h"
+
+void sampler_init(sampler *s, const sampler_config *cfg) {
+    s->cfg = *cfg;
+    s->period_ms = cfg->min_period_ms;
+    s->last_value = 0;
+    s->last_ms = 0;
+    s->has_last = false;
+    s->calm_count = 0;
+}
+
+uint32_t sampler_update(sampler *s, float value, uint32_t now_ms) {
+    if (s->has_last && now_ms != s->last_ms) {
+        float change = value - s->last_value;
+        if (change < 0) change = -change;
+        float rate = change * 1000.0f / (float)(now_ms - s->last_ms);
+
+        if (change > s->cfg.noise && rate > s->cfg.deadband) {
+            // Something is happening, sample as fast as allowed
+            s->period_ms = s->cfg.min_period_ms;
+            s->calm_count = 0;
+        } else if (++s->calm_count >= SAMPLER_CALM_SAMPLES) {
+            // Stable for a while, back off by half again
+            s->calm_count = 0;
+            s->period_ms += s->period_ms / 2;
+            if (s->period_ms > s->cfg.max_period_ms) {
+                s->period_ms = s->cfg.max_period_ms;
+            }
+        }
+    }
+
+    s->last_value = value;
+    s->last_ms = now_ms;
+    s->has_last = true;
+    return s->period_ms;
+}
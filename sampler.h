@@ -0,0 +1,44 @@
+/**
+ * Adaptive sampling controller
+ *
+ * Tracks how fast one signal is changing and picks the next sampling
+ * period. Any change faster than the deadband drops straight to the
+ * minimum period; after a run of calm samples the period grows step by
+ * step up to the maximum.
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Calm samples in a row before the period is lengthened
+#define SAMPLER_CALM_SAMPLES 3
+
+typedef struct {
+    uint32_t min_period_ms;
+    uint32_t max_period_ms;
+    float noise;            // Changes up to this size are treated as noise
+    float deadband;         // Rate of change (units per second) considered stable
+} sampler_config;
+
+typedef struct {
+    sampler_config cfg;
+    uint32_t period_ms;
+    float last_value;
+    uint32_t last_ms;
+    bool has_last;
+    uint8_t calm_count;
+} sampler;
+
+void sampler_init(sampler *s, const sampler_config *cfg);
+
+/**
+ * Feed a new sample of the signal
+ *
+ * @return The period to wait before the next sample
+ */
+uint32_t sampler_update(sampler *s, float value, uint32_t now_ms);
+
+#endif
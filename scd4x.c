@@ -0,0 +1,112 @@
+/**
+ * Sensirion SCD4x (SCD40/SCD41) NDIR CO2 sensor
+ *
+ * Runs in periodic mode, one measurement every 5 s. Every command needs
+ * 1 ms before its response can be read; the measurement thread yields
+ * for that time instead of sleeping. The probe only sends the stop
+ * command; the thread waits for the stop to take effect and checks the
+ * serial number before starting, so startup does not wait 500 ms.
+ *
+ * A sensor that was power-cycled or re-plugged comes back idle and never
+ * has data ready. After any failed measurement, or one that stays not
+ * ready for two intervals, it is stopped and started again like after
+ * the probe.
+ */
+
+#include "pico/stdlib.h"
+#include "envsensor.h"
+
+#define SCD4X_CMD_START_PERIODIC 0x21B1
+#define SCD4X_CMD_READ_MEASUREMENT 0xEC05
+#define SCD4X_CMD_STOP_PERIODIC 0x3F86
+#define SCD4X_CMD_DATA_READY 0xE4B8
+#define SCD4X_CMD_SERIAL 0x3682
+
+#define SCD4X_INTERVAL_MS 5000      // Periodic measurement interval
+#define SCD4X_STOP_MS 500           // Stop takes effect after this
+#define SCD4X_COMMAND_MS 1          // Command to response
+#define SCD4X_RETRY_MS 200          // Data ready check while not ready
+
+// Not ready this long after the measurement started: no longer measuring
+#define SCD4X_READY_TIMEOUT_MS (SCD4X_STOP_MS + 2 * SCD4X_INTERVAL_MS)
+
+static bool scd4x_probe(env_sensor *s) {
+    // It may still be measuring from before a reset
+    s->scd4x.running = false;
+    s->scd4x.identified = false;
+    return env_command(s, SCD4X_CMD_STOP_PERIODIC);
+}
+
+static pt_status measure_thread(env_sensor *s, env_reading *out) {
+    uint16_t status, raw[3];
+
+    PT_BEGIN(&s->thread);
+    // Once running it measures on its own and the next result is due
+    // about now
+    if (!s->scd4x.running) {
+        if (!s->scd4x.identified) {
+            // After the probe's stop, the serial number confirms the part
+            PT_SLEEP_MS(&s->thread, SCD4X_STOP_MS);
+            if (!env_command(s, SCD4X_CMD_SERIAL)) {
+                PT_FAIL(&s->thread);
+            }
+            PT_SLEEP_MS(&s->thread, SCD4X_COMMAND_MS);
+            if (!env_read_words(s, raw, 3)) {
+                PT_FAIL(&s->thread);
+            }
+            s->scd4x.identified = true;
+        }
+        if (!env_command(s, SCD4X_CMD_START_PERIODIC)) {
+            PT_FAIL(&s->thread);
+        }
+        s->scd4x.running = true;
+        PT_SLEEP_MS(&s->thread, SCD4X_INTERVAL_MS);
+    }
+
+    for (;;) {
+        if (!env_command(s, SCD4X_CMD_DATA_READY)) {
+            PT_FAIL(&s->thread);
+        }
+        PT_SLEEP_MS(&s->thread, SCD4X_COMMAND_MS);
+        if (!env_read_words(s, &status, 1)) {
+            PT_FAIL(&s->thread);
+        }
+        if ((status & 0x07FF) != 0) break;
+        if (s->thread.now_ms - s->started_ms >= SCD4X_READY_TIMEOUT_MS) {
+            PT_FAIL(&s->thread);
+        }
+        PT_SLEEP_MS(&s->thread, SCD4X_RETRY_MS);
+    }
+
+    if (!env_command(s, SCD4X_CMD_READ_MEASUREMENT)) {
+        PT_FAIL(&s->thread);
+    }
+    PT_SLEEP_MS(&s->thread, SCD4X_COMMAND_MS);
+    if (!env_read_words(s, raw, 3)) {
+        PT_FAIL(&s->thread);
+    }
+    out->value[ENV_CO2] = raw[0];
+    out->value[ENV_TEMP] = -450 + (int32_t)((1750u * raw[1] + 32767) / 65535);
+    out->value[ENV_HUMIDITY] = (int32_t)((1000u * raw[2] + 32767) / 65535);
+    out->valid = 1u << ENV_CO2 | 1u << ENV_TEMP | 1u << ENV_HUMIDITY;
+    PT_END(&s->thread);
+}
+
+static pt_status scd4x_measure(env_sensor *s, env_reading *out) {
+    pt_status status = measure_thread(s, out);
+    if (status == PT_FAILED) {
+        // Stop it in case it is still measuring; the retry identifies it
+        // and starts periodic measurement again
+        scd4x_probe(s);
+    }
+    return status;
+}
+
+const env_driver scd4x_driver = {
+    .name = "SCD4x",
+    .addresses = {0x62, 0},
+    .provides = 1u << ENV_CO2 | 1u << ENV_TEMP | 1u << ENV_HUMIDITY,
+    .period_ms = SCD4X_INTERVAL_MS,
+    .probe = scd4x_probe,
+    .measure = scd4x_measure
+};
@@ -0,0 +1,252 @@
+/**
+ * OLED screens
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "log.h"
+#include "mq135.h"
+#include "widget.h"
+#include "screens.h"
+
+// Window shown on the statistics screen; serial output has all of them
+#define SCREEN_STATS_WINDOW STATS_1HOUR
+
+static const char *const channel_labels[SENSOR_CH_COUNT] = {"T", "H", "CO2"};
+static const char *const channel_names[SENSOR_CH_COUNT] = {"Temperature", "Humidity", "CO2"};
+
+// Longest formatted value, "-214748364.8" and the terminator
+#define VALUE_TEXT_MAX 13
+
+// Format a channel value: tenths for temperature and humidity, whole ppm for CO2
+static void format_value(char *buf, size_t len, int channel, int32_t value) {
+    if (channel == SENSOR_CH_CO2) {
+        snprintf(buf, len, "%ld", (long)value);
+        return;
+    }
+    uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    snprintf(buf, len, "%s%lu.%lu", value < 0 ? "-" : "", (unsigned long)(mag / 10),
+             (unsigned long)(mag % 10));
+}
+
+// Hourglass shown while the MQ135 warms up
+static const uint8_t icon_hourglass[8] = {0x00, 0xC3, 0xA5, 0x99, 0xA5, 0xC3, 0x00, 0x00};
+
+// CO2 trend arrows
+static const uint8_t icon_rising[8] = {0x00, 0x04, 0x06, 0x7F, 0x7F, 0x06, 0x04, 0x00};
+static const uint8_t icon_falling[8] = {0x00, 0x10, 0x30, 0x7F, 0x7F, 0x30, 0x10, 0x00};
+
+// Widgets of every screen; they do not overlap within a screen
+static widget temp_field = {.type = WIDGET_FIELD, .y = 8, .flags = WIDGET_2X | WIDGET_CENTER,
+                            .decimals = 1, .prefix = "T:", .suffix = "C"};
+static widget humidity_field = {.type = WIDGET_FIELD, .y = 8, .flags = WIDGET_2X | WIDGET_CENTER,
+                                .decimals = 1, .prefix = "H:", .suffix = "%"};
+static widget co2_field = {.type = WIDGET_FIELD, .y = 8, .flags = WIDGET_2X | WIDGET_CENTER,
+                           .prefix = "CO2:"};
+static widget warm_field = {.type = WIDGET_FIELD, .y = 4, .flags = WIDGET_2X | WIDGET_CENTER,
+                            .prefix = "WARM ", .suffix = "%"};
+static widget warm_bar = {.type = WIDGET_BAR, .x = 8, .h = 4};
+static widget warm_icon = {.type = WIDGET_ICON, .x = 0, .y = 0};
+static widget trend_icon = {.type = WIDGET_ICON, .x = 0};
+static widget trend_text = {.type = WIDGET_TEXT, .x = 10};
+static widget stats_rows[1 + SENSOR_CH_COUNT] = {
+    {.type = WIDGET_TEXT, .y = 0},
+    {.type = WIDGET_TEXT, .y = 8},
+    {.type = WIDGET_TEXT, .y = 16},
+    {.type = WIDGET_TEXT, .y = 24}
+};
+
+static widget comfort_fields[4] = {
+    {.type = WIDGET_FIELD, .y = 0, .decimals = 1, .prefix = "DEW PT  ", .suffix = "C"},
+    {.type = WIDGET_FIELD, .y = 8, .decimals = 1, .prefix = "HEAT IX ", .suffix = "C"},
+    {.type = WIDGET_FIELD, .y = 16, .decimals = 2, .prefix = "ABS HUM ", .suffix = "G/M3"},
+    {.type = WIDGET_FIELD, .y = 24, .decimals = 1, .prefix = "PRESS   ", .suffix = "HPA"}
+};
+
+static widget *const all_widgets[] = {
+    &temp_field, &humidity_field, &co2_field, &warm_field, &warm_bar, &warm_icon,
+    &trend_icon, &trend_text,
+    &stats_rows[0], &stats_rows[1], &stats_rows[2], &stats_rows[3],
+    &comfort_fields[0], &comfort_fields[1], &comfort_fields[2], &comfort_fields[3]
+};
+
+static int shown_screen = -1;
+
+// Reading of the DHT22, or the state it is in
+static void render_dht_field(ssd1306_t *disp, widget *w, const sensor_data *data, int32_t value) {
+    char text[WIDGET_TEXT_MAX];
+    if (data->dht_state == SENSOR_READY) {
+        widget_field(disp, w, value);
+    } else {
+        snprintf(text, sizeof(text), "%s%s", w->prefix,
+                 data->dht_state == SENSOR_WARMING ? "--" : "ERROR");
+        widget_text(disp, w, text);
+    }
+}
+
+// Rate of change and time to the limit on the bottom row, e.g. "+12/M 1000 IN 7M"
+static void render_co2_trend(ssd1306_t *disp, const sensor_data *data) {
+    char text[WIDGET_TEXT_MAX];
+    trend_icon.y = trend_text.y = (disp->pages - 1) * 8;
+
+    if (!data->co2_trend_valid) {
+        widget_hide(disp, &trend_icon);
+        widget_hide(disp, &trend_text);
+        return;
+    }
+    if (data->co2_direction == TREND_STEADY) {
+        widget_hide(disp, &trend_icon);
+        widget_text(disp, &trend_text, "STEADY");
+        return;
+    }
+
+    widget_icon(disp, &trend_icon,
+                data->co2_direction == TREND_RISING ? icon_rising : icon_falling);
+    int n = snprintf(text, sizeof(text), "%+d/M", (int)data->co2_rate);
+    if (data->co2_limit_minutes >= 0 && n < (int)sizeof(text)) {
+        snprintf(text + n, sizeof(text) - n, " %d IN %dM", CO2_LIMIT_PPM,
+                 data->co2_limit_minutes);
+    }
+    widget_text(disp, &trend_text, text);
+}
+
+static void render_co2(ssd1306_t *disp, const sensor_data *data) {
+    if (data->co2_state == SENSOR_WARMING && data->co2_source != SOURCE_I2C) {
+        // Warm-up progress with a bar underneath the text
+        warm_bar.y = (disp->pages - 1) * 8 + 2;
+        warm_bar.w = disp->width - 16;
+        widget_hide(disp, &co2_field);
+        widget_hide(disp, &trend_icon);
+        widget_hide(disp, &trend_text);
+        widget_icon(disp, &warm_icon, icon_hourglass);
+        widget_field(disp, &warm_field, data->co2_warmup_pct);
+        widget_bar(disp, &warm_bar, data->co2_warmup_pct);
+    } else {
+        widget_hide(disp, &warm_icon);
+        widget_hide(disp, &warm_field);
+        widget_hide(disp, &warm_bar);
+        widget_field(disp, &co2_field, (int32_t)data->co2_ppm);
+        render_co2_trend(disp, data);
+    }
+}
+
+// Dew point, heat index and absolute humidity, one row each, and the
+// pressure when an I2C sensor has it
+static void render_comfort(ssd1306_t *disp, const sensor_data *data) {
+    render_dht_field(disp, &comfort_fields[0], data, data->comfort.dew_point_x10);
+    render_dht_field(disp, &comfort_fields[1], data, data->comfort.heat_index_x10);
+    render_dht_field(disp, &comfort_fields[2], data, data->comfort.abs_humidity_x100);
+    if (data->env.valid & (1u << ENV_PRESSURE)) {
+        widget_field(disp, &comfort_fields[3], (data->env.value[ENV_PRESSURE] + 5) / 10);
+    } else {
+        widget_hide(disp, &comfort_fields[3]);
+    }
+}
+
+// Min/max/mean table, one row per channel
+static void render_stats(ssd1306_t *disp, sensor_data *data, uint32_t now_ms) {
+    // Label and three values; anything past the panel edge is not drawn
+    char line_buffer[3 + 3 * VALUE_TEXT_MAX];
+    char min[VALUE_TEXT_MAX], max[VALUE_TEXT_MAX], mean[VALUE_TEXT_MAX];
+
+    snprintf(line_buffer, sizeof(line_buffer), "%-3s   MIN   MAX   AVG",
+             stats_window_name(SCREEN_STATS_WINDOW));
+    widget_text(disp, &stats_rows[0], line_buffer);
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT && (ch + 1) * 8 < disp->height; ch++) {
+        stats_summary s;
+        if (stats_get(&data->stats[ch], SCREEN_STATS_WINDOW, now_ms, &s)) {
+            format_value(min, sizeof(min), ch, s.min);
+            format_value(max, sizeof(max), ch, s.max);
+            format_value(mean, sizeof(mean), ch, s.mean);
+            snprintf(line_buffer, sizeof(line_buffer), "%-3s%6s%6s%6s",
+                     channel_labels[ch], min, max, mean);
+        } else {
+            snprintf(line_buffer, sizeof(line_buffer), "%-3s%6s%6s%6s",
+                     channel_labels[ch], "--", "--", "--");
+        }
+        widget_text(disp, &stats_rows[ch + 1], line_buffer);
+    }
+}
+
+bool screens_render(ssd1306_t *disp, int screen, sensor_data *data, uint32_t now_ms) {
+    // A different screen starts from a blank framebuffer
+    if (screen != shown_screen) {
+        ssd1306_clear(disp);
+        for (size_t i = 0; i < sizeof(all_widgets) / sizeof(all_widgets[0]); i++) {
+            widget_invalidate(all_widgets[i]);
+        }
+        shown_screen = screen;
+    }
+
+    if (screen == SCREEN_TEMP) {
+        render_dht_field(disp, &temp_field, data, data->dht.temp_x10);
+    } else if (screen == SCREEN_HUMIDITY) {
+        render_dht_field(disp, &humidity_field, data, data->dht.humidity_x10);
+    } else if (screen == SCREEN_STATS) {
+        render_stats(disp, data, now_ms);
+    } else if (screen == SCREEN_COMFORT) {
+        render_comfort(disp, data);
+    } else {
+        render_co2(disp, data);
+    }
+    return disp->dirty;
+}
+
+void screens_print(int screen, sensor_data *data, uint32_t now_ms) {
+    if (screen == SCREEN_STATS) {
+        // All windows with standard deviation and sample count
+        for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+            for (int w = 0; w < STATS_WINDOW_COUNT; w++) {
+                stats_summary s;
+                char min[VALUE_TEXT_MAX], max[VALUE_TEXT_MAX], mean[VALUE_TEXT_MAX];
+                char sd[VALUE_TEXT_MAX];
+                if (!stats_get(&data->stats[ch], w, now_ms, &s)) {
+                    continue;
+                }
+                format_value(min, sizeof(min), ch, s.min);
+                format_value(max, sizeof(max), ch, s.max);
+                format_value(mean, sizeof(mean), ch, s.mean);
+                format_value(sd, sizeof(sd), ch, s.stddev);
+                LOG_INFO("%s %s: min %s max %s mean %s sd %s (n=%lu)", channel_names[ch],
+                         stats_window_name(w), min, max, mean, sd, (unsigned long)s.count);
+            }
+        }
+    } else if (screen == SCREEN_TEMP) {
+        LOG_INFO("Temperature: %.1f°C (%s)", data->dht.temp, sensors_source_name(data->th_source));
+    } else if (screen == SCREEN_HUMIDITY) {
+        LOG_INFO("Humidity: %.1f%% (%s)", data->dht.humidity,
+                 sensors_source_name(data->th_source));
+    } else if (screen == SCREEN_COMFORT) {
+        if (data->dht_state != SENSOR_READY) {
+            LOG_INFO("Comfort: no temperature and humidity reading");
+        } else {
+            const comfort_metrics *c = &data->comfort;
+            LOG_INFO("Dew point: %.1f°C - Heat index: %.1f°C - Absolute humidity: %.2f g/m3",
+                     c->dew_point_x10 / 10.0, c->heat_index_x10 / 10.0,
+                     c->abs_humidity_x100 / 100.0);
+        }
+        if (data->env.valid & (1u << ENV_PRESSURE)) {
+            LOG_INFO("Pressure: %.1f hPa", data->env.value[ENV_PRESSURE] / 100.0);
+        }
+    } else if (data->co2_state == SENSOR_WARMING && data->co2_source != SOURCE_I2C) {
+        LOG_INFO("CO2: warming up (%d%%)", data->co2_warmup_pct);
+    } else {
+        // Print both CO2 and quality label to serial
+        LOG_INFO("CO2: %.2f ppm (%s) - Air Quality: %s", data->co2_ppm,
+                 sensors_source_name(data->co2_source), get_air_quality_label(data->co2_ppm));
+
+        // The other MQ135 estimates, and the compensation they went through
+        const float *ppm = data->gas_ppm;
+        LOG_INFO("Gases (ppm): NH3 %.2f, Alcohol %.2f, Toluene %.2f, Acetone %.2f"
+                 " - T/RH correction %.3f", ppm[MQ135_GAS_NH3], ppm[MQ135_GAS_ALCOHOL],
+                 ppm[MQ135_GAS_TOLUENE], ppm[MQ135_GAS_ACETONE], data->co2_correction);
+
+        if (data->co2_trend_valid && data->co2_limit_minutes >= 0) {
+            LOG_INFO("CO2 trend: %+.1f ppm/min, %d ppm in %d min", data->co2_rate,
+                     CO2_LIMIT_PPM, data->co2_limit_minutes);
+        } else if (data->co2_trend_valid) {
+            LOG_INFO("CO2 trend: %+.1f ppm/min", data->co2_rate);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+/**
+ * OLED screens
+ *
+ * Renders one screen of sensor data into the framebuffer and prints the
+ * matching line to the serial output.
+ */
+
+#ifndef SCREENS_H
+#define SCREENS_H
+
+#include "ssd1306.h"
+#include "sensors.h"
+
+typedef enum {
+    SCREEN_TEMP,
+    SCREEN_HUMIDITY,
+    SCREEN_AQI,
+    SCREEN_STATS,
+    SCREEN_COMFORT,
+    SCREEN_COUNT
+} screen_id;
+
+/**
+ * Bring the framebuffer up to date with a screen (does not send it to the panel)
+ *
+ * Screens are built from retained widgets, so only content that changed
+ * since the last call is redrawn and marked dirty.
+ *
+ * @return true if anything changed and the panel needs a flush
+ */
+bool screens_render(ssd1306_t *disp, int screen, sensor_data *data, uint32_t now_ms);
+
+void screens_print(int screen, sensor_data *data, uint32_t now_ms);
+
+#endif
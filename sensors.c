@@ -0,0 +1,211 @@
+/**
+ * Sensor state shared by acquisition, display and replay
+ */
+
+#include <string.h>
+#include "sensors.h"
+
+// Slope that starts a rising/falling indication, and the one that ends it
+#define CO2_TREND_ON_PPM_MIN 5.0f
+#define CO2_TREND_OFF_PPM_MIN 2.0f
+
+void sensors_init(sensor_data *data) {
+    // Field by field: a compound literal of the whole struct (with its
+    // statistics) would need a large temporary on the stack
+    memset(data, 0, sizeof(*data));
+    data->dht.error = true;
+    data->dht_state = SENSOR_WARMING;
+    data->co2_state = SENSOR_WARMING;
+    data->dht22_state = SENSOR_WARMING;
+    data->co2_correction = 1.0f;
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        stats_init(&data->stats[i]);
+    }
+    trend_init(&data->co2_trend, CO2_TREND_WINDOW_MS);
+    data->co2_limit_minutes = -1;
+}
+
+// Readings this close to either end of the ADC range come from an open or
+// shorted MQ135, not from the gas
+#define MQ135_ADC_RAIL 16
+
+#define ENV_TH_BITS ((1u << ENV_TEMP) | (1u << ENV_HUMIDITY))
+
+static const char *const source_names[] = {"none", "dht22", "mq135", "i2c"};
+
+// Take over a temperature and humidity reading
+static void apply_th(sensor_data *data, const dht_reading *reading, sensor_source source,
+                     uint32_t now_ms) {
+    if (data->dht_state != SENSOR_READY || source != data->th_source ||
+        reading->temp_x10 != data->dht.temp_x10 ||
+        reading->humidity_x10 != data->dht.humidity_x10) {
+        data->dht_version++;
+    }
+    data->dht = *reading;
+    data->th_source = source;
+    comfort_compute(reading->temp_x10, reading->humidity_x10, &data->comfort);
+    data->dht_state = SENSOR_READY;
+    stats_add(&data->stats[SENSOR_CH_TEMP], reading->temp_x10, now_ms);
+    stats_add(&data->stats[SENSOR_CH_HUMIDITY], reading->humidity_x10, now_ms);
+    data->stats_version++;
+}
+
+// Temperature and humidity from the I2C sensors, or the DHT22's state if
+// they have none
+static void apply_env_th(sensor_data *data, uint32_t now_ms) {
+    const env_reading *env = &data->env;
+    if ((env->valid & ENV_TH_BITS) == ENV_TH_BITS) {
+        int32_t humidity_x10 = env->value[ENV_HUMIDITY] < 0 ? 0 : env->value[ENV_HUMIDITY];
+        dht_reading reading = {
+            .humidity = humidity_x10 / 10.0f,
+            .temp = env->value[ENV_TEMP] / 10.0f,
+            .humidity_x10 = (uint16_t)humidity_x10,
+            .temp_x10 = (int16_t)env->value[ENV_TEMP]
+        };
+        apply_th(data, &reading, SOURCE_I2C, now_ms);
+    } else if (data->dht_state != data->dht22_state || data->th_source != SOURCE_NONE) {
+        data->dht_state = data->dht22_state;
+        data->th_source = SOURCE_NONE;
+        data->dht_version++;
+    }
+}
+
+// Take over a CO2 level, with the AQI, statistics and trend that follow it
+static void apply_co2(sensor_data *data, float ppm, sensor_source source, uint32_t now_ms) {
+    if ((int)ppm != (int)data->co2_ppm || source != data->co2_source) {
+        data->co2_version++;
+    }
+    data->co2_ppm = ppm;
+    data->co2_source = source;
+
+    // Calculate AQI
+    data->aqi = calculate_aqi(ppm);
+    stats_add(&data->stats[SENSOR_CH_CO2], (int32_t)(ppm + 0.5f), now_ms);
+    data->stats_version++;
+
+    // Rate of change and when it reaches the limit; the screen only
+    // changes when the direction or the whole minutes do
+    trend_fit fit;
+    trend_add(&data->co2_trend, (int32_t)(ppm + 0.5f), now_ms);
+    bool valid = trend_get(&data->co2_trend, now_ms, &fit);
+    trend_direction direction = TREND_STEADY;
+    int16_t minutes = -1;
+    if (valid) {
+        direction = trend_classify(data->co2_direction, fit.slope_per_min,
+                                   CO2_TREND_ON_PPM_MIN, CO2_TREND_OFF_PPM_MIN);
+        minutes = trend_minutes_to(&fit, CO2_LIMIT_PPM);
+    }
+    if (valid != data->co2_trend_valid || direction != data->co2_direction ||
+        minutes != data->co2_limit_minutes ||
+        (valid && (int)fit.slope_per_min != (int)data->co2_rate)) {
+        data->co2_version++;
+    }
+    data->co2_trend_valid = valid;
+    data->co2_rate = valid ? fit.slope_per_min : 0.0f;
+    data->co2_direction = direction;
+    data->co2_limit_minutes = minutes;
+}
+
+bool sensors_apply_dht(sensor_data *data, const dht_reading *reading, uint32_t now_ms) {
+    if (reading->error) {
+        data->dht22_state = SENSOR_ERROR;
+        if (data->th_source != SOURCE_I2C) {
+            apply_env_th(data, now_ms);
+        }
+        return false;
+    }
+    data->dht22_state = SENSOR_READY;
+    apply_th(data, reading, SOURCE_DHT22, now_ms);
+    return true;
+}
+
+float sensors_apply_adc(sensor_data *data, uint16_t adc_raw, uint32_t now_ms) {
+    float correction = 1.0f;
+    if (data->dht_state == SENSOR_READY) {
+        correction = mq135_correction(data->dht.temp, data->dht.humidity);
+    }
+    float rs = get_resistance(adc_raw);
+    mq135_estimate(rs / (RZERO * correction), data->gas_ppm);
+    data->co2_correction = correction;
+    data->mq135_ok = adc_raw >= MQ135_ADC_RAIL && adc_raw <= ADC_RESOLUTION - MQ135_ADC_RAIL;
+
+    // An I2C CO2 sensor's reading stays while this one is out of range
+    float ppm = data->gas_ppm[MQ135_GAS_CO2];
+    if (data->mq135_ok || !(data->env.valid & (1u << ENV_CO2))) {
+        apply_co2(data, ppm, SOURCE_MQ135, now_ms);
+    }
+    return ppm;
+}
+
+void sensors_apply_env(sensor_data *data, const env_reading *latest, uint8_t updated,
+                       uint32_t now_ms) {
+    bool changed = latest->valid != data->env.valid;
+    for (int q = 0; q < ENV_QUANTITY_COUNT; q++) {
+        if ((updated & (1u << q)) && latest->value[q] != data->env.value[q]) {
+            changed = true;
+        }
+    }
+    if (changed) {
+        data->env_version++;
+    }
+    data->env = *latest;
+
+    if ((updated & ENV_TH_BITS) && data->dht22_state != SENSOR_READY) {
+        apply_env_th(data, now_ms);
+    }
+    if ((updated & (1u << ENV_CO2)) && (data->co2_state != SENSOR_READY || !data->mq135_ok)) {
+        if (latest->valid & (1u << ENV_CO2)) {
+            apply_co2(data, (float)latest->value[ENV_CO2], SOURCE_I2C, now_ms);
+        } else if (data->co2_source == SOURCE_I2C) {
+            // Gone; the warm-up or the next MQ135 reading shows instead
+            data->co2_source = SOURCE_NONE;
+            data->co2_version++;
+        }
+    }
+}
+
+bool sensors_update_warmup(sensor_data *data, uint32_t now_ms,
+                           uint32_t start_ms, uint32_t warmup_ms) {
+    if (data->co2_state != SENSOR_WARMING) {
+        return false;
+    }
+
+    uint32_t elapsed_ms = now_ms - start_ms;
+    if (elapsed_ms >= warmup_ms) {
+        data->co2_state = SENSOR_READY;
+        data->co2_version++;
+        return true;
+    }
+    uint8_t pct = (uint8_t)(elapsed_ms * 100 / warmup_ms);
+    if (pct != data->co2_warmup_pct) {
+        data->co2_warmup_pct = pct;
+        data->co2_version++;
+    }
+    return false;
+}
+
+void sensors_sample(const sensor_data *data, sensor_sample *out) {
+    memset(out, 0, sizeof(*out));
+    out->th_source = data->th_source;
+    out->co2_source = data->co2_source;
+    out->co2_limit_minutes = -1;
+    if (data->dht_state == SENSOR_READY) {
+        out->valid |= SAMPLE_TEMP | SAMPLE_HUMIDITY;
+        out->temp_x10 = data->dht.temp_x10;
+        out->humidity_x10 = data->dht.humidity_x10;
+    }
+    if (data->co2_source != SOURCE_NONE) {
+        out->valid |= SAMPLE_CO2;
+        out->co2_ppm = data->co2_ppm > 65535 ? 65535 : (uint16_t)data->co2_ppm;
+        out->co2_rate_x10 = (int16_t)(data->co2_rate * 10.0f);
+        out->co2_limit_minutes = data->co2_limit_minutes;
+    }
+    if (data->env.valid & (1u << ENV_PRESSURE)) {
+        out->valid |= SAMPLE_PRESSURE;
+        out->pressure_pa = data->env.value[ENV_PRESSURE];
+    }
+}
+
+const char *sensors_source_name(sensor_source source) {
+    return source <= SOURCE_I2C ? source_names[source] : "?";
+}
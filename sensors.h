@@ -0,0 +1,151 @@
+/**
+ * Sensor state shared by acquisition, display and replay
+ *
+ * Raw inputs (decoded DHT22 transfers, MQ135 ADC codes and the warm-up
+ * clock) are applied here, so the firmware and the host replay harness
+ * derive exactly the same sensor_data from the same inputs.
+ *
+ * The I2C sensors stand in for the analog ones: temperature and humidity
+ * come from them while the DHT22 has no good reading, and CO2 while the
+ * MQ135 warms up or reads at an end of the ADC range.
+ */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "comfort.h"
+#include "dht22.h"
+#include "envsensor.h"
+#include "mq135.h"
+#include "stats.h"
+#include "trend.h"
+
+// CO2 level the trend counts down to, and the window it is fitted over
+#define CO2_LIMIT_PPM 1000
+#define CO2_TREND_WINDOW_MS (10 * 60 * 1000)
+
+// Availability of each sensor in the acquisition pipeline
+typedef enum {
+    SENSOR_WARMING,   // Not ready yet, no valid data
+    SENSOR_READY,     // Latest reading is valid
+    SENSOR_ERROR      // Latest reading failed
+} sensor_state;
+
+// Sensor a shown value came from
+typedef enum {
+    SOURCE_NONE,
+    SOURCE_DHT22,
+    SOURCE_MQ135,
+    SOURCE_I2C
+} sensor_source;
+
+// Channels with rolling statistics
+typedef enum {
+    SENSOR_CH_TEMP,         // Tenths of a degree C
+    SENSOR_CH_HUMIDITY,     // Tenths of a percent
+    SENSOR_CH_CO2,          // ppm
+    SENSOR_CH_COUNT
+} sensor_channel;
+
+// Structure to hold all sensor data
+typedef struct {
+    dht_reading dht;          // Temperature and humidity, from th_source
+    comfort_metrics comfort;  // Derived from dht
+    float co2_ppm;
+    float gas_ppm[MQ135_GAS_COUNT];   // All MQ135 estimates, co2_ppm is the CO2 one
+    float co2_correction;     // T/RH correction applied to the last MQ135 reading
+    int aqi;
+    sensor_state dht_state;   // Of dht, whichever sensor it came from
+    sensor_state co2_state;   // Of the MQ135
+    sensor_state dht22_state; // Of the DHT22 itself
+    bool mq135_ok;            // Latest MQ135 reading was within the ADC range
+    sensor_source th_source;
+    sensor_source co2_source;
+    uint8_t co2_warmup_pct;   // Warm-up progress while co2_state is SENSOR_WARMING
+    uint64_t dht_time_us;     // time_us_64() when the last good readings were taken
+    uint64_t co2_time_us;
+    env_reading env;          // Merged from the I2C sensors found at startup
+    stats_channel stats[SENSOR_CH_COUNT];
+    trend_window co2_trend;
+    bool co2_trend_valid;     // Enough samples for the fields below
+    float co2_rate;           // ppm per minute
+    trend_direction co2_direction;
+    int16_t co2_limit_minutes;  // Until the trend crosses CO2_LIMIT_PPM, -1 if it is not heading there
+    
+    // Bumped whenever something the screens show changes
+    uint32_t dht_version;
+    uint32_t co2_version;
+    uint32_t env_version;
+    uint32_t stats_version;
+} sensor_data;
+
+// Quantities a sensor_sample has a reading of
+#define SAMPLE_TEMP (1u << 0)
+#define SAMPLE_HUMIDITY (1u << 1)
+#define SAMPLE_CO2 (1u << 2)        // With its trend
+#define SAMPLE_PRESSURE (1u << 3)
+
+// The values as shown, combined, for history, telemetry and alarms
+typedef struct {
+    uint8_t valid;              // SAMPLE_* bits; fields without a reading are 0
+    uint8_t th_source;          // sensor_source
+    uint8_t co2_source;
+    int16_t temp_x10;           // From the DHT22 or an I2C sensor standing in
+    uint16_t humidity_x10;
+    uint16_t co2_ppm;
+    int16_t co2_rate_x10;       // Trend, tenths of a ppm per minute
+    int16_t co2_limit_minutes;  // Until the trend crosses CO2_LIMIT_PPM, -1 if not heading there
+    int32_t pressure_pa;
+} sensor_sample;
+
+void sensors_init(sensor_data *data);
+
+/**
+ * Apply a DHT22 reading
+ *
+ * A failed reading hands temperature and humidity to the I2C sensors if
+ * they have them.
+ *
+ * @return true if the reading was valid and taken over
+ */
+bool sensors_apply_dht(sensor_data *data, const dht_reading *reading, uint32_t now_ms);
+
+/**
+ * Apply a raw MQ135 ADC code
+ *
+ * Compensated for the latest temperature and humidity when there is a
+ * valid reading, uncorrected otherwise. Not taken over while it is at an
+ * end of the ADC range and an I2C sensor has CO2.
+ *
+ * @return The CO2 estimate in ppm
+ */
+float sensors_apply_adc(sensor_data *data, uint16_t adc_raw, uint32_t now_ms);
+
+/**
+ * Take over the I2C sensors' merged readings
+ *
+ * Their temperature and humidity are used while the DHT22 has no good
+ * reading, their CO2 while the MQ135 is warming up or out of range.
+ *
+ * @param updated Quantities that env_bus_poll() reported as updated
+ */
+void sensors_apply_env(sensor_data *data, const env_reading *latest, uint8_t updated,
+                       uint32_t now_ms);
+
+/**
+ * Advance the MQ135 warm-up
+ *
+ * @return true once, when the warm-up has just finished
+ */
+bool sensors_update_warmup(sensor_data *data, uint32_t now_ms,
+                           uint32_t start_ms, uint32_t warmup_ms);
+
+// The values data shows, with a valid bit for each quantity that has a reading
+void sensors_sample(const sensor_data *data, sensor_sample *out);
+
+// Short name of a source for telemetry, e.g. "dht22"
+const char *sensors_source_name(sensor_source source);
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * Sensirion SHT4x and SHT3x temperature and humidity sensors
+ *
+ * Both run single-shot measurements without clock stretching: the
+ * measure command, a sleep for the conversion time and one read.
+ */
+
+#include "pico/stdlib.h"
+#include "envsensor.h"
+
+#define SHT_PERIOD_MS 2000
+
+#define SHT4X_CMD_MEASURE_HIGH 0xFD     // High precision
+#define SHT4X_CMD_SERIAL 0x89
+#define SHT4X_MEASURE_MS 10             // 8.3 ms max
+
+#define SHT3X_CMD_MEASURE_HIGH 0x2400   // High repeatability, no clock stretching
+#define SHT3X_CMD_STATUS 0xF32D
+#define SHT3X_MEASURE_MS 16             // 15.5 ms max
+
+// Raw ticks to tenths of a degree: -45 + 175 * raw / 65535
+static int32_t sht_temp_x10(uint16_t raw) {
+    return -450 + (int32_t)((1750u * raw + 32767) / 65535);
+}
+
+static bool sht4x_probe(env_sensor *s) {
+    uint8_t cmd = SHT4X_CMD_SERIAL;
+    uint16_t serial[2];
+    if (!env_write(s, &cmd, 1)) {
+        return false;
+    }
+    sleep_ms(1);
+    return env_read_words(s, serial, 2);
+}
+
+static pt_status sht4x_measure(env_sensor *s, env_reading *out) {
+    static const uint8_t cmd = SHT4X_CMD_MEASURE_HIGH;
+    uint16_t raw[2];
+
+    PT_BEGIN(&s->thread);
+    if (!env_write(s, &cmd, 1)) {
+        PT_FAIL(&s->thread);
+    }
+    PT_SLEEP_MS(&s->thread, SHT4X_MEASURE_MS);
+    if (!env_read_words(s, raw, 2)) {
+        PT_FAIL(&s->thread);
+    }
+
+    // -6 + 125 * raw / 65535, which can leave 0..100 % and is clipped
+    int32_t rh = -60 + (int32_t)((1250u * raw[1] + 32767) / 65535);
+    out->value[ENV_TEMP] = sht_temp_x10(raw[0]);
+    out->value[ENV_HUMIDITY] = rh < 0 ? 0 : rh > 1000 ? 1000 : rh;
+    out->valid = 1u << ENV_TEMP | 1u << ENV_HUMIDITY;
+    PT_END(&s->thread);
+}
+
+static bool sht3x_probe(env_sensor *s) {
+    uint16_t status;
+    if (!env_command(s, SHT3X_CMD_STATUS)) {
+        return false;
+    }
+    sleep_ms(1);
+    return env_read_words(s, &status, 1);
+}
+
+static pt_status sht3x_measure(env_sensor *s, env_reading *out) {
+    uint16_t raw[2];
+
+    PT_BEGIN(&s->thread);
+    if (!env_command(s, SHT3X_CMD_MEASURE_HIGH)) {
+        PT_FAIL(&s->thread);
+    }
+    PT_SLEEP_MS(&s->thread, SHT3X_MEASURE_MS);
+    if (!env_read_words(s, raw, 2)) {
+        PT_FAIL(&s->thread);
+    }
+    out->value[ENV_TEMP] = sht_temp_x10(raw[0]);
+    out->value[ENV_HUMIDITY] = (int32_t)((1000u * raw[1] + 32767) / 65535);
+    out->valid = 1u << ENV_TEMP | 1u << ENV_HUMIDITY;
+    PT_END(&s->thread);
+}
+
+const env_driver sht4x_driver = {
+    .name = "SHT4x",
+    .addresses = {0x44, 0x45},
+    .provides = 1u << ENV_TEMP | 1u << ENV_HUMIDITY,
+    .period_ms = SHT_PERIOD_MS,
+    .probe = sht4x_probe,
+    .measure = sht4x_measure
+};
+
+const env_driver sht3x_driver = {
+    .name = "SHT3x",
+    .addresses = {0x44, 0x45},
+    .provides = 1u << ENV_TEMP | 1u << ENV_HUMIDITY,
+    .period_ms = SHT_PERIOD_MS,
+    .probe = sht3x_probe,
+    .measure = sht3x_measure
+};
@@ -0,0 +1,472 @@
+/**
+ * SSD1306 OLED driver
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "log.h"
+#include "ssd1306.h"
+
+// Init sequence for a given multiplex ratio and COM pin configuration,
+// starting with the command control byte so it can be sent as is
+#define SSD1306_INIT_SEQUENCE(mux, com_pins) {                          \
+    OLED_CONTROL_BYTE_CMD,                                              \
+    OLED_CMD_DISPLAY_OFF,                                               \
+    OLED_CMD_SET_DISPLAY_CLOCK_DIV, 0x80,                               \
+    OLED_CMD_SET_MULTIPLEX, (mux),                                      \
+    OLED_CMD_SET_DISPLAY_OFFSET, 0x00,                                  \
+    OLED_CMD_SET_START_LINE | 0x00,                                     \
+    OLED_CMD_CHARGE_PUMP, 0x14,         /* Enable charge pump */        \
+    OLED_CMD_SET_MEMORY_MODE, 0x00,     /* Horizontal addressing */     \
+    OLED_CMD_SEG_REMAP | 0x01,          /* Flip horizontally */         \
+    OLED_CMD_COM_SCAN_DEC,              /* Flip vertically */           \
+    OLED_CMD_SET_COM_PINS, (com_pins),                                  \
+    OLED_CMD_SET_CONTRAST, 0x8F,        /* Medium contrast */           \
+    OLED_CMD_SET_PRECHARGE, 0xF1,                                       \
+    OLED_CMD_SET_VCOM_DETECT, 0x40,                                     \
+    OLED_CMD_DISPLAY_RAM,                                               \
+    OLED_CMD_DISPLAY_NORMAL,                                            \
+    OLED_CMD_DEACTIVATE_SCROLL,                                         \
+    OLED_CMD_DISPLAY_ON                                                 \
+}
+
+static const uint8_t init_128x32[] = SSD1306_INIT_SEQUENCE(0x1F, 0x02);
+static const uint8_t init_128x64[] = SSD1306_INIT_SEQUENCE(0x3F, 0x12);
+
+// 5x8 character set (only including 0-9 and a few symbols to save space),
+// in RAM with the glyph drawing so text rendering makes no flash accesses
+static const uint8_t __not_in_flash("font") font[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, // Space
+    0x00, 0x00, 0x5F, 0x00, 0x00, // !
+    0x00, 0x07, 0x00, 0x07, 0x00, // "
+    0x14, 0x7F, 0x14, 0x7F, 0x14, // #
+    0x24, 0x2A, 0x7F, 0x2A, 0x12, // $
+    0x23, 0x13, 0x08, 0x64, 0x62, // %
+    0x36, 0x49, 0x55, 0x22, 0x50, // &
+    0x00, 0x05, 0x03, 0x00, 0x00, // '
+    0x00, 0x1C, 0x22, 0x41, 0x00, // (
+    0x00, 0x41, 0x22, 0x1C, 0x00, // )
+    0x08, 0x2A, 0x1C, 0x2A, 0x08, // *
+    0x08, 0x08, 0x3E, 0x08, 0x08, // +
+    0x00, 0x50, 0x30, 0x00, 0x00, // ,
+    0x08, 0x08, 0x08, 0x08, 0x08, // -
+    0x00, 0x60, 0x60, 0x00, 0x00, // .
+    0x20, 0x10, 0x08, 0x04, 0x02, // /
+    0x3E, 0x51, 0x49, 0x45, 0x3E, // 0
+    0x00, 0x42, 0x7F, 0x40, 0x00, // 1
+    0x42, 0x61, 0x51, 0x49, 0x46, // 2
+    0x21, 0x41, 0x45, 0x4B, 0x31, // 3
+    0x18, 0x14, 0x12, 0x7F, 0x10, // 4
+    0x27, 0x45, 0x45, 0x45, 0x39, // 5
+    0x3C, 0x4A, 0x49, 0x49, 0x30, // 6
+    0x01, 0x71, 0x09, 0x05, 0x03, // 7
+    0x36, 0x49, 0x49, 0x49, 0x36, // 8
+    0x06, 0x49, 0x49, 0x29, 0x1E, // 9
+    0x00, 0x36, 0x36, 0x00, 0x00, // :
+    0x00, 0x56, 0x36, 0x00, 0x00, // ;
+    0x00, 0x08, 0x14, 0x22, 0x41, // <
+    0x14, 0x14, 0x14, 0x14, 0x14, // =
+    0x41, 0x22, 0x14, 0x08, 0x00, // >
+    0x02, 0x01, 0x51, 0x09, 0x06, // ?
+    0x32, 0x49, 0x79, 0x41, 0x3E, // @
+    0x7E, 0x11, 0x11, 0x11, 0x7E, // A
+    0x7F, 0x49, 0x49, 0x49, 0x36, // B
+    0x3E, 0x41, 0x41, 0x41, 0x22, // C
+    0x7F, 0x41, 0x41, 0x22, 0x1C, // D
+    0x7F, 0x49, 0x49, 0x49, 0x41, // E
+    0x7F, 0x09, 0x09, 0x01, 0x01, // F
+    0x3E, 0x41, 0x41, 0x49, 0x7A, // G
+    0x7F, 0x08, 0x08, 0x08, 0x7F, // H
+    0x00, 0x41, 0x7F, 0x41, 0x00, // I
+    0x20, 0x40, 0x41, 0x3F, 0x01, // J
+    0x7F, 0x08, 0x14, 0x22, 0x41, // K
+    0x7F, 0x40, 0x40, 0x40, 0x40, // L
+    0x7F, 0x02, 0x04, 0x02, 0x7F, // M
+    0x7F, 0x04, 0x08, 0x10, 0x7F, // N
+    0x3E, 0x41, 0x41, 0x41, 0x3E, // O
+    0x7F, 0x09, 0x09, 0x09, 0x06, // P
+    0x3E, 0x41, 0x51, 0x21, 0x5E, // Q
+    0x7F, 0x09, 0x19, 0x29, 0x46, // R
+    0x46, 0x49, 0x49, 0x49, 0x31, // S
+    0x01, 0x01, 0x7F, 0x01, 0x01, // T
+    0x3F, 0x40, 0x40, 0x40, 0x3F, // U
+    0x1F, 0x20, 0x40, 0x20, 0x1F, // V
+    0x7F, 0x20, 0x18, 0x20, 0x7F, // W
+    0x63, 0x14, 0x08, 0x14, 0x63, // X
+    0x03, 0x04, 0x78, 0x04, 0x03, // Y
+    0x61, 0x51, 0x49, 0x45, 0x43, // Z
+};
+
+// The panel on SPI, for the DMA interrupt
+static ssd1306_t *spi_panel = NULL;
+
+static void __not_in_flash_func(record_frame)(ssd1306_t *disp, uint32_t end_us) {
+    uint32_t us = end_us - disp->start_us;
+    disp->timing.frames++;
+    disp->timing.bytes += disp->sending;
+    disp->timing.total_us += us;
+    disp->timing.last_us = us;
+    if (us > disp->timing.max_us) {
+        disp->timing.max_us = us;
+    }
+}
+
+// Ends an SPI frame. The DMA finishes with the last bytes still in the SPI
+// FIFO (8 at most, a few microseconds), so wait for them before releasing CS.
+static void __not_in_flash_func(dma_done)(void) {
+    ssd1306_t *disp = spi_panel;
+    if (disp == NULL || !dma_channel_get_irq0_status(disp->dma_channel)) {
+        return;     // Another channel's interrupt
+    }
+    dma_channel_acknowledge_irq0(disp->dma_channel);
+    while (spi_is_busy(disp->spi)) {
+        tight_loop_contents();
+    }
+    gpio_put(disp->pins.cs, 1);
+    record_frame(disp, time_us_32());
+    disp->busy = false;
+    pt_signal_raise(&disp->done);
+}
+
+static void setup(ssd1306_t *disp, uint8_t height) {
+    disp->i2c = NULL;
+    disp->address = 0;
+    disp->spi = NULL;
+    disp->busy = false;
+    disp->done = (pt_signal){0};
+    disp->timing = (ssd1306_timing){0};
+    disp->width = SSD1306_WIDTH;
+    disp->height = height == 64 ? 64 : 32;
+    disp->pages = disp->height / 8;
+    disp->frame[0] = OLED_CONTROL_BYTE_DATA;
+    disp->buffer = &disp->frame[1];
+    disp->dirty = false;
+    ssd1306_clear(disp);
+}
+
+static bool ssd1306_probe(ssd1306_t *disp, uint8_t address) {
+    uint8_t buf[2] = {OLED_CONTROL_BYTE_CMD, OLED_CMD_DISPLAY_OFF};
+    if (i2c_write_blocking(disp->i2c, address, buf, 2, false) < 0) {
+        return false;
+    }
+    disp->address = address;
+    return true;
+}
+
+bool ssd1306_init(ssd1306_t *disp, i2c_inst_t *i2c, uint8_t height) {
+    setup(disp, height);
+    disp->bus = SSD1306_BUS_I2C;
+    disp->i2c = i2c;
+
+    // Check if OLED is responding at either address
+    if (!ssd1306_probe(disp, SSD1306_ADDRESS_1) && !ssd1306_probe(disp, SSD1306_ADDRESS_2)) {
+        LOG_WARN("OLED not responding at address 0x%02X or 0x%02X",
+                 SSD1306_ADDRESS_1, SSD1306_ADDRESS_2);
+        return false;
+    }
+
+    LOG_INFO("OLED responding at address 0x%02X (%dx%d)", disp->address, disp->width,
+             disp->height);
+
+    // Whole init sequence in a single transaction
+    const uint8_t *init = disp->height == 64 ? init_128x64 : init_128x32;
+    int len = disp->height == 64 ? (int)sizeof(init_128x64) : (int)sizeof(init_128x32);
+    if (i2c_write_blocking(disp->i2c, disp->address, init, len, false) != len) {
+        LOG_ERROR("OLED at 0x%02X did not take its init sequence", disp->address);
+        return false;
+    }
+
+    return true;
+}
+
+// Commands over SPI, with D/C low while they are sent
+static void spi_commands(ssd1306_t *disp, const uint8_t *cmds, int len) {
+    ssd1306_wait(disp);
+    gpio_put(disp->pins.dc, 0);
+    gpio_put(disp->pins.cs, 0);
+    spi_write_blocking(disp->spi, cmds, len);
+    gpio_put(disp->pins.cs, 1);
+}
+
+bool ssd1306_init_spi(ssd1306_t *disp, spi_inst_t *spi, const ssd1306_spi_pins *pins,
+                      uint8_t height) {
+    setup(disp, height);
+    disp->bus = SSD1306_BUS_SPI;
+    disp->spi = spi;
+    disp->spi_hz = spi_get_baudrate(spi);
+    disp->pins = *pins;
+
+    int channel = dma_claim_unused_channel(false);
+    if (channel < 0) {
+        LOG_ERROR("OLED: no free DMA channel");
+        return false;
+    }
+    disp->dma_channel = channel;
+
+    // Bytes from the framebuffer into the SPI FIFO, paced by its DREQ
+    dma_channel_config config = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, spi_get_dreq(spi, true));
+    dma_channel_configure(channel, &config, &spi_get_hw(spi)->dr, NULL, 0, false);
+
+    spi_panel = disp;
+    dma_channel_set_irq0_enabled(channel, true);
+    irq_add_shared_handler(DMA_IRQ_0, dma_done, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    const uint8_t outputs[] = {pins->cs, pins->dc, pins->reset};
+    for (int i = 0; i < (int)sizeof(outputs); i++) {
+        gpio_init(outputs[i]);
+        gpio_set_dir(outputs[i], GPIO_OUT);
+        gpio_put(outputs[i], 1);
+    }
+
+    // Reset pulse (at least 3 us low)
+    sleep_ms(1);
+    gpio_put(pins->reset, 0);
+    sleep_ms(1);
+    gpio_put(pins->reset, 1);
+    sleep_ms(1);
+
+    LOG_INFO("OLED on SPI at %lu kHz (%dx%d)", (unsigned long)(disp->spi_hz / 1000), disp->width,
+             disp->height);
+
+    // Same init sequence, without the I2C control byte
+    if (disp->height == 64) {
+        spi_commands(disp, &init_128x64[1], sizeof(init_128x64) - 1);
+    } else {
+        spi_commands(disp, &init_128x32[1], sizeof(init_128x32) - 1);
+    }
+
+    return true;
+}
+
+void ssd1306_wait(ssd1306_t *disp) {
+    // A raise between the check and __wfe() leaves the event set, so the
+    // __wfe() returns at once
+    while (disp->busy) {
+        __wfe();
+    }
+}
+
+void ssd1306_cmd(ssd1306_t *disp, uint8_t cmd) {
+    if (disp->bus == SSD1306_BUS_SPI) {
+        spi_commands(disp, &cmd, 1);
+        return;
+    }
+    uint8_t buf[2] = {OLED_CONTROL_BYTE_CMD, cmd};
+    i2c_write_blocking(disp->i2c, disp->address, buf, 2, false);
+}
+
+void ssd1306_cmd_list(ssd1306_t *disp, const uint8_t *cmds, int len) {
+    if (disp->bus == SSD1306_BUS_SPI) {
+        spi_commands(disp, cmds, len);
+        return;
+    }
+    uint8_t buf[32];
+    buf[0] = OLED_CONTROL_BYTE_CMD;
+    while (len > 0) {
+        int chunk = len < (int)sizeof(buf) - 1 ? len : (int)sizeof(buf) - 1;
+        memcpy(&buf[1], cmds, chunk);
+        i2c_write_blocking(disp->i2c, disp->address, buf, chunk + 1, false);
+        cmds += chunk;
+        len -= chunk;
+    }
+}
+
+void ssd1306_clear(ssd1306_t *disp) {
+    memset(disp->buffer, 0, disp->width * disp->pages);
+    ssd1306_mark_dirty(disp, 0, 0, disp->width, disp->height);
+}
+
+void ssd1306_mark_dirty(ssd1306_t *disp, int x, int y, int w, int h) {
+    // Clip to the panel
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > disp->width) w = disp->width - x;
+    if (y + h > disp->height) h = disp->height - y;
+    if (w <= 0 || h <= 0) return;
+
+    uint8_t x0 = x, x1 = x + w - 1;
+    uint8_t p0 = y / 8, p1 = (y + h - 1) / 8;
+    if (!disp->dirty) {
+        disp->dirty = true;
+        disp->dirty_x0 = x0;
+        disp->dirty_x1 = x1;
+        disp->dirty_p0 = p0;
+        disp->dirty_p1 = p1;
+        return;
+    }
+    if (x0 < disp->dirty_x0) disp->dirty_x0 = x0;
+    if (x1 > disp->dirty_x1) disp->dirty_x1 = x1;
+    if (p0 < disp->dirty_p0) disp->dirty_p0 = p0;
+    if (p1 > disp->dirty_p1) disp->dirty_p1 = p1;
+}
+
+// Full-width rows of pages p0 to p1, contiguous in the framebuffer, in one
+// transfer. Over SPI this only starts the DMA.
+static bool send_pages(ssd1306_t *disp, int p0, int p1) {
+    const uint8_t window[] = {
+        OLED_CMD_COLUMN_ADDR, 0, disp->width - 1,
+        OLED_CMD_PAGE_ADDR, p0, p1
+    };
+    ssd1306_cmd_list(disp, window, sizeof(window));
+
+    uint8_t *start = &disp->buffer[p0 * disp->width];
+    int len = (p1 - p0 + 1) * disp->width;
+    disp->sending = len;
+    if (disp->bus == SSD1306_BUS_SPI) {
+        gpio_put(disp->pins.dc, 1);
+        gpio_put(disp->pins.cs, 0);
+        disp->busy = true;
+        dma_channel_transfer_from_buffer_now(disp->dma_channel, start, len);
+        return true;
+    }
+
+    // Borrow the byte before the first page for the control byte (for the
+    // first page that is frame[0], the control byte already)
+    uint8_t saved = start[-1];
+    start[-1] = OLED_CONTROL_BYTE_DATA;
+    int written = i2c_write_blocking(disp->i2c, disp->address, start - 1, 1 + len, false);
+    start[-1] = saved;
+    record_frame(disp, time_us_32());
+    return written >= 0;
+}
+
+bool ssd1306_display(ssd1306_t *disp) {
+    ssd1306_wait(disp);
+    disp->start_us = time_us_32();
+    disp->dirty = false;
+    return send_pages(disp, 0, disp->pages - 1);
+}
+
+bool ssd1306_flush(ssd1306_t *disp) {
+    if (!disp->dirty) {
+        return true;
+    }
+    ssd1306_wait(disp);
+    disp->start_us = time_us_32();
+    disp->dirty = false;
+
+    // Over SPI a narrower window also goes out as whole rows: a few more
+    // bytes at SPI speed cost less than a DMA transfer per page
+    if (disp->bus == SSD1306_BUS_SPI ||
+        (disp->dirty_x0 == 0 && disp->dirty_x1 == disp->width - 1)) {
+        return send_pages(disp, disp->dirty_p0, disp->dirty_p1);
+    }
+
+    const uint8_t window[] = {
+        OLED_CMD_COLUMN_ADDR, disp->dirty_x0, disp->dirty_x1,
+        OLED_CMD_PAGE_ADDR, disp->dirty_p0, disp->dirty_p1
+    };
+    ssd1306_cmd_list(disp, window, sizeof(window));
+
+    // The panel's address pointer carries on between transactions, so each
+    // page slice of the window is sent on its own
+    uint8_t buf[1 + SSD1306_WIDTH];
+    int len = disp->dirty_x1 - disp->dirty_x0 + 1;
+    bool ack = true;
+    buf[0] = OLED_CONTROL_BYTE_DATA;
+    for (int page = disp->dirty_p0; page <= disp->dirty_p1; page++) {
+        memcpy(&buf[1], &disp->buffer[page * disp->width + disp->dirty_x0], len);
+        if (i2c_write_blocking(disp->i2c, disp->address, buf, 1 + len, false) < 0) {
+            ack = false;
+        }
+    }
+    disp->sending = len * (disp->dirty_p1 - disp->dirty_p0 + 1);
+    record_frame(disp, time_us_32());
+    return ack;
+}
+
+void ssd1306_print_timing(const ssd1306_t *disp) {
+    if (disp->bus == SSD1306_BUS_SPI) {
+        printf("OLED: SPI at %lu kHz, DMA channel %d\n",
+               (unsigned long)(disp->spi_hz / 1000), disp->dma_channel);
+    } else {
+        printf("OLED: I2C at address 0x%02X\n", disp->address);
+    }
+    uint32_t frames = disp->timing.frames;
+    printf("  %lu flushes, %lu bytes, last %lu us, mean %lu us, max %lu us\n",
+           (unsigned long)frames, (unsigned long)disp->timing.bytes,
+           (unsigned long)disp->timing.last_us,
+           (unsigned long)(frames > 0 ? disp->timing.total_us / frames : 0),
+           (unsigned long)disp->timing.max_us);
+}
+
+void __not_in_flash_func(draw_char)(ssd1306_t *disp, int x, int y, char c) {
+    // Space is ASCII 32, first char in our font
+    if (c < 32 || c > 90) {  // Only have space through Z in our font
+        c = 32;  // Default to space
+    }
+
+    c -= 32;  // Adjust for font table
+
+    // Each character is 5 pixels wide
+    for (int i = 0; i < 5; i++) {
+        uint8_t line = font[c * 5 + i];
+        for (int j = 0; j < 8; j++) {
+            if (line & (1 << j)) {
+                // Calculate which page and bit
+                int page = (y + j) / 8;
+                int bit = (y + j) % 8;
+
+                // Set the pixel if it's within bounds
+                if (page >= 0 && page < disp->pages && x+i >= 0 && x+i < disp->width) {
+                    disp->buffer[page * disp->width + x + i] |= (1 << bit);
+                }
+            }
+        }
+    }
+}
+
+void draw_string(ssd1306_t *disp, int x, int y, const char* str) {
+    while (*str) {
+        draw_char(disp, x, y, *str++);
+        x += 6;  // 5 pixels + 1 spacing
+    }
+}
+
+void __not_in_flash_func(draw_char_2x)(ssd1306_t *disp, int x, int y, char c) {
+    // Space is ASCII 32, first char in our font
+    if (c < 32 || c > 90) {  // Only have space through Z in our font
+        c = 32;  // Default to space
+    }
+
+    c -= 32;  // Adjust for font table
+
+    // Each character is 5 pixels wide
+    for (int i = 0; i < 5; i++) {
+        uint8_t line = font[c * 5 + i];
+        for (int j = 0; j < 8; j++) {
+            if (line & (1 << j)) {
+                // Draw 2x2 pixels for each bit that's set
+                for (int dx = 0; dx <= 1; dx++) {
+                    for (int dy = 0; dy <= 1; dy++) {
+                        int page = (y + j*2 + dy) / 8;
+                        int bit = (y + j*2 + dy) % 8;
+
+                        if (page >= 0 && page < disp->pages &&
+                            x + i*2 + dx >= 0 && x + i*2 + dx < disp->width) {
+                            disp->buffer[page * disp->width + x + i*2 + dx] |= (1 << bit);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void draw_string_2x(ssd1306_t *disp, int x, int y, const char* str) {
+    while (*str) {
+        draw_char_2x(disp, x, y, *str++);
+        x += 12;  // 10 pixels (5*2) + 2 spacing
+    }
+}
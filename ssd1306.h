@@ -0,0 +1,164 @@
+/**
+ * SSD1306 OLED driver
+ *
+ * Drives 128x32 (0.91") and 128x64 (0.96") SSD1306 panels over I2C or
+ * 4-wire SPI. The init sequence is a constant command list sent in one
+ * transaction. On I2C both common addresses (0x3C, 0x3D) are probed; the
+ * SPI interface is write-only, so an SPI panel is chosen at build time.
+ *
+ * On SPI the framebuffer goes out by DMA: ssd1306_flush() starts the
+ * transfer and returns, and the DMA interrupt ends it. Drawing into the
+ * framebuffer meanwhile is fine, whatever changes is marked dirty and
+ * sent with the next flush. Commands wait for a transfer in flight.
+ *
+ * The driver keeps a dirty rectangle (whole columns by whole pages) so
+ * ssd1306_flush() only sends what changed. Clearing and the gfx.h
+ * primitives mark their area; the draw_* helpers do not, so callers mark
+ * what they draw.
+ */
+
+#ifndef SSD1306_H
+#define SSD1306_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "pt.h"
+
+#define SSD1306_WIDTH 128
+#define SSD1306_MAX_HEIGHT 64
+#define SSD1306_MAX_PAGES (SSD1306_MAX_HEIGHT / 8)
+
+#define SSD1306_ADDRESS_1 0x3C
+#define SSD1306_ADDRESS_2 0x3D
+
+// Control bytes
+#define OLED_CONTROL_BYTE_CMD 0x00
+#define OLED_CONTROL_BYTE_DATA 0x40
+
+// Commands
+#define OLED_CMD_DISPLAY_OFF 0xAE
+#define OLED_CMD_DISPLAY_ON 0xAF
+#define OLED_CMD_DISPLAY_RAM 0xA4
+#define OLED_CMD_DISPLAY_NORMAL 0xA6
+#define OLED_CMD_DISPLAY_INVERSE 0xA7
+#define OLED_CMD_SET_CONTRAST 0x81
+#define OLED_CMD_SET_MEMORY_MODE 0x20
+#define OLED_CMD_SET_DISPLAY_OFFSET 0xD3
+#define OLED_CMD_SET_START_LINE 0x40
+#define OLED_CMD_SEG_REMAP 0xA0
+#define OLED_CMD_COM_SCAN_DEC 0xC8
+#define OLED_CMD_SET_DISPLAY_CLOCK_DIV 0xD5
+#define OLED_CMD_SET_PRECHARGE 0xD9
+#define OLED_CMD_SET_VCOM_DETECT 0xDB
+#define OLED_CMD_SET_MULTIPLEX 0xA8
+#define OLED_CMD_CHARGE_PUMP 0x8D
+#define OLED_CMD_SET_COM_PINS 0xDA
+#define OLED_CMD_COLUMN_ADDR 0x21
+#define OLED_CMD_PAGE_ADDR 0x22
+#define OLED_CMD_DEACTIVATE_SCROLL 0x2E
+
+typedef enum {
+    SSD1306_BUS_I2C,
+    SSD1306_BUS_SPI
+} ssd1306_bus;
+
+// GPIOs of an SPI panel besides SCK and MOSI (set to the SPI function by
+// the caller)
+typedef struct {
+    uint8_t cs;
+    uint8_t dc;             // Low for commands, high for GDDRAM data
+    uint8_t reset;
+} ssd1306_spi_pins;
+
+// Time from the start of a flush until its last byte is on the wire
+typedef struct {
+    uint32_t frames;
+    uint32_t bytes;         // Framebuffer bytes sent
+    uint64_t total_us;
+    uint32_t last_us;
+    uint32_t max_us;
+} ssd1306_timing;
+
+typedef struct {
+    ssd1306_bus bus;
+    i2c_inst_t *i2c;
+    uint8_t address;        // Detected I2C address, 0 if none or SPI
+    spi_inst_t *spi;
+    uint32_t spi_hz;
+    ssd1306_spi_pins pins;
+    int dma_channel;
+    volatile bool busy;         // DMA transfer in flight
+    pt_signal done;             // Raised when a DMA transfer ends
+    uint32_t start_us;          // Of the flush in flight
+    uint32_t sending;           // Bytes of the flush in flight
+    volatile ssd1306_timing timing;
+    uint8_t width;
+    uint8_t height;
+    uint8_t pages;
+    uint8_t *buffer;        // Page-ordered framebuffer, width * pages bytes
+    bool dirty;             // Area below needs sending
+    uint8_t dirty_x0, dirty_x1;     // Columns, inclusive
+    uint8_t dirty_p0, dirty_p1;     // Pages, inclusive
+    // Data control byte followed by the framebuffer, so a frame goes out
+    // in one transaction without copying
+    uint8_t frame[1 + SSD1306_WIDTH * SSD1306_MAX_PAGES];
+} ssd1306_t;
+
+/**
+ * Probe both addresses and initialise the panel
+ *
+ * @param height Panel height in pixels, 32 or 64
+ * @return true if a panel answered and took its init sequence
+ */
+bool ssd1306_init(ssd1306_t *disp, i2c_inst_t *i2c, uint8_t height);
+
+/**
+ * Initialise a panel on SPI, reset through its reset pin
+ *
+ * Claims a DMA channel and shares DMA_IRQ_0. Only one SPI panel is
+ * supported.
+ *
+ * @param spi Initialised with spi_init(), mode 0 (the SSD1306 takes up to
+ *            10 MHz)
+ * @param height Panel height in pixels, 32 or 64
+ * @return false if no DMA channel is free
+ */
+bool ssd1306_init_spi(ssd1306_t *disp, spi_inst_t *spi, const ssd1306_spi_pins *pins,
+                      uint8_t height);
+
+void ssd1306_cmd(ssd1306_t *disp, uint8_t cmd);
+void ssd1306_cmd_list(ssd1306_t *disp, const uint8_t *cmds, int len);
+void ssd1306_clear(ssd1306_t *disp);
+
+// Add a pixel rectangle to the area ssd1306_flush() sends
+void ssd1306_mark_dirty(ssd1306_t *disp, int x, int y, int w, int h);
+
+/**
+ * Send the whole framebuffer to the panel
+ *
+ * @return false if the panel did not acknowledge the frame
+ */
+bool ssd1306_display(ssd1306_t *disp);
+
+/**
+ * Send only the dirty area, nothing at all if it is clean
+ *
+ * @return false if the panel did not acknowledge the data
+ */
+bool ssd1306_flush(ssd1306_t *disp);
+
+// Block until an SPI transfer in flight is on the wire (no-op on I2C).
+// Sleeps in __wfe() until the DMA interrupt raises disp->done.
+void ssd1306_wait(ssd1306_t *disp);
+
+// Transport and flush times for the "oled" console command
+void ssd1306_print_timing(const ssd1306_t *disp);
+
+void draw_char(ssd1306_t *disp, int x, int y, char c);
+void draw_string(ssd1306_t *disp, int x, int y, const char* str);
+void draw_char_2x(ssd1306_t *disp, int x, int y, char c);
+void draw_string_2x(ssd1306_t *disp, int x, int y, const char* str);
+
+#endif
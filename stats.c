@@ -0,0 +1,139 @@
+/**
+ * Sliding-window statistics
+ */
+
+#include <math.h>
+#include <string.h>
+#include "stats.h"
+
+// Bucket width of each window: STATS_BUCKETS buckets span the window
+static const uint32_t window_ms[STATS_WINDOW_COUNT] = {
+    5 * 60 * 1000,
+    60 * 60 * 1000,
+    24 * 60 * 60 * 1000
+};
+
+static const char *const window_names[STATS_WINDOW_COUNT] = {"5M", "1H", "24H"};
+
+static void bucket_reset(stats_bucket *b) {
+    memset(b, 0, sizeof(*b));
+}
+
+static void deque_push(stats_deque *q, int32_t value, uint32_t seq, bool keep_min) {
+    // Drop entries the new value dominates; they can never be the extreme again
+    while (q->len > 0) {
+        int32_t back = q->entries[(q->head + q->len - 1) % STATS_BUCKETS].value;
+        if (keep_min ? back < value : back > value) break;
+        q->len--;
+    }
+    q->entries[(q->head + q->len) % STATS_BUCKETS] = (stats_extreme){value, seq};
+    q->len++;
+}
+
+static void deque_expire(stats_deque *q, uint32_t oldest_seq) {
+    while (q->len > 0 && (int32_t)(q->entries[q->head].seq - oldest_seq) < 0) {
+        q->head = (q->head + 1) % STATS_BUCKETS;
+        q->len--;
+    }
+}
+
+// Move the open bucket with sequence number seq into the ring
+static void window_close_bucket(stats_window *w, uint32_t seq, bool evicted) {
+    stats_bucket *slot = &w->ring[seq % STATS_BUCKETS];
+
+    // The slot holds the bucket leaving the window
+    if (evicted) {
+        w->total.sum -= slot->sum;
+        w->total.sum_sq -= slot->sum_sq;
+        w->total.count -= slot->count;
+    }
+
+    *slot = w->open;
+    w->total.sum += slot->sum;
+    w->total.sum_sq += slot->sum_sq;
+    w->total.count += slot->count;
+    if (slot->count > 0) {
+        deque_push(&w->min_q, slot->min, seq, true);
+        deque_push(&w->max_q, slot->max, seq, false);
+    }
+    bucket_reset(&w->open);
+
+    uint32_t oldest_seq = w->clock.seq - w->clock.closed;
+    deque_expire(&w->min_q, oldest_seq);
+    deque_expire(&w->max_q, oldest_seq);
+}
+
+// Roll the window forward to the bucket containing now_ms
+static void window_advance(stats_window *w, uint32_t now_ms) {
+    if (!bucket_ring_keep(&w->clock, now_ms)) {
+        bucket_ring clock = w->clock;
+        memset(w, 0, sizeof(*w));
+        w->clock = clock;
+    }
+    uint32_t seq;
+    bool evicted;
+    while (bucket_ring_close(&w->clock, now_ms, &seq, &evicted)) {
+        window_close_bucket(w, seq, evicted);
+    }
+}
+
+void stats_init(stats_channel *ch) {
+    memset(ch, 0, sizeof(*ch));
+    for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+        bucket_ring_init(&ch->windows[i].clock, window_ms[i], STATS_BUCKETS);
+    }
+}
+
+void stats_add(stats_channel *ch, int32_t value, uint32_t now_ms) {
+    for (int i = 0; i < STATS_WINDOW_COUNT; i++) {
+        stats_window *w = &ch->windows[i];
+        window_advance(w, now_ms);
+
+        stats_bucket *b = &w->open;
+        if (b->count == 0 || value < b->min) b->min = value;
+        if (b->count == 0 || value > b->max) b->max = value;
+        b->sum += value;
+        b->sum_sq += (uint64_t)((int64_t)value * value);
+        b->count++;
+    }
+}
+
+bool stats_get(stats_channel *ch, stats_window_id window, uint32_t now_ms,
+               stats_summary *out) {
+    stats_window *w = &ch->windows[window];
+    if (!w->clock.started) {
+        return false;
+    }
+    window_advance(w, now_ms);
+
+    int64_t sum = w->total.sum + w->open.sum;
+    uint64_t sum_sq = w->total.sum_sq + w->open.sum_sq;
+    uint32_t n = w->total.count + w->open.count;
+    if (n == 0) {
+        return false;
+    }
+
+    bool have_closed = w->min_q.len > 0;
+    bool have_open = w->open.count > 0;
+    int32_t min = have_closed ? w->min_q.entries[w->min_q.head].value : w->open.min;
+    int32_t max = have_closed ? w->max_q.entries[w->max_q.head].value : w->open.max;
+    if (have_open && w->open.min < min) min = w->open.min;
+    if (have_open && w->open.max > max) max = w->open.max;
+
+    // Sums are exact; only this final step is done in floating point since
+    // n * sum_sq can overflow 64 bits over a full day of large readings
+    double mean = (double)sum / n;
+    double variance = (double)sum_sq / n - mean * mean;
+    int64_t half = sum >= 0 ? n / 2 : -(int64_t)(n / 2);
+
+    out->count = n;
+    out->min = min;
+    out->max = max;
+    out->mean = (int32_t)((sum + half) / n);
+    out->stddev = variance > 0 ? (int32_t)sqrt(variance) : 0;
+    return true;
+}
+
+const char *stats_window_name(stats_window_id window) {
+    return window < STATS_WINDOW_COUNT ? window_names[window] : "?";
+}
@@ -0,0 +1,98 @@
+/**
+ * Sliding-window statistics
+ *
+ * Rolling min/max/mean/stddev over the last 5 minutes, 1 hour and 24 hours
+ * of one channel. Each window is a ring of STATS_BUCKETS fixed-width time
+ * buckets plus the bucket currently being filled, stepped by buckets.h:
+ *
+ *   - count, sum and sum of squares are kept as running totals over the
+ *     ring; a bucket's totals are added when it closes and subtracted when
+ *     it falls out of the window
+ *   - min and max come from monotonic deques of closed-bucket extremes, so
+ *     the front of each deque is always the extreme of the whole ring
+ *
+ * Every update is O(1) amortised and memory is fixed. Values are fixed
+ * point integers (e.g. tenths of a degree) and sums are exact 64-bit
+ * integers, so there is no float drift over a long-running window.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "buckets.h"
+
+// Closed buckets per window; the window spans this many buckets plus the open one
+#define STATS_BUCKETS 30
+
+typedef enum {
+    STATS_5MIN,
+    STATS_1HOUR,
+    STATS_24HOUR,
+    STATS_WINDOW_COUNT
+} stats_window_id;
+
+// Running totals of one bucket
+typedef struct {
+    int64_t sum;
+    uint64_t sum_sq;
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+} stats_bucket;
+
+// Deque entry: a closed bucket's extreme and its sequence number
+typedef struct {
+    int32_t value;
+    uint32_t seq;
+} stats_extreme;
+
+// Monotonic deque over the closed buckets, stored as a ring
+typedef struct {
+    stats_extreme entries[STATS_BUCKETS];
+    uint8_t head;
+    uint8_t len;
+} stats_deque;
+
+typedef struct {
+    bucket_ring clock;
+    stats_bucket open;
+    stats_bucket ring[STATS_BUCKETS];   // Closed buckets, indexed by seq % STATS_BUCKETS
+    stats_bucket total;                 // Totals over the ring (min/max unused)
+    stats_deque min_q;                  // Ascending values
+    stats_deque max_q;                  // Descending values
+} stats_window;
+
+// All windows of one channel
+typedef struct {
+    stats_window windows[STATS_WINDOW_COUNT];
+} stats_channel;
+
+typedef struct {
+    uint32_t count;     // Samples in the window
+    int32_t min;
+    int32_t max;
+    int32_t mean;       // Rounded to the nearest unit
+    int32_t stddev;     // Population standard deviation, rounded down
+} stats_summary;
+
+void stats_init(stats_channel *ch);
+
+// Add a sample taken at now_ms
+void stats_add(stats_channel *ch, int32_t value, uint32_t now_ms);
+
+/**
+ * Summarise one window as of now_ms
+ *
+ * Expired buckets are dropped first, so the result is current even if no
+ * samples were added for a while.
+ *
+ * @return false if the window holds no samples
+ */
+bool stats_get(stats_channel *ch, stats_window_id window, uint32_t now_ms,
+               stats_summary *out);
+
+const char *stats_window_name(stats_window_id window);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * Clock synchronisation with a host
+ */
+
+#include <string.h>
+#include "timesync.h"
+
+void timesync_init(timesync *ts) {
+    memset(ts, 0, sizeof(*ts));
+}
+
+// Least-squares fit of offset against local time over the usable points
+static void refit(timesync *ts) {
+    uint32_t best_rtt = UINT32_MAX;
+    for (int i = 0; i < ts->count; i++) {
+        if (ts->points[i].rtt_us < best_rtt) best_rtt = ts->points[i].rtt_us;
+    }
+    uint64_t max_rtt = (uint64_t)best_rtt * TIMESYNC_RTT_FILTER + 1000;
+
+    // Newest point is the reference so the fitted offset is current
+    const timesync_point *newest = &ts->points[(ts->next + TIMESYNC_POINTS - 1) % TIMESYNC_POINTS];
+    int64_t ref = newest->local_us;
+
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int i = 0; i < ts->count; i++) {
+        const timesync_point *p = &ts->points[i];
+        if (p->rtt_us > max_rtt) continue;
+        double x = (double)(p->local_us - ref);
+        double y = (double)(p->offset_us - newest->offset_us);
+        n += 1;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+
+    double drift = 0;
+    double intercept = n > 0 ? sy / n : 0;
+    double denom = n * sxx - sx * sx;
+    if (n >= 2 && denom > 0) {
+        drift = (n * sxy - sx * sy) / denom;
+        intercept = (sy - drift * sx) / n;
+    }
+
+    ts->ref_us = ref;
+    ts->offset_us = newest->offset_us + (int64_t)(intercept >= 0 ? intercept + 0.5 : intercept - 0.5);
+    ts->drift = drift;
+    ts->valid = true;
+}
+
+bool timesync_add(timesync *ts, int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (rtt < 0 || t3 < t2) {
+        return false;
+    }
+
+    timesync_point *p = &ts->points[ts->next];
+    p->local_us = t2 + (t3 - t2) / 2;
+    p->offset_us = ((t1 - t2) + (t4 - t3)) / 2;
+    p->rtt_us = rtt > UINT32_MAX ? UINT32_MAX : (uint32_t)rtt;
+
+    ts->next = (ts->next + 1) % TIMESYNC_POINTS;
+    if (ts->count < TIMESYNC_POINTS) ts->count++;
+
+    refit(ts);
+    return true;
+}
+
+bool timesync_to_host(const timesync *ts, int64_t local_us, int64_t *host_us) {
+    if (!ts->valid) {
+        return false;
+    }
+    double dx = (double)(local_us - ts->ref_us);
+    *host_us = local_us + ts->offset_us + (int64_t)(ts->drift * dx);
+    return true;
+}
+
+int32_t timesync_drift_ppb(const timesync *ts) {
+    return (int32_t)(ts->drift * 1e9);
+}
@@ -0,0 +1,66 @@
+/**
+ * Clock synchronisation with a host
+ *
+ * The host and the device exchange timestamps NTP-style:
+ *
+ *   t1  host sends a request       (host clock)
+ *   t2  device receives it         (device clock)
+ *   t3  device sends the reply     (device clock)
+ *   t4  host receives the reply    (host clock)
+ *
+ * Each exchange gives an offset estimate ((t1 - t2) + (t4 - t3)) / 2 with
+ * an error of at most half the round trip. The last TIMESYNC_POINTS
+ * exchanges are kept; those with a round trip much longer than the best
+ * one are ignored, and a least-squares line through the rest gives the
+ * offset and the drift of the device clock against the host.
+ */
+
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMESYNC_POINTS 16
+
+// Exchanges with a round trip above this multiple of the best are outliers
+#define TIMESYNC_RTT_FILTER 2
+
+typedef struct {
+    int64_t local_us;       // Middle of the exchange on the device clock
+    int64_t offset_us;      // Host minus device clock
+    uint32_t rtt_us;        // Round trip without the device's own delay
+} timesync_point;
+
+typedef struct {
+    timesync_point points[TIMESYNC_POINTS];
+    uint8_t count;
+    uint8_t next;
+
+    // host = local + offset_us + drift * (local - ref_us)
+    bool valid;
+    int64_t ref_us;
+    int64_t offset_us;
+    double drift;
+} timesync;
+
+void timesync_init(timesync *ts);
+
+/**
+ * Add one completed exchange and refit
+ *
+ * @return false if the timestamps are inconsistent (negative round trip)
+ */
+bool timesync_add(timesync *ts, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+/**
+ * Convert a device timestamp to host time
+ *
+ * @return false until at least one exchange was added
+ */
+bool timesync_to_host(const timesync *ts, int64_t local_us, int64_t *host_us);
+
+// Drift of the device clock in parts per billion (positive: device runs slow)
+int32_t timesync_drift_ppb(const timesync *ts);
+
+#endif
@@ -0,0 +1,888 @@
+/**
+ * Columnar sample archive and query tool
+ *
+ * Keeps samples collected from many devices in column files and answers
+ * time range and group-by queries over them: minimum, mean and maximum
+ * per channel, minutes above a CO2 limit and the CO2/humidity
+ * correlation, per node, day or hour.
+ *
+ * Archive files (.col) hold one node's samples in time order:
+ *
+ *   header (64 bytes)  magic "EMBCOL1", node (u32), rows (u32),
+ *                      t_min, t_max (i64), column offsets (u32 x 5)
+ *   t         i64 x rows   Unix time in ms
+ *   temp      i16 x rows   tenths of a degree C
+ *   humidity  u16 x rows   tenths of a percent
+ *   co2       u16 x rows   ppm, 0 while the sensor was not ready
+ *   aqi       u16 x rows
+ *
+ * All little-endian, every column on a 64-byte boundary, so queries work
+ * on the memory-mapped file in place. Files are shared out between
+ * threads; within a file the time range and each day or hour are found
+ * by binary search on t, and the aggregate kernel runs 8 rows at a time
+ * on the compiler's vector extensions (SSE/AVX or NEON, whatever the
+ * target has). --check runs a plain scalar kernel alongside and compares.
+ *
+ * Usage:
+ *   colquery import <node> <out.col> <serial.log>
+ *       From the "#D" lines of timesync.py --data output (host time)
+ *   colquery synth <dir> [nodes] [days] [interval_s]
+ *       Synthetic archive, one file per node and 30 days
+ *   colquery query [--from T] [--to T] [--by none|node|day|hour|node,day|node,hour]
+ *                  [--node N] [--limit ppm] [--threads N] [--check] files...
+ *       T is YYYY-MM-DD, YYYY-MM-DDTHH:MM (UTC) or Unix seconds
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mq135.h"
+
+#define COL_MAGIC "EMBCOL1"
+#define COL_ALIGN 64
+
+#define MS_PER_HOUR 3600000LL
+#define MS_PER_DAY 86400000LL
+
+// Gaps longer than this do not count towards time above the CO2 limit
+#define MAX_GAP_MS 300000
+
+#define DEFAULT_LIMIT_PPM 1000
+#define MAX_GROUPS 10000000
+
+typedef enum {
+    COL_T,
+    COL_TEMP,
+    COL_HUMIDITY,
+    COL_CO2,
+    COL_AQI,
+    COL_COUNT
+} column;
+
+typedef struct {
+    char magic[8];
+    uint32_t node;
+    uint32_t rows;
+    int64_t t_min;
+    int64_t t_max;
+    uint32_t offset[COL_COUNT];
+    uint8_t reserved[12];
+} col_header;
+
+_Static_assert(sizeof(col_header) == 64, "header must stay 64 bytes");
+
+static const size_t column_size[COL_COUNT] = {8, 2, 2, 2, 2};
+
+// Rows being collected for a new file
+typedef struct {
+    int64_t *t;
+    int16_t *temp;
+    uint16_t *humidity;
+    uint16_t *co2;
+    uint16_t *aqi;
+    size_t count;
+    size_t capacity;
+} col_rows;
+
+// A mapped archive file
+typedef struct {
+    const char *path;
+    void *map;
+    size_t size;
+    const col_header *h;
+    const int64_t *t;
+    const int16_t *temp;
+    const uint16_t *humidity;
+    const uint16_t *co2;
+    const uint16_t *aqi;
+} col_file;
+
+// Aggregates over a set of rows; all exact integers so kernels can be compared
+typedef struct {
+    int64_t rows;
+    int64_t temp_sum, humidity_sum, aqi_sum;
+    int32_t temp_min, temp_max, humidity_min, humidity_max;
+    int64_t co2_rows, co2_sum;      // Rows with a valid CO2 value
+    int32_t co2_min, co2_max;
+    int64_t over_ms;                // Time above the CO2 limit
+    int64_t hv_sum, cc_sum, ch_sum, hh_sum;     // For the correlation, valid CO2 rows only
+} agg;
+
+typedef enum {
+    BY_NONE = 0,
+    BY_NODE = 1,
+    BY_DAY = 2,
+    BY_HOUR = 4
+} group_by;
+
+typedef struct {
+    col_file *files;
+    int file_count;
+    int64_t from, to;           // [from, to) in Unix ms
+    int by;
+    int64_t bucket_ms;          // 0 if not grouped by time
+    int64_t origin;             // Start of bucket 0
+    int64_t buckets;
+    uint32_t *nodes;            // Distinct nodes, sorted
+    int node_count;
+    int32_t limit;
+    bool check;
+
+    agg *groups;
+    pthread_mutex_t lock;
+    int next_file;
+    int64_t rows_scanned;
+    int mismatches;
+} query;
+
+// ---------------------------------------------------------------- files
+
+static void *xrealloc(void *p, size_t size) {
+    p = realloc(p, size);
+    if (p == NULL) {
+        perror("realloc");
+        exit(1);
+    }
+    return p;
+}
+
+static void rows_push(col_rows *r, int64_t t, int16_t temp, uint16_t humidity, uint16_t co2) {
+    if (r->count == r->capacity) {
+        r->capacity = r->capacity ? r->capacity * 2 : 4096;
+        r->t = xrealloc(r->t, r->capacity * sizeof(*r->t));
+        r->temp = xrealloc(r->temp, r->capacity * sizeof(*r->temp));
+        r->humidity = xrealloc(r->humidity, r->capacity * sizeof(*r->humidity));
+        r->co2 = xrealloc(r->co2, r->capacity * sizeof(*r->co2));
+        r->aqi = xrealloc(r->aqi, r->capacity * sizeof(*r->aqi));
+    }
+    size_t i = r->count++;
+    r->t[i] = t;
+    r->temp[i] = temp;
+    r->humidity[i] = humidity;
+    r->co2[i] = co2;
+    r->aqi[i] = co2 ? (uint16_t)calculate_aqi(co2) : 0;
+}
+
+static void rows_free(col_rows *r) {
+    free(r->t);
+    free(r->temp);
+    free(r->humidity);
+    free(r->co2);
+    free(r->aqi);
+    memset(r, 0, sizeof(*r));
+}
+
+static bool write_padded(FILE *f, const void *data, size_t len) {
+    static const uint8_t zeros[COL_ALIGN];
+    size_t pad = (COL_ALIGN - len % COL_ALIGN) % COL_ALIGN;
+    return fwrite(data, 1, len, f) == len && fwrite(zeros, 1, pad, f) == pad;
+}
+
+static bool col_write(const char *path, uint32_t node, const col_rows *r) {
+    col_header h = {0};
+    memcpy(h.magic, COL_MAGIC, sizeof(COL_MAGIC));
+    h.node = node;
+    h.rows = (uint32_t)r->count;
+    h.t_min = r->count ? r->t[0] : 0;
+    h.t_max = r->count ? r->t[r->count - 1] : 0;
+
+    const void *data[COL_COUNT] = {r->t, r->temp, r->humidity, r->co2, r->aqi};
+    size_t offset = sizeof(h);
+    for (int c = 0; c < COL_COUNT; c++) {
+        h.offset[c] = (uint32_t)offset;
+        size_t len = column_size[c] * r->count;
+        offset += (len + COL_ALIGN - 1) / COL_ALIGN * COL_ALIGN;
+    }
+    if (offset > UINT32_MAX) {
+        fprintf(stderr, "%s: too many rows for one file\n", path);
+        return false;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    bool ok = write_padded(f, &h, sizeof(h));
+    for (int c = 0; c < COL_COUNT && ok; c++) {
+        ok = write_padded(f, data[c], column_size[c] * r->count);
+    }
+    if (fclose(f) != 0 || !ok) {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+static bool col_open(col_file *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+    f->path = path;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(col_header)) {
+        fprintf(stderr, "%s: not an archive file\n", path);
+        close(fd);
+        return false;
+    }
+    f->size = (size_t)st.st_size;
+    f->map = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (f->map == MAP_FAILED) {
+        perror(path);
+        return false;
+    }
+
+    f->h = f->map;
+    bool ok = memcmp(f->h->magic, COL_MAGIC, sizeof(COL_MAGIC)) == 0;
+    for (int c = 0; c < COL_COUNT && ok; c++) {
+        uint64_t end = (uint64_t)f->h->offset[c] + column_size[c] * f->h->rows;
+        ok = f->h->offset[c] % COL_ALIGN == 0 && end <= f->size;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: not an archive file or truncated\n", path);
+        munmap(f->map, f->size);
+        return false;
+    }
+
+    const uint8_t *base = f->map;
+    f->t = (const int64_t *)(base + f->h->offset[COL_T]);
+    f->temp = (const int16_t *)(base + f->h->offset[COL_TEMP]);
+    f->humidity = (const uint16_t *)(base + f->h->offset[COL_HUMIDITY]);
+    f->co2 = (const uint16_t *)(base + f->h->offset[COL_CO2]);
+    f->aqi = (const uint16_t *)(base + f->h->offset[COL_AQI]);
+    madvise(f->map, f->size, MADV_SEQUENTIAL);
+    return true;
+}
+
+// First row at or after t
+static size_t lower_bound(const col_file *f, int64_t t) {
+    size_t lo = 0, hi = f->h->rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (f->t[mid] < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// -------------------------------------------------------------- kernels
+
+static void agg_init(agg *g) {
+    memset(g, 0, sizeof(*g));
+    g->temp_min = g->humidity_min = g->co2_min = INT32_MAX;
+    g->temp_max = g->humidity_max = g->co2_max = INT32_MIN;
+}
+
+static void agg_merge(agg *a, const agg *b) {
+    a->rows += b->rows;
+    a->temp_sum += b->temp_sum;
+    a->humidity_sum += b->humidity_sum;
+    a->aqi_sum += b->aqi_sum;
+    a->co2_rows += b->co2_rows;
+    a->co2_sum += b->co2_sum;
+    a->over_ms += b->over_ms;
+    a->hv_sum += b->hv_sum;
+    a->cc_sum += b->cc_sum;
+    a->ch_sum += b->ch_sum;
+    a->hh_sum += b->hh_sum;
+    if (b->temp_min < a->temp_min) a->temp_min = b->temp_min;
+    if (b->temp_max > a->temp_max) a->temp_max = b->temp_max;
+    if (b->humidity_min < a->humidity_min) a->humidity_min = b->humidity_min;
+    if (b->humidity_max > a->humidity_max) a->humidity_max = b->humidity_max;
+    if (b->co2_min < a->co2_min) a->co2_min = b->co2_min;
+    if (b->co2_max > a->co2_max) a->co2_max = b->co2_max;
+}
+
+static bool agg_equal(const agg *a, const agg *b) {
+    return a->rows == b->rows && a->temp_sum == b->temp_sum &&
+           a->humidity_sum == b->humidity_sum && a->aqi_sum == b->aqi_sum &&
+           a->co2_rows == b->co2_rows && a->co2_sum == b->co2_sum &&
+           a->over_ms == b->over_ms && a->hv_sum == b->hv_sum &&
+           a->cc_sum == b->cc_sum && a->ch_sum == b->ch_sum && a->hh_sum == b->hh_sum &&
+           a->temp_min == b->temp_min && a->temp_max == b->temp_max &&
+           a->humidity_min == b->humidity_min && a->humidity_max == b->humidity_max &&
+           a->co2_min == b->co2_min && a->co2_max == b->co2_max;
+}
+
+// Time from row i to the next sample, capped
+static int64_t row_span(const col_file *f, size_t i) {
+    if (i + 1 >= f->h->rows) return 0;
+    int64_t dt = f->t[i + 1] - f->t[i];
+    return dt < MAX_GAP_MS ? dt : MAX_GAP_MS;
+}
+
+// Reference: one row at a time
+static void agg_rows_scalar(const col_file *f, size_t a, size_t b, int32_t limit, agg *g) {
+    for (size_t i = a; i < b; i++) {
+        int32_t temp = f->temp[i], humidity = f->humidity[i], co2 = f->co2[i];
+        g->rows++;
+        g->temp_sum += temp;
+        g->humidity_sum += humidity;
+        g->aqi_sum += f->aqi[i];
+        if (temp < g->temp_min) g->temp_min = temp;
+        if (temp > g->temp_max) g->temp_max = temp;
+        if (humidity < g->humidity_min) g->humidity_min = humidity;
+        if (humidity > g->humidity_max) g->humidity_max = humidity;
+        if (co2 == 0) continue;
+
+        g->co2_rows++;
+        g->co2_sum += co2;
+        if (co2 < g->co2_min) g->co2_min = co2;
+        if (co2 > g->co2_max) g->co2_max = co2;
+        if (co2 > limit) g->over_ms += row_span(f, i);
+        g->hv_sum += humidity;
+        g->cc_sum += (int64_t)co2 * co2;
+        g->ch_sum += (int64_t)co2 * humidity;
+        g->hh_sum += (int64_t)humidity * humidity;
+    }
+}
+
+typedef int16_t v8hi __attribute__((vector_size(16)));
+typedef uint16_t v8hu __attribute__((vector_size(16)));
+typedef int32_t v8si __attribute__((vector_size(32)));
+typedef int64_t v8di __attribute__((vector_size(64)));
+
+static inline v8si vmin(v8si a, v8si b) {
+    v8si m = a < b;
+    return (a & m) | (b & ~m);
+}
+
+static inline v8si vmax(v8si a, v8si b) {
+    v8si m = a > b;
+    return (a & m) | (b & ~m);
+}
+
+static inline v8di vmin64(v8di a, v8di b) {
+    v8di m = a < b;
+    return (a & m) | (b & ~m);
+}
+
+static inline int32_t hmin(v8si v) {
+    int32_t r = v[0];
+    for (int i = 1; i < 8; i++) if (v[i] < r) r = v[i];
+    return r;
+}
+
+static inline int32_t hmax(v8si v) {
+    int32_t r = v[0];
+    for (int i = 1; i < 8; i++) if (v[i] > r) r = v[i];
+    return r;
+}
+
+static inline int64_t hsum(v8di v) {
+    int64_t r = 0;
+    for (int i = 0; i < 8; i++) r += v[i];
+    return r;
+}
+
+// Eight rows per step; the last few rows (and the file's last row, which
+// has no next sample for its span) go through the scalar kernel
+static void agg_rows_simd(const col_file *f, size_t a, size_t b, int32_t limit, agg *g) {
+    size_t end = b;
+    if (end + 1 > f->h->rows) end = f->h->rows - 1;     // t[i + 1] must exist
+    size_t n = end > a ? (end - a) / 8 * 8 : 0;
+
+    const v8si big = {INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX,
+                      INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX};
+    const v8si lim = {limit, limit, limit, limit, limit, limit, limit, limit};
+    const v8di gap = {MAX_GAP_MS, MAX_GAP_MS, MAX_GAP_MS, MAX_GAP_MS,
+                      MAX_GAP_MS, MAX_GAP_MS, MAX_GAP_MS, MAX_GAP_MS};
+    v8si temp_min = big, humidity_min = big, co2_min = big;
+    v8si temp_max = ~big, humidity_max = ~big, co2_max = ~big;     // INT32_MIN
+    v8di temp_sum = {0}, humidity_sum = {0}, aqi_sum = {0}, co2_rows = {0}, co2_sum = {0};
+    v8di over = {0}, hv = {0}, cc = {0}, ch = {0}, hh = {0};
+
+    for (size_t i = a; i < a + n; i += 8) {
+        v8hi temp16;
+        v8hu humidity16, co216, aqi16;
+        v8di t0, t1;
+        memcpy(&temp16, &f->temp[i], sizeof(temp16));
+        memcpy(&humidity16, &f->humidity[i], sizeof(humidity16));
+        memcpy(&co216, &f->co2[i], sizeof(co216));
+        memcpy(&aqi16, &f->aqi[i], sizeof(aqi16));
+        memcpy(&t0, &f->t[i], sizeof(t0));
+        memcpy(&t1, &f->t[i + 1], sizeof(t1));
+
+        v8si temp = __builtin_convertvector(temp16, v8si);
+        v8si humidity = __builtin_convertvector(humidity16, v8si);
+        v8si co2 = __builtin_convertvector(co216, v8si);
+        v8si valid = co2 != 0;
+
+        temp_min = vmin(temp_min, temp);
+        temp_max = vmax(temp_max, temp);
+        humidity_min = vmin(humidity_min, humidity);
+        humidity_max = vmax(humidity_max, humidity);
+        co2_min = vmin(co2_min, (co2 & valid) | (big & ~valid));
+        co2_max = vmax(co2_max, co2);   // Invalid rows are 0
+
+        v8di temp64 = __builtin_convertvector(temp, v8di);
+        v8di humidity64 = __builtin_convertvector(humidity, v8di);
+        v8di co264 = __builtin_convertvector(co2, v8di);
+        v8di valid64 = __builtin_convertvector(valid, v8di);
+        v8di hv64 = humidity64 & valid64;
+        temp_sum += temp64;
+        humidity_sum += humidity64;
+        aqi_sum += __builtin_convertvector(aqi16, v8di);
+        co2_rows -= valid64;
+        co2_sum += co264;
+        hv += hv64;
+        cc += co264 * co264;
+        ch += co264 * hv64;
+        hh += hv64 * hv64;
+
+        // co2 > limit is never true for invalid rows
+        v8di above = __builtin_convertvector(co2 > lim, v8di);
+        over += vmin64(t1 - t0, gap) & above;
+    }
+
+    agg v;
+    agg_init(&v);
+    v.rows = (int64_t)n;
+    v.temp_sum = hsum(temp_sum);
+    v.humidity_sum = hsum(humidity_sum);
+    v.aqi_sum = hsum(aqi_sum);
+    v.co2_rows = hsum(co2_rows);
+    v.co2_sum = hsum(co2_sum);
+    v.over_ms = hsum(over);
+    v.hv_sum = hsum(hv);
+    v.cc_sum = hsum(cc);
+    v.ch_sum = hsum(ch);
+    v.hh_sum = hsum(hh);
+    if (n > 0) {
+        v.temp_min = hmin(temp_min);
+        v.temp_max = hmax(temp_max);
+        v.humidity_min = hmin(humidity_min);
+        v.humidity_max = hmax(humidity_max);
+        v.co2_min = hmin(co2_min);
+        v.co2_max = hmax(co2_max);
+        if (v.co2_rows == 0) v.co2_max = INT32_MIN;
+    }
+    agg_merge(g, &v);
+    agg_rows_scalar(f, a + n, b, limit, g);
+}
+
+// ---------------------------------------------------------------- query
+
+static int node_index(const query *q, uint32_t node) {
+    int lo = 0, hi = q->node_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (q->nodes[mid] < node) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static void query_file(query *q, const col_file *f) {
+    size_t lo = lower_bound(f, q->from);
+    size_t hi = lower_bound(f, q->to);
+    int64_t group_base = (q->by & BY_NODE) ? (int64_t)node_index(q, f->h->node) * q->buckets : 0;
+
+    // One slice per time bucket, each a contiguous run of rows
+    size_t a = lo;
+    while (a < hi) {
+        int64_t bucket = 0;
+        size_t b = hi;
+        if (q->bucket_ms > 0) {
+            bucket = (f->t[a] - q->origin) / q->bucket_ms;
+            b = lower_bound(f, q->origin + (bucket + 1) * q->bucket_ms);
+            if (b > hi) b = hi;
+        }
+
+        agg part;
+        agg_init(&part);
+        agg_rows_simd(f, a, b, q->limit, &part);
+
+        bool mismatch = false;
+        if (q->check) {
+            agg ref;
+            agg_init(&ref);
+            agg_rows_scalar(f, a, b, q->limit, &ref);
+            mismatch = !agg_equal(&part, &ref);
+        }
+
+        pthread_mutex_lock(&q->lock);
+        agg_merge(&q->groups[group_base + bucket], &part);
+        q->rows_scanned += (int64_t)(b - a);
+        q->mismatches += mismatch;
+        pthread_mutex_unlock(&q->lock);
+        a = b;
+    }
+}
+
+static void *query_worker(void *arg) {
+    query *q = arg;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        int i = q->next_file++;
+        pthread_mutex_unlock(&q->lock);
+        if (i >= q->file_count) {
+            return NULL;
+        }
+        query_file(q, &q->files[i]);
+    }
+}
+
+// Pearson correlation of CO2 and humidity, NAN if undefined
+static double agg_correlation(const agg *g) {
+    double n = (double)g->co2_rows;
+    double sx = (double)g->co2_sum, sy = (double)g->hv_sum;
+    double vx = n * (double)g->cc_sum - sx * sx;
+    double vy = n * (double)g->hh_sum - sy * sy;
+    if (n < 2 || vx <= 0 || vy <= 0) {
+        return NAN;
+    }
+    return (n * (double)g->ch_sum - sx * sy) / sqrt(vx * vy);
+}
+
+static void format_time(int64_t t_ms, bool hours, char *out, size_t len) {
+    time_t t = (time_t)(t_ms / 1000);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(out, len, hours ? "%Y-%m-%d %H:00" : "%Y-%m-%d", &tm);
+}
+
+static void print_results(const query *q) {
+    printf("%-22s %9s %17s %17s %17s %8s %6s\n", "group", "rows",
+           "temp C min/avg/max", "RH % min/avg/max", "CO2 min/avg/max", "min>lim", "r(CO2,RH)");
+
+    int nodes = (q->by & BY_NODE) ? q->node_count : 1;
+    for (int n = 0; n < nodes; n++) {
+        for (int64_t b = 0; b < q->buckets; b++) {
+            const agg *g = &q->groups[n * q->buckets + b];
+            if (g->rows == 0) continue;
+
+            char label[64] = "all", when[32] = "";
+            if (q->bucket_ms > 0) {
+                format_time(q->origin + b * q->bucket_ms, q->by & BY_HOUR, when, sizeof(when));
+            }
+            if (q->by & BY_NODE) {
+                snprintf(label, sizeof(label), "node %u%s%s", q->nodes[n], *when ? " " : "", when);
+            } else if (*when) {
+                snprintf(label, sizeof(label), "%s", when);
+            }
+
+            char co2[32] = "-";
+            if (g->co2_rows > 0) {
+                snprintf(co2, sizeof(co2), "%d/%.0f/%d", g->co2_min,
+                         (double)g->co2_sum / g->co2_rows, g->co2_max);
+            }
+            printf("%-22s %9lld %5.1f/%5.1f/%5.1f %5.1f/%5.1f/%5.1f %17s %8.1f %6.2f\n", label,
+                   (long long)g->rows,
+                   g->temp_min / 10.0, g->temp_sum / 10.0 / g->rows, g->temp_max / 10.0,
+                   g->humidity_min / 10.0, g->humidity_sum / 10.0 / g->rows, g->humidity_max / 10.0,
+                   co2, g->over_ms / 60000.0, agg_correlation(g));
+        }
+    }
+}
+
+static bool parse_time(const char *s, int64_t *t_ms) {
+    struct tm tm = {0};
+    int n = 0, m = 0;
+    if (sscanf(s, "%d-%d-%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &n) == 3) {
+        if (s[n] == 'T' && sscanf(s + n, "T%d:%d%n", &tm.tm_hour, &tm.tm_min, &m) == 2) {
+            n += m;
+        }
+        if (s[n] != '\0') return false;
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        *t_ms = (int64_t)timegm(&tm) * 1000;
+        return true;
+    }
+
+    char *end;
+    long long seconds = strtoll(s, &end, 10);
+    if (end == s || *end != '\0') return false;
+    *t_ms = seconds * 1000;
+    return true;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double elapsed_s(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int cmd_query(int argc, char **argv) {
+    query q = {0};
+    q.from = INT64_MIN;
+    q.to = INT64_MAX;
+    q.limit = DEFAULT_LIMIT_PPM;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long only_node = -1;
+    const char *by = "none";
+
+    int i = 0;
+    for (; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(opt, "--check") == 0) {
+            q.check = true;
+            continue;
+        }
+        if (val == NULL) {
+            fprintf(stderr, "%s needs a value\n", opt);
+            return 2;
+        }
+        i++;
+        if (strcmp(opt, "--from") == 0 || strcmp(opt, "--to") == 0) {
+            if (!parse_time(val, opt[2] == 'f' ? &q.from : &q.to)) {
+                fprintf(stderr, "bad time: %s\n", val);
+                return 2;
+            }
+        } else if (strcmp(opt, "--by") == 0) {
+            by = val;
+        } else if (strcmp(opt, "--node") == 0) {
+            only_node = atol(val);
+        } else if (strcmp(opt, "--limit") == 0) {
+            q.limit = atoi(val);
+        } else if (strcmp(opt, "--threads") == 0) {
+            threads = atoi(val);
+        } else {
+            fprintf(stderr, "unknown option %s\n", opt);
+            return 2;
+        }
+    }
+    if (i == argc) {
+        fprintf(stderr, "no archive files\n");
+        return 2;
+    }
+
+    if (strstr(by, "node")) q.by |= BY_NODE;
+    if (strstr(by, "day")) q.by |= BY_DAY;
+    if (strstr(by, "hour")) q.by |= BY_HOUR;
+    if ((q.by & BY_DAY) && (q.by & BY_HOUR)) {
+        fprintf(stderr, "group by day or hour, not both\n");
+        return 2;
+    }
+    q.bucket_ms = (q.by & BY_DAY) ? MS_PER_DAY : (q.by & BY_HOUR) ? MS_PER_HOUR : 0;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Map the files, skipping other nodes and files outside the range
+    q.files = calloc(argc - i, sizeof(col_file));
+    q.nodes = calloc(argc - i, sizeof(uint32_t));
+    int64_t t_min = INT64_MAX, t_max = INT64_MIN;
+    size_t mapped = 0;
+    for (; i < argc; i++) {
+        col_file *f = &q.files[q.file_count];
+        if (!col_open(f, argv[i])) {
+            return 1;
+        }
+        if (f->h->rows == 0 || (only_node >= 0 && f->h->node != (uint32_t)only_node) ||
+            f->h->t_max < q.from || f->h->t_min >= q.to) {
+            munmap(f->map, f->size);
+            continue;
+        }
+        if (f->h->t_min < t_min) t_min = f->h->t_min;
+        if (f->h->t_max > t_max) t_max = f->h->t_max;
+        q.nodes[q.file_count] = f->h->node;
+        mapped += f->size;
+        q.file_count++;
+    }
+    if (q.file_count == 0) {
+        fprintf(stderr, "no samples in range\n");
+        return 1;
+    }
+
+    qsort(q.nodes, q.file_count, sizeof(uint32_t), compare_u32);
+    for (int n = 0; n < q.file_count; n++) {
+        if (n == 0 || q.nodes[n] != q.nodes[q.node_count - 1]) {
+            q.nodes[q.node_count++] = q.nodes[n];
+        }
+    }
+
+    // Buckets cover the samples actually in range
+    int64_t first = q.from > t_min ? q.from : t_min;
+    int64_t last = q.to - 1 < t_max ? q.to - 1 : t_max;
+    q.buckets = 1;
+    if (q.bucket_ms > 0) {
+        q.origin = first - ((first % q.bucket_ms) + q.bucket_ms) % q.bucket_ms;
+        q.buckets = (last - q.origin) / q.bucket_ms + 1;
+    }
+    int64_t groups = q.buckets * ((q.by & BY_NODE) ? q.node_count : 1);
+    if (groups > MAX_GROUPS) {
+        fprintf(stderr, "%lld groups is too many, narrow the range\n", (long long)groups);
+        return 1;
+    }
+    q.groups = malloc(groups * sizeof(agg));
+    for (int64_t g = 0; g < groups; g++) {
+        agg_init(&q.groups[g]);
+    }
+
+    pthread_mutex_init(&q.lock, NULL);
+    if (threads < 1) threads = 1;
+    if (threads > q.file_count) threads = q.file_count;
+    pthread_t *workers = calloc(threads, sizeof(pthread_t));
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&workers[t], NULL, query_worker, &q);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    double seconds = elapsed_s(&start);
+
+    print_results(&q);
+    fprintf(stderr, "%d files, %.1f MB mapped, %lld rows in %.3f s (%.0f M rows/s, %d threads)\n",
+            q.file_count, mapped / 1e6, (long long)q.rows_scanned, seconds,
+            q.rows_scanned / seconds / 1e6, threads);
+    if (q.check) {
+        fprintf(stderr, "Scalar check: %d mismatching slices\n", q.mismatches);
+    }
+
+    for (int f = 0; f < q.file_count; f++) {
+        munmap(q.files[f].map, q.files[f].size);
+    }
+    free(workers);
+    free(q.groups);
+    free(q.files);
+    free(q.nodes);
+    return q.mismatches ? 1 : 0;
+}
+
+// --------------------------------------------------------------- import
+
+static int compare_index_t(const void *a, const void *b, void *arg) {
+    const int64_t *t = arg;
+    int64_t x = t[*(const size_t *)a], y = t[*(const size_t *)b];
+    return x < y ? -1 : x > y;
+}
+
+static int cmd_import(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: colquery import <node> <out.col> <serial.log>\n");
+        return 2;
+    }
+    uint32_t node = (uint32_t)strtoul(argv[0], NULL, 10);
+    FILE *in = fopen(argv[2], "r");
+    if (in == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    col_rows rows = {0};
+    char line[512];
+    size_t skipped = 0, incomplete = 0;
+    while (fgets(line, sizeof(line), in)) {
+        unsigned long long device_us;
+        long long host_us;
+        int temp;
+        unsigned humidity, co2;
+        if (sscanf(line, "#D %llu %lld %d %u %u", &device_us, &host_us, &temp,
+                   &humidity, &co2) != 5) {
+            if (strncmp(line, "#D ", 3) == 0) incomplete++;     // "-" for a missing reading
+            continue;
+        }
+        if (host_us < 0) {
+            skipped++;      // Before the first clock sync
+            continue;
+        }
+        rows_push(&rows, host_us / 1000, (int16_t)temp, (uint16_t)humidity, (uint16_t)co2);
+    }
+    fclose(in);
+
+    // Queries rely on time order
+    size_t *order = malloc(rows.count * sizeof(size_t) + 1);
+    for (size_t r = 0; r < rows.count; r++) order[r] = r;
+    qsort_r(order, rows.count, sizeof(size_t), compare_index_t, rows.t);
+    col_rows sorted = {0};
+    for (size_t r = 0; r < rows.count; r++) {
+        size_t k = order[r];
+        rows_push(&sorted, rows.t[k], rows.temp[k], rows.humidity[k], rows.co2[k]);
+    }
+    free(order);
+
+    bool ok = col_write(argv[1], node, &sorted);
+    printf("%zu samples written, %zu without host time and %zu incomplete skipped\n",
+           sorted.count, skipped, incomplete);
+    rows_free(&rows);
+    rows_free(&sorted);
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------- synth
+
+// Daily temperature swing, humidity following it the other way and CO2
+// rising while a room is occupied, with the sensor warming up at the start
+// of every file
+static int cmd_synth(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: colquery synth <dir> [nodes] [days] [interval_s]\n");
+        return 2;
+    }
+    const char *dir = argv[0];
+    int nodes = argc > 1 ? atoi(argv[1]) : 4;
+    int days = argc > 2 ? atoi(argv[2]) : 30;
+    int interval_s = argc > 3 ? atoi(argv[3]) : 10;
+    const int64_t start = 1704067200000LL;     // 2024-01-01 UTC
+    const int days_per_file = 30;
+
+    mkdir(dir, 0777);
+    srand(1);
+    size_t total = 0;
+    for (int n = 1; n <= nodes; n++) {
+        double co2 = 450, drift = 0;
+        for (int d0 = 0; d0 < days; d0 += days_per_file) {
+            col_rows rows = {0};
+            int64_t t0 = start + d0 * MS_PER_DAY;
+            int d1 = d0 + days_per_file < days ? d0 + days_per_file : days;
+            for (int64_t t = t0; t < start + d1 * MS_PER_DAY; t += interval_s * 1000LL) {
+                double hour = (double)((t - start) % MS_PER_DAY) / MS_PER_HOUR;
+                double phase = sin((hour - 9) / 24 * 2 * M_PI);
+                drift += ((rand() % 3) - 1) * 0.02;
+                drift *= 0.999;
+                double temp = 215 + n * 5 + 25 * phase + drift * 10 + (rand() % 5 - 2);
+                double humidity = 450 - 60 * phase + (rand() % 9 - 4);
+                bool occupied = hour >= 8 + n % 3 && hour < 17 + n % 2;
+                co2 += occupied ? (1300 - co2) * 0.002 * interval_s / 10 :
+                                  (420 - co2) * 0.004 * interval_s / 10;
+                bool warming = t - t0 < 180000;
+                uint16_t ppm = warming ? 0 : (uint16_t)(co2 + rand() % 21 - 10);
+                rows_push(&rows, t, (int16_t)temp, (uint16_t)humidity, ppm);
+            }
+
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/node%d_%03d.col", dir, n, d0 / days_per_file);
+            if (!col_write(path, (uint32_t)n, &rows)) {
+                return 1;
+            }
+            total += rows.count;
+            rows_free(&rows);
+        }
+    }
+    printf("%zu samples from %d nodes over %d days written to %s\n", total, nodes, days, dir);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "query") == 0) return cmd_query(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "import") == 0) return cmd_import(argc - 2, argv + 2);
+    if (argc >= 2 && strcmp(argv[1], "synth") == 0) return cmd_synth(argc - 2, argv + 2);
+    fprintf(stderr, "usage: colquery import|synth|query ... (see the top of colquery.c)\n");
+    return 2;
+}
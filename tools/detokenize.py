@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Expand tokenized log lines from the device.
+
+Reads device output (a file, or stdin when none is given), replaces every
+"$<base64>" log line (see log.h) with its text from the token database
+written by tokendb.py, and passes all other lines through unchanged.
+
+Usage: detokenize.py tokens.csv [serial.log]
+       cat /dev/ttyACM0 | detokenize.py build/tokens.csv
+"""
+
+import argparse
+import base64
+import binascii
+import csv
+import re
+import struct
+import sys
+
+LEVEL_NAMES = {1: "E", 2: "W", 3: "I", 4: "D"}
+
+# printf conversion: flags, width, precision, length modifier, conversion
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGcsp%])")
+
+
+def load_database(path):
+    db = {}
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.reader(f):
+            if len(row) >= 4:
+                db[int(row[0], 16)] = row[3]
+    return db
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise IndexError
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return (value >> 1) ^ -(value & 1)
+
+    def float(self):
+        if self.pos + 4 > len(self.data):
+            raise IndexError
+        (value,) = struct.unpack_from("<f", self.data, self.pos)
+        self.pos += 4
+        return value
+
+    def string(self):
+        if self.pos >= len(self.data):
+            raise IndexError
+        header = self.data[self.pos]
+        length = header & 0x7F
+        text = self.data[self.pos + 1:self.pos + 1 + length].decode("utf-8", "replace")
+        self.pos += 1 + length
+        return text + ("..." if header & 0x80 else "")
+
+
+def format_message(fmt, args):
+    """printf-style formatting with arguments decoded as the format asks."""
+    out = []
+    last = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        try:
+            if conv == "s":
+                out.append((spec + "s") % args.string())
+            elif conv in "eEfFgG":
+                out.append((spec + conv) % args.float())
+            elif conv == "c":
+                out.append((spec + "c") % chr(args.varint() & 0xFF))
+            elif conv == "p":
+                out.append("0x%x" % (args.varint() & 0xFFFFFFFF))
+            else:
+                value = args.varint()
+                if conv in "ouxX":
+                    value &= 0xFFFFFFFFFFFFFFFF if length in ("ll", "j") else 0xFFFFFFFF
+                out.append((spec + ("d" if conv == "i" else conv)) % value)
+        except IndexError:
+            out.append("<missing>")
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def expand(line, db):
+    try:
+        payload = base64.b64decode(line[1:], validate=True)
+    except (binascii.Error, ValueError):
+        return line
+    if len(payload) < 5:
+        return line
+    level = payload[0]
+    (token,) = struct.unpack_from("<I", payload, 1)
+    fmt = db.get(token)
+    if fmt is None:
+        return f"[{LEVEL_NAMES.get(level, '?')}] <unknown token {token:08x}: {payload[5:].hex()}>"
+    return f"[{LEVEL_NAMES.get(level, '?')}] " + format_message(fmt, Reader(payload[5:]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("database")
+    parser.add_argument("log", nargs="?")
+    args = parser.parse_args()
+
+    db = load_database(args.database)
+    source = open(args.log, encoding="utf-8", errors="replace") if args.log else sys.stdin
+    for raw in source:
+        line = raw.rstrip("\r\n")
+        print(expand(line, db) if line.startswith("$") else line, flush=True)
+
+
+if __name__ == "__main__":
+    main()
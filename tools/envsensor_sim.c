@@ -0,0 +1,336 @@
+/**
+ * I2C environmental sensor simulator
+ *
+ * Runs the envsensor drivers and scheduler (envsensor.c, sht.c, bme280.c,
+ * scd4x.c) unmodified against register-level models of the parts on a
+ * simulated bus (tools/sim). The environment drifts over time; every
+ * reading a driver produces is checked against the values the model
+ * latched for that measurement. The main loop sleeps to the scheduler's
+ * next deadline like the firmware does, and the report shows how often
+ * each sensor was read alongside the others and how busy the bus was.
+ *
+ * The SHT is taken off the bus for a while halfway through: its
+ * temperature and humidity must pass to the BME280 while it is gone and
+ * come back to it afterwards. The SCD4x is unplugged for a while earlier
+ * on and power-cycled late in the run; both times it comes back idle and
+ * CO2 must be measured again.
+ *
+ * The DHT22 fails every reading, so the values as shown come from the I2C
+ * sensors through sensors.c, and they reach the alarms the way they do
+ * in the firmware: as combined samples on an event bus. A heat wave
+ * partway through must trip the temperature alarm and clear it again.
+ *
+ * None of these drivers waits on an interrupt, so a thread of its own
+ * checks PT_WAIT_SIGNAL first: woken by pt_signal_raise() before its
+ * timeout, and timing out when nothing raises it.
+ *
+ * Usage: envsensor_sim [minutes] [sht3x]
+ *        (default 10 minutes with an SHT4x at 0x44; "sht3x" swaps in an
+ *         SHT3x at 0x45)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host.h"
+#include "pico/stdlib.h"
+#include "i2c_sim.h"
+#include "envsensor.h"
+#include "sensors.h"
+#include "evbus.h"
+#include "alarm.h"
+
+#define BUS_CLOCK_HZ 400000
+
+// Largest driver error allowed, in the reading's own units
+#define TOL_TEMP_X10 2
+#define TOL_HUMIDITY_X10 3
+#define TOL_PRESSURE_PA 3
+#define TOL_CO2_PPM 1
+
+// The SHT is unplugged for this long from the middle of the run, the
+// SCD4x from a fifth of the way in
+#define UNPLUG_US (60 * 1000000ull)
+
+// Time the SCD4x gets to measure again after it comes back
+#define SCD4X_RECOVER_US (30 * 1000000ull)
+
+// The heat wave runs over this share of the run, above the critical
+// temperature threshold; the alarm must follow it within this long
+#define HEAT_START 0.3
+#define HEAT_END 0.4
+#define HEAT_TEMP_C 36.0
+#define ALARM_SETTLE_US (20 * 1000000ull)
+
+#define DHT_PERIOD_MS 2000
+
+static sim_sht sht;
+static sim_bme280 bme;
+static sim_scd4x scd;
+
+static void set_environment(double t_s, bool heat) {
+    double temp = heat ? HEAT_TEMP_C : 21.0 + 4.0 * sin(t_s / 300.0);
+    double humidity = 50.0 + 30.0 * sin(t_s / 170.0);
+    sht.temp_c = temp;
+    sht.humidity = humidity;
+    bme.temp_c = temp + 0.3;        // Sits a little closer to the board
+    bme.humidity = humidity - 1.0;
+    bme.pressure_pa = 101325.0 + 1500.0 * sin(t_s / 400.0);
+    scd.temp_c = temp + 0.8;
+    scd.humidity = humidity - 2.0;
+    scd.co2_ppm = 800.0 + 500.0 * sin(t_s / 250.0);
+}
+
+// Waits twice on a signal, as a driver waits on a completion interrupt
+typedef struct {
+    pt thread;
+    pt_signal ready;
+    bool timed_out[2];
+    uint32_t resumed_ms[2];
+} signal_waiter;
+
+#define SIGNAL_TIMEOUT_MS 100
+#define SIGNAL_RAISE_MS 30
+
+static pt_status wait_twice(signal_waiter *w) {
+    PT_BEGIN(&w->thread);
+    PT_WAIT_SIGNAL(&w->thread, &w->ready, SIGNAL_TIMEOUT_MS);
+    w->timed_out[0] = w->thread.timed_out;
+    w->resumed_ms[0] = w->thread.now_ms;
+    PT_WAIT_SIGNAL(&w->thread, &w->ready, SIGNAL_TIMEOUT_MS);
+    w->timed_out[1] = w->thread.timed_out;
+    w->resumed_ms[1] = w->thread.now_ms;
+    PT_END(&w->thread);
+}
+
+// Run the waiter whenever it is due, raising the signal once mid-wait
+static bool check_signal_wait(void) {
+    signal_waiter w = {0};
+    PT_INIT(&w.thread);
+    pt_signal_raise(&w.ready);      // Before the wait starts, must not count
+
+    pt_status status = PT_WAITING;
+    for (uint32_t now_ms = 0; now_ms <= 3 * SIGNAL_TIMEOUT_MS && status == PT_WAITING; now_ms++) {
+        if (now_ms == SIGNAL_RAISE_MS) {
+            pt_signal_raise(&w.ready);
+        }
+        if (now_ms > 0 && !pt_due(&w.thread, now_ms)) continue;
+        w.thread.now_ms = now_ms;
+        status = wait_twice(&w);
+    }
+
+    printf("Signal wait: woken at %u ms, timed out at %u ms\n",
+           (unsigned)w.resumed_ms[0], (unsigned)w.resumed_ms[1]);
+    bool ok = status == PT_EXITED &&
+              !w.timed_out[0] && w.resumed_ms[0] == SIGNAL_RAISE_MS &&
+              w.timed_out[1] && w.resumed_ms[1] == SIGNAL_RAISE_MS + SIGNAL_TIMEOUT_MS;
+    if (!ok) {
+        fprintf(stderr, "Signal wait did not wake on the signal and then time out\n");
+    }
+    return ok;
+}
+
+static bool within(const char *name, const char *what, long got, double want, double tol) {
+    if (fabs(got - want) <= tol) return true;
+    fprintf(stderr, "%s %s: driver %ld, model %.2f\n", name, what, got, want);
+    return false;
+}
+
+// Check a sensor's latest reading against what its model measured
+static bool check(const env_sensor *s) {
+    const env_reading *r = &s->last;
+    const char *name = s->driver->name;
+    double temp, humidity;
+    bool ok = true;
+
+    if (s->driver == &bme280_driver) {
+        temp = bme.latched_temp_c;
+        humidity = bme.latched_humidity;
+        ok &= within(name, "pressure", r->value[ENV_PRESSURE], bme.latched_pressure,
+                     TOL_PRESSURE_PA);
+    } else if (s->driver == &scd4x_driver) {
+        temp = scd.latched_temp_c;
+        humidity = scd.latched_humidity;
+        ok &= within(name, "CO2", r->value[ENV_CO2], scd.latched_co2, TOL_CO2_PPM);
+    } else {
+        temp = sht.latched_temp_c;
+        humidity = sht.latched_humidity;
+    }
+    ok &= within(name, "temperature", r->value[ENV_TEMP], temp * 10, TOL_TEMP_X10);
+    ok &= within(name, "humidity", r->value[ENV_HUMIDITY], humidity * 10, TOL_HUMIDITY_X10);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    double minutes = argc > 1 ? atof(argv[1]) : 10;
+    bool sht3x = argc > 2 && strcmp(argv[2], "sht3x") == 0;
+    uint64_t end_us = (uint64_t)(minutes * 60e6);
+
+    if (!check_signal_wait()) {
+        return 1;
+    }
+
+    sim_sht_init(&sht, sht3x ? 0x45 : 0x44, !sht3x);
+    sim_bme280_init(&bme, 0x76);
+    sim_scd4x_init(&scd);
+    set_environment(0, false);
+    sim_i2c_attach(&sht.dev);
+    sim_i2c_attach(&bme.dev);
+    sim_i2c_attach(&scd.dev);
+
+    env_bus bus;
+    int found = env_bus_probe(&bus, i2c0, to_ms_since_boot(get_absolute_time()));
+    uint64_t probe_us = host_time_us;
+    printf("Probed %d sensors in %.1f ms\n", found, probe_us / 1000.0);
+    if (found != 3) {
+        fprintf(stderr, "Expected 3 sensors\n");
+        return 2;
+    }
+
+    uint32_t prev_reads[ENV_MAX_SENSORS] = {0};
+    uint32_t wakeups = 0, mismatches = 0, checked = 0, handovers = 0, co2_changes = 0;
+    uint64_t unplug_us = end_us / 2, replug_us = unplug_us + UNPLUG_US;
+    uint64_t scd_unplug_us = end_us / 5, scd_replug_us = scd_unplug_us + UNPLUG_US;
+    uint64_t power_cycle_us = end_us * 4 / 5;
+    bool scd_plugged = true, power_cycled = false;
+    int temp_source = -1, co2_source = -1;
+    uint64_t heat_start_us = (uint64_t)(end_us * HEAT_START);
+    uint64_t heat_end_us = (uint64_t)(end_us * HEAT_END);
+
+    // What the firmware shows, with a DHT22 that never answers, and the
+    // alarms fed from its samples
+    static sensor_data data;
+    sensors_init(&data);
+    static evbus samples;
+    evbus_init(&samples);
+    evbus_sub alarm_sub;
+    evbus_subscribe(&samples, &alarm_sub, EVBUS_MASK(EVBUS_SAMPLE));
+    alarm_init(0);
+    uint32_t next_dht_ms = 0, alarm_errors = 0;
+    bool tripped = false;
+
+    while (host_time_us < end_us) {
+        bool heat = host_time_us >= heat_start_us && host_time_us < heat_end_us;
+        set_environment(host_time_us / 1e6, heat);
+        sht.dev.unplugged = host_time_us >= unplug_us && host_time_us < replug_us;
+        scd.dev.unplugged = host_time_us >= scd_unplug_us && host_time_us < scd_replug_us;
+        if (scd.dev.unplugged != !scd_plugged) {
+            scd_plugged = !scd.dev.unplugged;
+            if (scd_plugged) {
+                sim_scd4x_power_on(&scd);
+            }
+        }
+        if (!power_cycled && host_time_us >= power_cycle_us) {
+            sim_scd4x_power_on(&scd);
+            power_cycled = true;
+        }
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        uint8_t updated = env_bus_poll(&bus, now_ms);
+        wakeups++;
+
+        bool took_reading = false;
+        if ((int32_t)(now_ms - next_dht_ms) >= 0) {
+            dht_reading failed = {.error = true};
+            sensors_apply_dht(&data, &failed, now_ms);
+            next_dht_ms = now_ms + DHT_PERIOD_MS;
+            took_reading = true;
+        }
+        if (updated) {
+            sensors_apply_env(&data, &bus.latest, updated, now_ms);
+            took_reading = true;
+        }
+        if (took_reading) {
+            evbus_event event = {.type = EVBUS_SAMPLE, .t_ms = now_ms, .t_us = host_time_us};
+            sensors_sample(&data, &event.sample);
+            evbus_publish(&samples, &event);
+        }
+        const evbus_event *published;
+        while ((published = evbus_peek(&alarm_sub)) != NULL) {
+            sensor_sample sample = published->sample;
+            uint32_t t_ms = published->t_ms;
+            if (evbus_release(&alarm_sub)) {
+                alarm_update_sample(&sample, t_ms);
+            }
+        }
+
+        // Temperature alarm up during the heat wave and down again after it
+        alarm_level level = alarm_channel_level(ALARM_CH_TEMP);
+        tripped |= level == ALARM_CRIT;
+        bool hot = host_time_us >= heat_start_us + ALARM_SETTLE_US && host_time_us < heat_end_us;
+        bool cool = host_time_us < heat_start_us ||
+                    host_time_us >= heat_end_us + ALARM_SETTLE_US;
+        if ((hot && level != ALARM_CRIT) || (cool && level != ALARM_OK)) {
+            if (alarm_errors++ == 0) {
+                fprintf(stderr, "temperature alarm %s at %.1f s\n", alarm_level_name(level),
+                        host_time_us / 1e6);
+            }
+            mismatches++;
+        }
+
+        // CO2 only comes from the SCD4x: gone while it is unplugged, back
+        // once it has been restarted
+        if (bus.source[ENV_CO2] != co2_source) {
+            co2_source = bus.source[ENV_CO2];
+            co2_changes++;
+        }
+        bool co2_gone = host_time_us >= scd_unplug_us + SCD4X_RECOVER_US / 2 &&
+                        host_time_us < scd_replug_us;
+        bool co2_due = host_time_us >= SCD4X_RECOVER_US && host_time_us < scd_unplug_us;
+        co2_due |= host_time_us >= scd_replug_us + SCD4X_RECOVER_US && host_time_us < power_cycle_us;
+        co2_due |= host_time_us >= power_cycle_us + SCD4X_RECOVER_US;
+        if ((co2_gone && co2_source != -1) || (co2_due && co2_source != 2)) {
+            fprintf(stderr, "CO2 from sensor %d at %.1f s\n", co2_source, host_time_us / 1e6);
+            mismatches++;
+        }
+
+        // Temperature from the SHT while it is there, from the BME280 once
+        // the SHT's retry has failed
+        if (bus.source[ENV_TEMP] != temp_source) {
+            temp_source = bus.source[ENV_TEMP];
+            handovers++;
+        }
+        bool gone = host_time_us >= unplug_us + ENV_RETRY_MS * 1000ull && host_time_us < replug_us;
+        if (host_time_us > 10000000 && temp_source != (gone ? 1 : 0) &&
+            (gone || host_time_us >= replug_us + ENV_RETRY_MS * 1000ull)) {
+            fprintf(stderr, "temperature from sensor %d at %.1f s\n", temp_source,
+                    host_time_us / 1e6);
+            mismatches++;
+        }
+
+        for (int i = 0; i < bus.count; i++) {
+            env_sensor *s = &bus.sensors[i];
+            if (s->reads == prev_reads[i]) continue;
+            prev_reads[i] = s->reads;
+            checked++;
+            if (!check(s)) mismatches++;
+        }
+
+        uint32_t next;
+        env_bus_next_deadline(&bus, &next);
+        uint64_t next_us = (uint64_t)next * 1000;
+        host_time_us = next_us > host_time_us ? next_us : host_time_us + 1000;
+    }
+
+    double seconds = (host_time_us - probe_us) / 1e6;
+    printf("Simulated %.0f s, %u wakeups\n\n", seconds, (unsigned)wakeups);
+    printf("%-8s %7s %8s %7s %10s\n", "sensor", "addr", "reads", "errors", "period s");
+    for (int i = 0; i < bus.count; i++) {
+        const env_sensor *s = &bus.sensors[i];
+        printf("%-8s   0x%02X %8u %7u %10.2f\n", s->driver->name, s->address,
+               (unsigned)s->reads, (unsigned)s->errors, s->reads ? seconds / s->reads : 0.0);
+    }
+
+    uint64_t busy_us = sim_i2c_busy_us(BUS_CLOCK_HZ);
+    printf("\nI2C: %u transactions, %u bytes, %u NAKs, %.1f ms busy at %u kHz (%.3f %%)\n",
+           (unsigned)sim_stats.transactions, (unsigned)sim_stats.bytes,
+           (unsigned)sim_stats.naks, busy_us / 1000.0, BUS_CLOCK_HZ / 1000,
+           100.0 * busy_us / host_time_us);
+    printf("Temperature changed source %u times, CO2 %u times\n", (unsigned)handovers,
+           (unsigned)co2_changes);
+    printf("Temperature alarm %s with the DHT22 failing (%lu samples, %lu dropped)\n",
+           tripped ? "tripped" : "never tripped", (unsigned long)alarm_sub.received,
+           (unsigned long)alarm_sub.dropped);
+    printf("Checked %u readings, %u mismatches\n", (unsigned)checked, (unsigned)mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/**
+ * Event bus checks
+ *
+ * Runs evbus.c on the host. First the cases one at a time: a subscriber
+ * that keeps up gets every event in order, one that falls more than
+ * EVBUS_SLOTS behind skips to the oldest event still in the ring and
+ * counts the rest as dropped, an event overwritten between evbus_peek()
+ * and evbus_release() is reported and counted, types that were not asked
+ * for are skipped without being counted, and sequence numbers wrap.
+ *
+ * Then a publisher thread and a slow reader race: every event the reader
+ * accepts must be whole (no fields from two different events) and in
+ * order, and received + dropped must add up to what was published. There
+ * is one publisher, so the host's no-op spinlock is enough. The threads
+ * yield in a fixed pattern, so on a single core the reader both keeps up
+ * and gets lapped, in the middle of a read too.
+ *
+ * Usage: evbus_test [events]
+ *        (default 2000000 events in the race)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "evbus.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// An event whose fields all derive from n, so a torn read shows
+static void publish_n(evbus *bus, evbus_type type, uint32_t n) {
+    evbus_event event = {.type = type, .t_ms = n, .t_us = (uint64_t)n * 3 + 1,
+                         .co2 = {(float)(n & 0xFFFF), (uint16_t)n}};
+    evbus_publish(bus, &event);
+}
+
+static bool whole(const evbus_event *event) {
+    uint32_t n = event->t_ms;
+    return event->t_us == (uint64_t)n * 3 + 1 && event->co2.adc_raw == (uint16_t)n &&
+           event->co2.ppm == (float)(n & 0xFFFF);
+}
+
+// Read everything there is; returns the number of events accepted
+static uint32_t drain(evbus_sub *sub, uint32_t *last) {
+    const evbus_event *event;
+    uint32_t count = 0;
+    while ((event = evbus_peek(sub)) != NULL) {
+        uint32_t n = event->t_ms;
+        if (evbus_release(sub)) {
+            *last = n;
+            count++;
+        }
+    }
+    return count;
+}
+
+static void check_in_order(void) {
+    static evbus bus;
+    evbus_sub sub;
+    evbus_init(&bus);
+    evbus_subscribe(&bus, &sub, EVBUS_ALL);
+
+    for (uint32_t n = 0; n < 5; n++) {
+        publish_n(&bus, EVBUS_CO2, n);
+    }
+    for (uint32_t n = 0; n < 5; n++) {
+        const evbus_event *event = evbus_peek(&sub);
+        CHECK(event != NULL && event->t_ms == n && whole(event));
+        CHECK(evbus_release(&sub));
+    }
+    CHECK(evbus_peek(&sub) == NULL);
+    CHECK(sub.received == 5 && sub.dropped == 0);
+}
+
+static void check_lapped(void) {
+    static evbus bus;
+    evbus_sub sub;
+    evbus_init(&bus);
+    evbus_subscribe(&bus, &sub, EVBUS_ALL);
+
+    // 7 more than the ring holds: the first 7 are gone
+    for (uint32_t n = 0; n < EVBUS_SLOTS + 7; n++) {
+        publish_n(&bus, EVBUS_CO2, n);
+    }
+    const evbus_event *event = evbus_peek(&sub);
+    CHECK(event != NULL && event->t_ms == 7);
+    CHECK(sub.dropped == 7);
+    evbus_release(&sub);
+
+    uint32_t last = 0;
+    CHECK(drain(&sub, &last) == EVBUS_SLOTS - 1);
+    CHECK(last == EVBUS_SLOTS + 6);
+    CHECK(sub.received == EVBUS_SLOTS && sub.dropped == 7);
+}
+
+static void check_overwritten(void) {
+    static evbus bus;
+    evbus_sub sub;
+    evbus_init(&bus);
+    evbus_subscribe(&bus, &sub, EVBUS_ALL);
+
+    publish_n(&bus, EVBUS_CO2, 0);
+    const evbus_event *event = evbus_peek(&sub);
+    CHECK(event != NULL && event->t_ms == 0);
+
+    // A full ring later the slot holds event EVBUS_SLOTS instead
+    for (uint32_t n = 1; n <= EVBUS_SLOTS; n++) {
+        publish_n(&bus, EVBUS_CO2, n);
+    }
+    CHECK(!evbus_release(&sub));
+    CHECK(sub.received == 0 && sub.dropped == 1);
+
+    uint32_t last = 0;
+    CHECK(drain(&sub, &last) == EVBUS_SLOTS);
+    CHECK(last == EVBUS_SLOTS);
+    CHECK(sub.received + sub.dropped == EVBUS_SLOTS + 1);
+}
+
+static void check_filtered(void) {
+    static evbus bus;
+    evbus_sub sub;
+    evbus_init(&bus);
+    evbus_subscribe(&bus, &sub, EVBUS_MASK(EVBUS_ENV));
+
+    publish_n(&bus, EVBUS_DHT, 0);
+    publish_n(&bus, EVBUS_ENV, 1);
+    publish_n(&bus, EVBUS_CO2, 2);
+    publish_n(&bus, EVBUS_ENV, 3);
+
+    uint32_t last = 0;
+    CHECK(drain(&sub, &last) == 2);
+    CHECK(last == 3);
+    CHECK(sub.received == 2 && sub.dropped == 0);
+}
+
+static void check_wrap(void) {
+    static evbus bus;
+    evbus_sub sub;
+    evbus_init(&bus);
+    bus.head = UINT32_MAX - 4;      // No slot written yet, every stamp still odd
+    evbus_subscribe(&bus, &sub, EVBUS_ALL);
+
+    for (uint32_t n = 0; n < 10; n++) {
+        publish_n(&bus, EVBUS_CO2, n);
+    }
+    uint32_t last = 0;
+    CHECK(drain(&sub, &last) == 10);
+    CHECK(last == 9);
+    CHECK(sub.dropped == 0);
+}
+
+typedef struct {
+    evbus *bus;
+    uint32_t events;
+    volatile bool done;
+} race;
+
+static void *publisher(void *arg) {
+    race *r = arg;
+    for (uint32_t n = 1; n <= r->events; n++) {
+        publish_n(r->bus, EVBUS_CO2, n);
+        // Let the reader catch up, except for one burst of 64 in every 512
+        if (n % 8 == 0 && (n / 64) % 8 != 1) {
+            sched_yield();
+        }
+    }
+    r->done = true;
+    return NULL;
+}
+
+static void check_race(uint32_t events) {
+    static evbus bus;
+    evbus_sub sub;
+    evbus_init(&bus);
+    evbus_subscribe(&bus, &sub, EVBUS_ALL);
+
+    race r = {&bus, events, false};
+    pthread_t thread;
+    pthread_create(&thread, NULL, publisher, &r);
+
+    uint32_t torn = 0, out_of_order = 0, overwritten = 0, last = 0;
+    bool finished = false;
+    while (!finished) {
+        finished = r.done;
+        const evbus_event *event;
+        while ((event = evbus_peek(&sub)) != NULL) {
+            // Copy field by field; just before each burst, give the
+            // publisher the chance to lap us in the middle
+            evbus_event copy;
+            copy.t_ms = event->t_ms;
+            if (copy.t_ms % 512 == 52) {
+                sched_yield();
+            }
+            __dmb();
+            copy.t_us = event->t_us;
+            copy.co2 = event->co2;
+            if (!evbus_release(&sub)) {
+                overwritten++;
+                continue;
+            }
+            if (!whole(&copy)) torn++;
+            if (copy.t_ms <= last) out_of_order++;
+            last = copy.t_ms;
+        }
+        sched_yield();
+    }
+    pthread_join(thread, NULL);
+
+    printf("Race: %u published, %u received, %u dropped (%u while being read), "
+           "%u torn, %u out of order\n", (unsigned)events, (unsigned)sub.received,
+           (unsigned)sub.dropped, (unsigned)overwritten, (unsigned)torn, (unsigned)out_of_order);
+    CHECK(torn == 0);
+    CHECK(out_of_order == 0);
+    CHECK(sub.received + sub.dropped == events);
+    CHECK(last == events);
+}
+
+int main(int argc, char **argv) {
+    uint32_t events = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 2000000;
+
+    check_in_order();
+    check_lapped();
+    check_overwritten();
+    check_filtered();
+    check_wrap();
+    check_race(events);
+
+    printf("%s\n", failures == 0 ? "All checks passed" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
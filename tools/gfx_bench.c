@@ -0,0 +1,191 @@
+/**
+ * Host benchmark for the framebuffer drawing primitives
+ *
+ * Runs every gfx.h primitive against a naive reference that sets one
+ * pixel at a time, first checking on random shapes (including ones
+ * hanging off the panel) that both leave identical framebuffers, then
+ * timing each primitive and reporting pixels per microsecond.
+ *
+ * Usage: gfx_bench [height]      (32 or 64, default 64)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "gfx.h"
+#include "ssd1306.h"
+
+#define CHECK_ROUNDS 20000
+#define BENCH_MIN_NS 200000000.0
+
+static ssd1306_t fast, ref;
+
+// Reference: one pixel at a time, clipped per pixel
+static void ref_pixel(ssd1306_t *disp, int x, int y, gfx_op op) {
+    if (x < 0 || y < 0 || x >= disp->width || y >= disp->height) return;
+    uint8_t *p = &disp->buffer[(y / 8) * disp->width + x];
+    uint8_t bit = 1 << (y % 8);
+    if (op == GFX_SET) *p |= bit;
+    else if (op == GFX_CLEAR) *p &= ~bit;
+    else *p ^= bit;
+}
+
+static void ref_fill_rect(ssd1306_t *disp, int x, int y, int w, int h, gfx_op op) {
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            ref_pixel(disp, x + i, y + j, op);
+        }
+    }
+}
+
+static void ref_rect(ssd1306_t *disp, int x, int y, int w, int h, gfx_op op) {
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            if (i == 0 || j == 0 || i == w - 1 || j == h - 1) {
+                ref_pixel(disp, x + i, y + j, op);
+            }
+        }
+    }
+}
+
+static void ref_blit(ssd1306_t *disp, int x, int y, const uint8_t *bitmap, int w, int h,
+                     gfx_op op) {
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            if (bitmap[(j / 8) * w + i] & (1 << (j % 8))) {
+                ref_pixel(disp, x + i, y + j, op);
+            }
+        }
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int rand_range(int lo, int hi) {
+    return lo + rand() % (hi - lo + 1);
+}
+
+static bool check(void) {
+    static uint8_t bitmap[SSD1306_WIDTH * SSD1306_MAX_PAGES];
+    int size = fast.width * fast.pages;
+
+    for (int round = 0; round < CHECK_ROUNDS; round++) {
+        int x = rand_range(-20, fast.width + 4);
+        int y = rand_range(-20, fast.height + 4);
+        int w = rand_range(0, fast.width + 8);
+        int h = rand_range(0, fast.height + 8);
+        gfx_op op = rand() % 3;
+        int kind = rand() % 4;
+
+        if (kind == 0) {
+            gfx_fill_rect(&fast, x, y, w, h, op);
+            ref_fill_rect(&ref, x, y, w, h, op);
+        } else if (kind == 1) {
+            gfx_rect(&fast, x, y, w, h, op);
+            ref_rect(&ref, x, y, w, h, op);
+        } else if (kind == 2) {
+            gfx_hline(&fast, x, y, w, op);
+            ref_fill_rect(&ref, x, y, w, 1, op);
+            gfx_vline(&fast, x, y, h, op);
+            ref_fill_rect(&ref, x, y, 1, h, op);
+        } else {
+            w = rand_range(1, 40);
+            h = rand_range(1, 40);
+            for (int i = 0; i < w * ((h + 7) / 8); i++) bitmap[i] = rand();
+            gfx_blit(&fast, x, y, bitmap, w, h, op);
+            ref_blit(&ref, x, y, bitmap, w, h, op);
+        }
+
+        if (memcmp(fast.buffer, ref.buffer, size) != 0) {
+            fprintf(stderr, "Mismatch in round %d: kind %d at (%d,%d) %dx%d op %d\n",
+                    round, kind, x, y, w, h, op);
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef enum { SHAPE_FILL, SHAPE_HLINE, SHAPE_VLINE, SHAPE_INVERT, SHAPE_RECT, SHAPE_BLIT } shape;
+
+static const uint8_t icon[8] = {0x00, 0xC3, 0xA5, 0x99, 0xA5, 0xC3, 0x00, 0x00};
+
+// Draw one shape; returns the pixels it covers
+static long draw(ssd1306_t *disp, shape s, bool naive, int i) {
+    int off = i & 7;    // Vary the alignment
+    int w = disp->width - 8, h = disp->height - 8;
+
+    switch (s) {
+    case SHAPE_FILL:
+        naive ? ref_fill_rect(disp, off, off, w, h, GFX_SET)
+              : gfx_fill_rect(disp, off, off, w, h, GFX_SET);
+        return (long)w * h;
+    case SHAPE_HLINE:
+        naive ? ref_fill_rect(disp, off, off, w, 1, GFX_SET)
+              : gfx_hline(disp, off, off, w, GFX_SET);
+        return w;
+    case SHAPE_VLINE:
+        naive ? ref_fill_rect(disp, off, off, 1, h, GFX_SET)
+              : gfx_vline(disp, off, off, h, GFX_SET);
+        return h;
+    case SHAPE_INVERT:
+        naive ? ref_fill_rect(disp, off, off + 3, w, 16, GFX_INVERT)
+              : gfx_fill_rect(disp, off, off + 3, w, 16, GFX_INVERT);
+        return (long)w * 16;
+    case SHAPE_RECT:
+        naive ? ref_rect(disp, off, off, w, h, GFX_SET)
+              : gfx_rect(disp, off, off, w, h, GFX_SET);
+        return 2L * (w + h) - 4;
+    case SHAPE_BLIT:
+        naive ? ref_blit(disp, off * 9, off + 1, icon, 8, 8, GFX_INVERT)
+              : gfx_blit(disp, off * 9, off + 1, icon, 8, 8, GFX_INVERT);
+        return 64;
+    }
+    return 0;
+}
+
+// Pixels per microsecond of one shape
+static double bench(shape s, bool naive) {
+    ssd1306_t *disp = naive ? &ref : &fast;
+    long pixels = 0;
+    long iterations = 1000;
+    double start = now_ns(), elapsed;
+
+    do {
+        for (long i = 0; i < iterations; i++) {
+            pixels += draw(disp, s, naive, (int)i);
+        }
+        elapsed = now_ns() - start;
+        iterations *= 2;
+    } while (elapsed < BENCH_MIN_NS);
+
+    return pixels / (elapsed / 1000.0);
+}
+
+int main(int argc, char **argv) {
+    int height = argc > 1 ? atoi(argv[1]) : 64;
+    ssd1306_init(&fast, i2c0, height);
+    ssd1306_init(&ref, i2c0, height);
+
+    srand(1);
+    if (!check()) {
+        return 2;
+    }
+    printf("Checked %d random shapes against the per-pixel reference\n\n", CHECK_ROUNDS);
+
+    static const char *const names[] = {
+        "fill rect", "hline", "vline", "invert rect", "hollow rect", "blit 8x8"
+    };
+    printf("%-12s %12s %12s %8s\n", "primitive", "gfx px/us", "naive px/us", "speedup");
+    for (int s = SHAPE_FILL; s <= SHAPE_BLIT; s++) {
+        double g = bench(s, false);
+        double n = bench(s, true);
+        printf("%-12s %12.1f %12.1f %7.1fx\n", names[s], g, n, g / n);
+    }
+    return 0;
+}
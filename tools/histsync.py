@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+Pull a device's sample history incrementally.
+
+Asks for every sample after the last one already saved ("hist" command,
+see histsync.h), appends them to a CSV file and remembers where it got to
+in a state file, so a later run (or --follow) only fetches what is new.
+Samples the device dropped before they were fetched are reported; a
+device that has rebooted since the last run is detected by its boot id
+and read from its oldest sample.
+
+Usage: histsync.py /dev/ttyACM0 [--out history.csv] [--state histsync.json]
+                   [--follow 60]
+
+Needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import binascii
+import json
+import os
+import struct
+import sys
+import time
+
+import serial
+
+MARKER = b"#H"
+HEADER = struct.Struct("<BBII")        # type, count, boot_id, seq
+SAMPLE = struct.Struct("<IhHH")        # t_ms, temp_x10, humidity_x10, co2_ppm
+
+# Stored for a quantity that had no reading (TSENC_NO_* in tsenc.h)
+NO_TEMP = -32768
+NO_HUMIDITY = 0xFFFF
+NO_CO2 = 0
+TIMEOUT_S = 5.0
+
+
+def parse_frames(buffer):
+    """Split complete frames off the front of buffer.
+
+    Returns (frames, text, rest): valid frames as (type, boot_id, seq,
+    samples), bytes that were not part of a valid frame, and an incomplete
+    tail to keep for the next read.
+    """
+    frames = []
+    text = bytearray()
+    pos = 0
+    while True:
+        start = buffer.find(MARKER, pos)
+        if start < 0:
+            # Keep a trailing '#' that may start a marker
+            keep = len(buffer) - 1 if buffer.endswith(b"#") else len(buffer)
+            text += buffer[pos:keep]
+            return frames, bytes(text), buffer[keep:]
+        text += buffer[pos:start]
+
+        body = start + len(MARKER)
+        if len(buffer) < body + HEADER.size:
+            return frames, bytes(text), buffer[start:]
+        kind, count, boot_id, seq = HEADER.unpack_from(buffer, body)
+        end = body + HEADER.size + count * SAMPLE.size + 4
+        if kind not in b"SDE":
+            text += buffer[start:body]
+            pos = body
+            continue
+        if len(buffer) < end:
+            return frames, bytes(text), buffer[start:]
+
+        crc, = struct.unpack_from("<I", buffer, end - 4)
+        if binascii.crc32(buffer[body:end - 4]) != crc:
+            # Not a frame after all, or damaged; look again one byte on
+            text += buffer[start:body]
+            pos = body
+            continue
+
+        samples = [SAMPLE.unpack_from(buffer, body + HEADER.size + i * SAMPLE.size)
+                   for i in range(count)]
+        frames.append((chr(kind), boot_id, seq, samples))
+        pos = end
+
+
+def csv_field(value, missing, scale=10):
+    """A reading as a CSV field, empty if there was none."""
+    if value == missing:
+        return ""
+    return f"{value / scale:.1f}" if scale != 1 else str(value)
+
+
+def load_state(path):
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except FileNotFoundError:
+        return {"boot_id": None, "next_seq": 0}
+
+
+def save_state(path, state):
+    tmp = path + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump(state, f)
+    os.replace(tmp, path)
+
+
+def pull(port, state, out):
+    """Run one transfer; returns the samples saved and the bytes read per second."""
+    saved = 0
+    received = 0
+    expected = state["next_seq"]
+    started = False     # START frame of the current request seen
+
+    def request(seq):
+        nonlocal started
+        command = f"hist {seq}"
+        if state["boot_id"] is not None:
+            command += f" {state['boot_id']}"
+        port.write(command.encode() + b"\n")
+        started = False
+
+    request(expected)
+    started_at = time.monotonic()
+    buffer = b""
+    deadline = time.monotonic() + TIMEOUT_S
+    while time.monotonic() < deadline:
+        chunk = port.read(4096)
+        if not chunk:
+            continue
+        received += len(chunk)
+        frames, text, buffer = parse_frames(buffer + chunk)
+        if text.strip():
+            sys.stdout.write(text.decode(errors="replace"))
+
+        for kind, boot_id, seq, samples in frames:
+            deadline = time.monotonic() + TIMEOUT_S
+            if kind == "S":
+                if boot_id != state["boot_id"]:
+                    if state["boot_id"] is not None:
+                        print(f"device rebooted (boot id {boot_id:08x})", file=sys.stderr)
+                    state["boot_id"] = boot_id
+                elif 0 < (seq - expected) & 0xFFFFFFFF < 0x80000000:
+                    lost = (seq - expected) & 0xFFFFFFFF
+                    print(f"{lost} samples dropped by the device before they were fetched",
+                          file=sys.stderr)
+                expected = seq
+                started = True
+            elif not started:
+                continue    # Rest of a transfer from before the last request
+            elif seq != expected:
+                # Lost frame or samples dropped mid-transfer; ask again
+                print(f"gap at {expected}, asking again", file=sys.stderr)
+                request(expected)
+            elif kind == "D":
+                for t_ms, temp, humidity, co2 in samples:
+                    out.write(f"{boot_id:08x},{seq},{t_ms},{csv_field(temp, NO_TEMP)},"
+                              f"{csv_field(humidity, NO_HUMIDITY)},"
+                              f"{csv_field(co2, NO_CO2, 1)}\n")
+                    seq += 1
+                saved += len(samples)
+                expected = seq
+            else:
+                state["next_seq"] = expected
+                elapsed = time.monotonic() - started_at
+                return saved, received / elapsed if elapsed > 0 else 0.0
+
+    state["next_seq"] = expected
+    raise TimeoutError("no reply from the device")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--out", default="history.csv")
+    parser.add_argument("--state", default="histsync.json")
+    parser.add_argument("--follow", type=float, metavar="SECONDS",
+                        help="keep pulling new samples at this interval")
+    args = parser.parse_args()
+
+    state = load_state(args.state)
+    new_file = not os.path.exists(args.out)
+    with open(args.out, "a") as out:
+        if new_file:
+            out.write("boot_id,seq,t_ms,temp_c,humidity_pct,co2_ppm\n")
+
+        while True:
+            try:
+                port = serial.Serial(args.port, args.baud, timeout=0.05)
+                started = time.monotonic()
+                saved, rate = pull(port, state, out)
+                port.close()
+                elapsed = time.monotonic() - started
+                print(f"{saved} samples in {elapsed:.2f} s ({rate / 1024:.0f} KB/s), "
+                      f"next {state['next_seq']}", file=sys.stderr)
+            except (serial.SerialException, TimeoutError) as e:
+                # Unplugged or reset; what was saved so far is kept
+                print(f"transfer interrupted: {e}", file=sys.stderr)
+            out.flush()
+            save_state(args.state, state)
+
+            if args.follow is None:
+                break
+            time.sleep(args.follow)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,38 @@
+/**
+ * Host stand-in for hardware/dma.h, see host.h
+ *
+ * Transfers into an SPI data register happen at once, advance the virtual
+ * clock by their time on the wire and then raise DMA_IRQ_0 if enabled.
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    unsigned int dreq;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(unsigned int channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq);
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           unsigned int transfer_count, bool trigger);
+void dma_channel_transfer_from_buffer_now(unsigned int channel, const volatile void *read_addr,
+                                          uint32_t transfer_count);
+void dma_channel_set_irq0_enabled(unsigned int channel, bool enabled);
+bool dma_channel_get_irq0_status(unsigned int channel);
+void dma_channel_acknowledge_irq0(unsigned int channel);
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * Host stand-in for hardware/gpio.h, see host.h
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+void gpio_init(unsigned int gpio);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_put(unsigned int gpio, bool value);
+bool gpio_get(unsigned int gpio);
+void gpio_set_pulls(unsigned int gpio, bool up, bool down);
+
+#endif
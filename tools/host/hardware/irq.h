@@ -0,0 +1,18 @@
+/**
+ * Host stand-in for hardware/irq.h, see host.h
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include <stdbool.h>
+
+#define DMA_IRQ_0 11
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, unsigned int order_priority);
+void irq_set_enabled(unsigned int num, bool enabled);
+
+#endif
@@ -0,0 +1,34 @@
+/**
+ * Host stand-in for hardware/spi.h, see host.h
+ */
+
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *spi0;
+extern spi_inst_t *spi1;
+
+// Only the data register, which DMA writes to
+typedef struct {
+    volatile uint32_t dr;
+} spi_hw_t;
+
+typedef enum { SPI_CPOL_0, SPI_CPOL_1 } spi_cpol_t;
+typedef enum { SPI_CPHA_0, SPI_CPHA_1 } spi_cpha_t;
+typedef enum { SPI_LSB_FIRST, SPI_MSB_FIRST } spi_order_t;
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate);
+unsigned int spi_get_baudrate(const spi_inst_t *spi);
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                    spi_order_t order);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+bool spi_is_busy(const spi_inst_t *spi);
+spi_hw_t *spi_get_hw(spi_inst_t *spi);
+unsigned int spi_get_dreq(spi_inst_t *spi, bool is_tx);
+
+#endif
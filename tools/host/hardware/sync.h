@@ -0,0 +1,44 @@
+/**
+ * Host stand-in for hardware/sync.h, see host.h
+ *
+ * Single-threaded: barriers and events do nothing and spinlocks are
+ * never contended.
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/platform.h"
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline void __sev(void) {}
+static inline void __wfe(void) {}
+static inline void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+static inline unsigned int spin_lock_claim_unused(bool required) {
+    (void)required;
+    return 0;
+}
+
+static inline spin_lock_t *spin_lock_instance(unsigned int lock_num) {
+    static spin_lock_t locks[32];
+    return &locks[lock_num];
+}
+
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock) {
+    (void)lock;
+    return 0;
+}
+
+static inline void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) {
+    (void)lock;
+    (void)saved_irq;
+}
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * Host stand-ins for the Pico SDK
+ */
+
+#include "host.h"
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+uint64_t host_time_us = 0;
+host_i2c_write_fn host_i2c_write = NULL;
+host_i2c_read_fn host_i2c_read = NULL;
+uint32_t host_i2c_hz = 0;
+bool host_gpio_out[HOST_GPIO_COUNT];
+host_spi_write_fn host_spi_write = NULL;
+
+struct i2c_inst {
+    int index;
+};
+
+static i2c_inst_t i2c_instances[2] = {{0}, {1}};
+i2c_inst_t *i2c0 = &i2c_instances[0];
+i2c_inst_t *i2c1 = &i2c_instances[1];
+
+uint64_t time_us_64(void) { return host_time_us; }
+uint32_t time_us_32(void) { return (uint32_t)host_time_us; }
+void sleep_us(uint64_t us) { host_time_us += us; }
+void sleep_ms(uint32_t ms) { host_time_us += (uint64_t)ms * 1000; }
+absolute_time_t get_absolute_time(void) { return host_time_us; }
+uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback,
+                            void *user_data, repeating_timer_t *out) {
+    (void)delay_ms;
+    out->callback = callback;
+    out->user_data = user_data;
+    return true;
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past) {
+    (void)ms;
+    (void)callback;
+    (void)user_data;
+    (void)fire_if_past;
+    return 1;
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    (void)id;
+    return true;
+}
+
+void gpio_init(unsigned int gpio) { (void)gpio; }
+void gpio_set_dir(unsigned int gpio, bool out) { (void)gpio; (void)out; }
+void gpio_put(unsigned int gpio, bool value) {
+    if (gpio < HOST_GPIO_COUNT) host_gpio_out[gpio] = value;
+}
+bool gpio_get(unsigned int gpio) { (void)gpio; return false; }
+void gpio_set_pulls(unsigned int gpio, bool up, bool down) { (void)gpio; (void)up; (void)down; }
+
+// 9 clocks per byte (with ACK) plus start and stop
+static void i2c_advance(size_t len) {
+    if (host_i2c_hz > 0) {
+        host_time_us += ((uint64_t)(1 + len) * 9 + 2) * 1000000 / host_i2c_hz;
+    }
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c;
+    i2c_advance(len);
+    return host_i2c_write ? host_i2c_write(addr, src, len, nostop) : (int)len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)i2c;
+    i2c_advance(len);
+    return host_i2c_read ? host_i2c_read(addr, dst, len, nostop) : PICO_ERROR_GENERIC;
+}
+
+struct spi_inst {
+    spi_hw_t hw;
+    unsigned int baudrate;
+};
+
+static spi_inst_t spi_instances[2];
+spi_inst_t *spi0 = &spi_instances[0];
+spi_inst_t *spi1 = &spi_instances[1];
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate) {
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+unsigned int spi_get_baudrate(const spi_inst_t *spi) { return spi->baudrate; }
+
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, spi_cpol_t cpol, spi_cpha_t cpha,
+                    spi_order_t order) {
+    (void)spi; (void)data_bits; (void)cpol; (void)cpha; (void)order;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    if (spi->baudrate > 0) {
+        host_time_us += (uint64_t)len * 8 * 1000000 / spi->baudrate;
+    }
+    if (host_spi_write) host_spi_write(src, len);
+    return (int)len;
+}
+
+bool spi_is_busy(const spi_inst_t *spi) { (void)spi; return false; }
+spi_hw_t *spi_get_hw(spi_inst_t *spi) { return &spi->hw; }
+unsigned int spi_get_dreq(spi_inst_t *spi, bool is_tx) { return (spi == spi1) * 2 + !is_tx; }
+
+#define DMA_CHANNELS 12
+
+static struct {
+    bool claimed;
+    bool irq0_enabled;
+    bool irq0_status;
+    volatile void *write_addr;
+} dma_channels[DMA_CHANNELS];
+static irq_handler_t dma_irq0_handler = NULL;
+static bool dma_irq0_enabled = false;
+
+int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < DMA_CHANNELS; i++) {
+        if (!dma_channels[i].claimed) {
+            dma_channels[i].claimed = true;
+            return i;
+        }
+    }
+    (void)required;
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned int channel) {
+    (void)channel;
+    return (dma_channel_config){DMA_SIZE_32, true, false, 0};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->size = size;
+}
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->read_increment = incr; }
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->write_increment = incr; }
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq) { c->dreq = dreq; }
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config,
+                           volatile void *write_addr, const volatile void *read_addr,
+                           unsigned int transfer_count, bool trigger) {
+    (void)config;
+    dma_channels[channel].write_addr = write_addr;
+    if (trigger) {
+        dma_channel_transfer_from_buffer_now(channel, read_addr, transfer_count);
+    }
+}
+
+// Bytes into an SPI data register; other targets are not modelled
+void dma_channel_transfer_from_buffer_now(unsigned int channel, const volatile void *read_addr,
+                                          uint32_t transfer_count) {
+    for (int i = 0; i < 2; i++) {
+        if (dma_channels[channel].write_addr == &spi_instances[i].hw.dr) {
+            spi_write_blocking(&spi_instances[i], (const uint8_t *)read_addr, transfer_count);
+        }
+    }
+    if (dma_channels[channel].irq0_enabled) {
+        dma_channels[channel].irq0_status = true;
+        if (dma_irq0_enabled && dma_irq0_handler) dma_irq0_handler();
+    }
+}
+
+void dma_channel_set_irq0_enabled(unsigned int channel, bool enabled) {
+    dma_channels[channel].irq0_enabled = enabled;
+}
+bool dma_channel_get_irq0_status(unsigned int channel) { return dma_channels[channel].irq0_status; }
+void dma_channel_acknowledge_irq0(unsigned int channel) { dma_channels[channel].irq0_status = false; }
+
+// One handler is enough for the drivers on the host
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, unsigned int order_priority) {
+    (void)order_priority;
+    if (num == DMA_IRQ_0) dma_irq0_handler = handler;
+}
+
+void irq_set_enabled(unsigned int num, bool enabled) {
+    if (num == DMA_IRQ_0) dma_irq0_enabled = enabled;
+}
@@ -0,0 +1,40 @@
+/**
+ * Host stand-ins for the Pico SDK
+ *
+ * Just enough of the SDK for the firmware modules used by the host tools.
+ * Time is a virtual clock the tool advances, timers and alarms never
+ * fire, GPIO outputs are only remembered and I2C and SPI writes go to hooks the tool can install.
+ * DMA into SPI completes at once and calls the DMA interrupt handler.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Virtual clock in microseconds, sleeps advance it
+extern uint64_t host_time_us;
+
+// Called for every I2C write; returns bytes written or a negative error
+typedef int (*host_i2c_write_fn)(uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+typedef int (*host_i2c_read_fn)(uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+extern host_i2c_write_fn host_i2c_write;
+extern host_i2c_read_fn host_i2c_read;
+
+// I2C clock for writes and reads to advance the virtual clock by their time
+// on the bus, 0 (the default) to take no time
+extern uint32_t host_i2c_hz;
+
+// Levels last set with gpio_put()
+#define HOST_GPIO_COUNT 48
+extern bool host_gpio_out[HOST_GPIO_COUNT];
+
+// Called for every SPI write, from the CPU or DMA; the chip select and
+// other control lines are in host_gpio_out. SPI writes advance the virtual
+// clock at the rate given to spi_init().
+typedef void (*host_spi_write_fn)(const uint8_t *src, size_t len);
+extern host_spi_write_fn host_spi_write;
+
+#endif
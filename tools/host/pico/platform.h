@@ -0,0 +1,17 @@
+/**
+ * Host stand-in for pico/platform.h, see host.h
+ *
+ * Everything runs from host memory, so the placement attributes do
+ * nothing.
+ */
+
+#ifndef HOST_PICO_PLATFORM_H
+#define HOST_PICO_PLATFORM_H
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func) func
+#define __time_critical_func(func) func
+
+static inline void tight_loop_contents(void) {}
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * Host stand-in for pico/stdlib.h, see host.h
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT -1
+#define PICO_ERROR_GENERIC -2
+
+#endif
@@ -0,0 +1,36 @@
+/**
+ * Host stand-in for pico/time.h, see host.h
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint64_t absolute_time_t;
+
+// Timers and alarms are accepted but never fire
+typedef int32_t alarm_id_t;
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+struct repeating_timer {
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback,
+                            void *user_data, repeating_timer_t *out);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data,
+                           bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+
+#endif
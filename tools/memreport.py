@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""
+Report flash and RAM usage per subsystem from the linker map file.
+
+Reads the map written next to the firmware (dht22_reader.elf.map) and adds
+up every input section by the memory region it lands in. Sections that are
+copied from flash to RAM at startup (initialised data, functions marked
+__not_in_flash_func) count towards both. The firmware build runs this after
+every link.
+
+The "pinned" column is the part of the RAM that holds functions and data
+moved out of flash with __not_in_flash_func() / __not_in_flash().
+
+Usage: memreport.py build/dht22_reader.elf.map [--objects] [--pinned]
+
+  --objects    break the subsystems down by object file
+  --pinned     list the functions and data pinned in RAM
+"""
+
+import argparse
+import os
+import re
+import sys
+from collections import defaultdict
+
+# Source files by subsystem; anything else from the project is "other"
+SUBSYSTEMS = {
+    "sensors": ["dht22", "mq135", "sensors", "sampler", "comfort", "stats", "trend",
+                "buckets", "envsensor", "sht", "bme280", "scd4x"],
+    "display": ["ssd1306", "gfx", "widget", "screens", "ui"],
+    "storage": ["tsenc", "history", "histsync", "crc32", "capture"],
+    "runtime": ["main", "boot", "console", "button", "alarm", "log", "evbus", "pt",
+                "timesync", "wallclock"],
+}
+
+FILE_SUBSYSTEM = {name: sub for sub, names in SUBSYSTEMS.items() for name in names}
+
+REGION_RE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT_RE = re.compile(r"^(\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)"
+                       r"(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+INPUT_RE = re.compile(r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def subsystem(obj):
+    """Subsystem and short name of an object file path from the map."""
+    if obj.endswith(")") and ".a(" in obj:
+        lib = os.path.basename(obj.split("(")[0])
+        return ("libc" if lib.startswith(("libc", "libm", "libgcc", "libnosys")) else "libs",
+                f"{lib}({obj.split('(')[1]}")
+    name = os.path.basename(obj)
+    for suffix in (".c.obj", ".S.obj", ".cpp.obj", ".obj", ".o"):
+        if name.endswith(suffix):
+            name = name[:-len(suffix)]
+            break
+    if "pico-sdk" in obj or "/src/rp2_common/" in obj or "/src/common/" in obj or \
+            "/src/rp2040/" in obj or "/src/rp2350/" in obj:
+        return "pico-sdk", name
+    if obj.startswith("linker stubs") or "crt" in name:
+        return "startup", name
+    return FILE_SUBSYSTEM.get(name, "other"), name
+
+
+def parse(path):
+    regions = []            # (name, origin, length)
+    sections = []           # (subsystem, object, section, size, vma region, lma region)
+
+    with open(path, errors="replace") as f:
+        lines = f.read().splitlines()
+
+    i = 0
+    # Memory regions
+    while i < len(lines) and lines[i].strip() != "Memory Configuration":
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = REGION_RE.match(lines[i])
+        if m and m.group(1) not in ("Name", "*default*"):
+            regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+        i += 1
+
+    def region_of(addr):
+        for name, origin, length in regions:
+            if origin <= addr < origin + length:
+                return name
+        return None
+
+    # Output sections and the input sections in them
+    load_offset = None      # LMA - VMA of the current output section
+    pending = None          # Section name whose addresses are on the next line
+    for line in lines[i:]:
+        if not line or line.startswith(("LOAD ", "OUTPUT(", "START GROUP", "END GROUP")):
+            continue
+
+        if not line.startswith(" "):
+            m = OUTPUT_RE.match(line)
+            if m:
+                name = m.group(1) or pending
+                load_offset = None
+                if m.group(4):
+                    load_offset = int(m.group(4), 16) - int(m.group(2), 16)
+                pending = None
+            elif re.match(r"^\S+$", line):
+                pending = line
+                load_offset = None
+            continue
+
+        m = INPUT_RE.match(line)
+        if m is None:
+            stripped = line.strip()
+            if re.match(r"^\.\S+$", stripped) and line.startswith(" ."):
+                pending = stripped      # Long input section name, wrapped
+            continue
+
+        name = m.group(1) or pending
+        pending = None
+        if name is None or name.startswith("*") or name == "*fill*":
+            continue
+        vma, size = int(m.group(2), 16), int(m.group(3), 16)
+        if size == 0:
+            continue
+        vma_region = region_of(vma)
+        if vma_region is None:
+            continue        # Debug info and other non-loaded sections
+        lma_region = region_of(vma + load_offset) if load_offset is not None else None
+        sub, obj = subsystem(m.group(4).strip())
+        if name.startswith((".stack", ".heap")):
+            sub = "stacks/heap"
+        sections.append((sub, obj, name, size, vma_region, lma_region))
+
+    return regions, sections
+
+
+def is_flash(region):
+    return region is not None and "FLASH" in region.upper()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("map")
+    parser.add_argument("--objects", action="store_true")
+    parser.add_argument("--pinned", action="store_true")
+    args = parser.parse_args()
+
+    regions, sections = parse(args.map)
+    if not regions:
+        sys.exit(f"{args.map}: no memory regions, not a GNU ld map file?")
+
+    # flash, RAM, of which pinned
+    usage = defaultdict(lambda: [0, 0, 0])
+    objects = defaultdict(lambda: [0, 0, 0])
+    region_used = defaultdict(int)
+    pinned = []
+    for sub, obj, name, size, vma_region, lma_region in sections:
+        region_used[vma_region] += size
+        if lma_region is not None and lma_region != vma_region:
+            region_used[lma_region] += size
+        flash = is_flash(vma_region) or is_flash(lma_region)
+        ram = not is_flash(vma_region)
+        for table, key in ((usage, sub), (objects, (sub, obj))):
+            entry = table[key]
+            entry[0] += size if flash else 0
+            entry[1] += size if ram else 0
+        if ram and name.startswith((".time_critical", ".scratch_")):
+            usage[sub][2] += size
+            objects[(sub, obj)][2] += size
+            pinned.append((size, obj, name))
+
+    print(f"{'subsystem':<24} {'flash':>9} {'RAM':>9} {'pinned':>9}")
+    total = [0, 0, 0]
+    for sub in sorted(usage, key=lambda s: -usage[s][0] - usage[s][1]):
+        flash, ram, code = usage[sub]
+        print(f"{sub:<24} {flash:>9} {ram:>9} {code:>9}")
+        total = [a + b for a, b in zip(total, usage[sub])]
+        if args.objects:
+            for (s, obj), (oflash, oram, ocode) in sorted(objects.items(),
+                                                          key=lambda kv: -kv[1][0] - kv[1][1]):
+                if s == sub:
+                    print(f"  {obj[:22]:<22} {oflash:>9} {oram:>9} {ocode:>9}")
+    print(f"{'total':<24} {total[0]:>9} {total[1]:>9} {total[2]:>9}")
+
+    print()
+    for name, origin, length in regions:
+        used = region_used.get(name, 0)
+        print(f"{name:<12} {used:>8} of {length:>8} bytes ({100.0 * used / length:5.1f} %)")
+
+    if args.pinned:
+        print()
+        for size, obj, name in sorted(pinned, reverse=True):
+            print(f"{size:>6}  {obj:<16} {name}")
+
+
+if __name__ == "__main__":
+    main()
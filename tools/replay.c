@@ -0,0 +1,337 @@
+/**
+ * Replay a raw acquisition capture on the host
+ *
+ * Feeds recorded DHT22 pulse timings, MQ135 ADC codes and merged I2C sensor
+ * readings through the same decode and sensor code as the firmware, on a
+ * virtual clock, re-renders every recorded display frame and checks it
+ * against the recorded CRC.
+ *
+ * Usage: replay [--csv trace.csv] [--save out.cap] capture.log|capture.cap
+ *
+ * The input is either a serial log (the "#C" lines are picked out, all
+ * other output is ignored) or a binary capture file starting with
+ * CAPTURE_MAGIC. --csv writes the replayed samples in the trace format
+ * tsenc_bench reads, --save writes the records as a binary capture file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "capture.h"
+#include "crc32.h"
+#include "dht22.h"
+#include "sensors.h"
+#include "screens.h"
+#include "ssd1306.h"
+
+#define MAX_RECORD 256
+#define OLED_HEIGHT 32
+
+typedef struct {
+    const uint8_t *data;
+    int len;
+    int pos;
+    bool error;
+} record_reader;
+
+typedef struct {
+    uint32_t events;
+    uint32_t frames;
+    uint32_t mismatches;
+    uint32_t errors;
+    uint32_t naks;
+    uint32_t dht_failures;
+} replay_stats;
+
+static sensor_data data;
+static ssd1306_t oled;
+static dht22_link dht_link;
+static uint32_t now_ms = 0;
+static uint32_t first_ms = 0;
+static bool started = false;
+static uint32_t warmup_start_ms = 0;
+static uint32_t warmup_ms = 0;
+static replay_stats stats;
+static FILE *csv = NULL;
+static FILE *save = NULL;
+
+static uint8_t get_u8(record_reader *rd) {
+    if (rd->pos >= rd->len) {
+        rd->error = true;
+        return 0;
+    }
+    return rd->data[rd->pos++];
+}
+
+static uint16_t get_u16(record_reader *rd) {
+    uint16_t lo = get_u8(rd);
+    return lo | (uint16_t)get_u8(rd) << 8;
+}
+
+static uint32_t get_u32(record_reader *rd) {
+    uint32_t lo = get_u16(rd);
+    return lo | (uint32_t)get_u16(rd) << 16;
+}
+
+static uint32_t get_varint(record_reader *rd) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = get_u8(rd);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+static void write_sample(void) {
+    if (csv == NULL || data.dht_state != SENSOR_READY) return;
+    fprintf(csv, "%u,%d,%u,%u\n", now_ms, data.dht.temp_x10, data.dht.humidity_x10,
+            data.co2_state == SENSOR_READY ? (unsigned)data.co2_ppm : 0u);
+}
+
+// Apply one record; returns false if it could not be parsed
+static bool replay_record(const uint8_t *bytes, int len) {
+    record_reader rd = {bytes, len, 0, false};
+    uint8_t type = get_u8(&rd);
+    now_ms += get_varint(&rd);
+    host_time_us = (uint64_t)now_ms * 1000;
+
+    switch (type) {
+    case CAP_START: {
+        uint8_t version = get_u8(&rd);
+        now_ms = get_u32(&rd);
+        if (version != CAPTURE_VERSION) {
+            fprintf(stderr, "Unsupported capture version %u\n", version);
+            return false;
+        }
+        if (!started) {
+            first_ms = now_ms;
+            started = true;
+        }
+        break;
+    }
+    case CAP_WARMUP:
+        warmup_start_ms = get_u32(&rd);
+        warmup_ms = get_u32(&rd);
+        break;
+    case CAP_DHT: {
+        dht_pulses pulses;
+        pulses.status = get_u8(&rd);
+        pulses.bits = get_u8(&rd);
+        if (pulses.bits > DHT22_BITS) return false;
+        for (int i = 0; i < pulses.bits; i++) {
+            pulses.high_us[i] = get_u8(&rd);
+        }
+        dht_reading reading = dht22_decode(&pulses);
+        uint32_t retry_ms;
+        dht22_outcome outcome = dht22_link_result(&dht_link, &pulses, &reading, &retry_ms);
+        if (outcome == DHT22_SAMPLE_RETRY) {
+            break;
+        }
+        if (!sensors_apply_dht(&data, &reading, now_ms)) {
+            stats.dht_failures++;
+        }
+        write_sample();
+        break;
+    }
+    case CAP_ADC:
+        sensors_update_warmup(&data, now_ms, warmup_start_ms, warmup_ms);
+        sensors_apply_adc(&data, get_u16(&rd), now_ms);
+        write_sample();
+        break;
+    case CAP_ENV: {
+        uint8_t updated = get_u8(&rd);
+        env_reading latest = {.valid = get_u8(&rd)};
+        for (int q = 0; q < ENV_QUANTITY_COUNT; q++) {
+            if (latest.valid & (1u << q)) {
+                latest.value[q] = (int32_t)get_u32(&rd);
+            }
+        }
+        sensors_apply_env(&data, &latest, updated, now_ms);
+        write_sample();
+        break;
+    }
+    case CAP_I2C:
+        get_u8(&rd);
+        if (!get_u8(&rd)) {
+            stats.naks++;
+        }
+        break;
+    case CAP_FRAME: {
+        uint8_t screen = get_u8(&rd);
+        uint32_t expected = get_u32(&rd);
+        sensors_update_warmup(&data, now_ms, warmup_start_ms, warmup_ms);
+        screens_render(&oled, screen, &data, now_ms);
+        uint32_t crc = crc32_update(0, oled.buffer, oled.width * oled.pages);
+        stats.frames++;
+        if (crc != expected) {
+            stats.mismatches++;
+            fprintf(stderr, "Frame mismatch at %u ms (screen %u): %08X != %08X\n",
+                    now_ms, screen, crc, expected);
+        }
+        break;
+    }
+    default:
+        fprintf(stderr, "Unknown record type %u\n", type);
+        return false;
+    }
+
+    if (rd.error) return false;
+
+    stats.events++;
+    if (save != NULL) {
+        fwrite(bytes, 1, len, save);
+    }
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static void replay_log(FILE *in) {
+    char line[2 * MAX_RECORD + 16];
+    uint8_t bytes[MAX_RECORD];
+
+    while (fgets(line, sizeof(line), in)) {
+        // Records can follow other output on the same line
+        char *p = strstr(line, "#C ");
+        if (p == NULL) continue;
+        p += 3;
+
+        int len = 0;
+        bool ok = true;
+        while (hex_value(p[0]) >= 0 && len < MAX_RECORD) {
+            int hi = hex_value(p[0]), lo = hex_value(p[1]);
+            if (lo < 0) {
+                ok = false;
+                break;
+            }
+            bytes[len++] = (hi << 4) | lo;
+            p += 2;
+        }
+
+        if (!ok || len == 0 || !replay_record(bytes, len)) {
+            stats.errors++;
+        }
+    }
+}
+
+// Length of the record at the start of buf, or 0 if it is cut short
+static int record_length(const uint8_t *buf, int avail) {
+    int pos = 1;
+    while (pos < avail && (buf[pos] & 0x80)) pos++;
+    if (++pos > avail) return 0;
+
+    switch (buf[0]) {
+    case CAP_START:   pos += 5; break;
+    case CAP_WARMUP:  pos += 8; break;
+    case CAP_DHT:     pos += 2 + (pos + 1 < avail ? buf[pos + 1] : 0); break;
+    case CAP_ADC:     pos += 2; break;
+    case CAP_I2C:     pos += 2; break;
+    case CAP_FRAME:   pos += 5; break;
+    case CAP_ENV:
+        if (pos + 1 >= avail) return 0;
+        pos += 2 + 4 * __builtin_popcount(buf[pos + 1] & ((1u << ENV_QUANTITY_COUNT) - 1));
+        break;
+    default:          return -1;
+    }
+    return pos <= avail ? pos : 0;
+}
+
+static void replay_binary(FILE *in) {
+    uint8_t buf[4 * MAX_RECORD];
+    int avail = 0;
+
+    for (;;) {
+        avail += fread(&buf[avail], 1, sizeof(buf) - avail, in);
+        if (avail == 0) break;
+
+        int len = record_length(buf, avail);
+        if (len <= 0) {
+            // Unknown type or truncated tail, nothing more to replay
+            stats.errors++;
+            break;
+        }
+        if (!replay_record(buf, len)) {
+            stats.errors++;
+        }
+        memmove(buf, &buf[len], avail - len);
+        avail -= len;
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv = fopen(argv[++i], "w");
+            if (csv == NULL) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save = fopen(argv[++i], "wb");
+            if (save == NULL) {
+                perror(argv[i]);
+                return 1;
+            }
+            fwrite(CAPTURE_MAGIC, 1, strlen(CAPTURE_MAGIC), save);
+        } else if (path == NULL) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--csv trace.csv] [--save out.cap] capture\n", argv[0]);
+            return 1;
+        }
+    }
+    if (path == NULL) {
+        fprintf(stderr, "Usage: %s [--csv trace.csv] [--save out.cap] capture\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    sensors_init(&data);
+    dht22_link_init(&dht_link);
+    ssd1306_init(&oled, i2c0, OLED_HEIGHT);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    char magic[sizeof(CAPTURE_MAGIC) - 1];
+    if (fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+        memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0) {
+        replay_binary(in);
+    } else {
+        rewind(in);
+        replay_log(in);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed_ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+    fclose(in);
+    if (csv != NULL) fclose(csv);
+    if (save != NULL) fclose(save);
+
+    printf("Events:        %u\n", stats.events);
+    printf("Frames:        %u (%u mismatched)\n", stats.frames, stats.mismatches);
+    printf("DHT failures:  %u (%u retries)\n", stats.dht_failures,
+           dht_link.counters.attempts - dht_link.counters.good - stats.dht_failures);
+    printf("I2C NAKs:      %u\n", stats.naks);
+    printf("Bad records:   %u\n", stats.errors);
+    printf("Session:       %.1f s replayed in %.2f ms\n",
+           started ? (now_ms - first_ms) / 1000.0 : 0.0, elapsed_ms);
+
+    return stats.mismatches == 0 && stats.errors == 0 ? 0 : 2;
+}
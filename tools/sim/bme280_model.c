@@ -0,0 +1,169 @@
+/**
+ * BME280 model
+ *
+ * Register file with the datasheet's typical trimming parameters. A write
+ * of forced mode to ctrl_meas runs one conversion: the measuring bit is
+ * set for the conversion time, then the data registers hold raw values
+ * found by searching the datasheet's floating point compensation for the
+ * model's temperature, pressure and humidity. That keeps the model
+ * independent of the driver's integer compensation. After a soft reset
+ * the im_update status bit is set while the trimming is reloaded.
+ */
+
+#include <string.h>
+#include "host.h"
+#include "i2c_sim.h"
+
+#define BME280_MEASURE_US 9300
+#define BME280_RESET_US 2000
+
+// Typical trimming parameters
+static const uint16_t T1 = 27504;
+static const int16_t T2 = 26435, T3 = -1000;
+static const uint16_t P1 = 36477;
+static const int16_t P2 = -10685, P3 = 3024, P4 = 2855, P5 = 140, P6 = -7,
+                     P7 = 15500, P8 = -14600, P9 = 6000;
+static const uint8_t H1 = 75, H3 = 0;
+static const int16_t H2 = 370, H4 = 304, H5 = 50;
+static const int8_t H6 = 30;
+
+// Datasheet section 8.1, double precision
+static double ref_t_fine(double adc_t) {
+    double var1 = (adc_t / 16384.0 - T1 / 1024.0) * T2;
+    double d = adc_t / 131072.0 - T1 / 8192.0;
+    return var1 + d * d * T3;
+}
+
+static double ref_pressure(double adc_p, double t_fine) {
+    double var1 = t_fine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * P6 / 32768.0;
+    var2 = var2 + var1 * P5 * 2.0;
+    var2 = var2 / 4.0 + P4 * 65536.0;
+    var1 = (P3 * var1 * var1 / 524288.0 + P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * P1;
+    double p = 1048576.0 - adc_p;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = P9 * p * p / 2147483648.0;
+    var2 = p * P8 / 32768.0;
+    return p + (var1 + var2 + P7) / 16.0;
+}
+
+static double ref_humidity(double adc_h, double t_fine) {
+    double h = t_fine - 76800.0;
+    h = (adc_h - (H4 * 64.0 + H5 / 16384.0 * h)) *
+        (H2 / 65536.0 * (1.0 + H6 / 67108864.0 * h * (1.0 + H3 / 67108864.0 * h)));
+    return h * (1.0 - H1 * h / 524288.0);
+}
+
+// Raw code whose compensated value is closest to target (f monotonic)
+static uint32_t search(double target, uint32_t max, bool increasing, double t_fine,
+                       double (*f)(double, double)) {
+    uint32_t lo = 0, hi = max;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        double v = f(mid, t_fine);
+        if (increasing ? v < target : v > target) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static double temp_of(double adc_t, double unused) {
+    (void)unused;
+    return ref_t_fine(adc_t) / 5120.0;
+}
+
+static void convert(sim_bme280 *m) {
+    uint32_t adc_t = search(m->temp_c, 0xFFFFF, true, 0, temp_of);
+    double t_fine = ref_t_fine(adc_t);
+    uint32_t adc_p = search(m->pressure_pa, 0xFFFFF, false, t_fine, ref_pressure);
+    uint32_t adc_h = search(m->humidity, 0xFFFF, true, t_fine, ref_humidity);
+
+    m->latched_temp_c = m->temp_c;
+    m->latched_humidity = m->humidity;
+    m->latched_pressure = m->pressure_pa;
+
+    uint8_t *d = &m->regs[0xF7];
+    d[0] = adc_p >> 12;
+    d[1] = adc_p >> 4;
+    d[2] = (adc_p & 0x0F) << 4;
+    d[3] = adc_t >> 12;
+    d[4] = adc_t >> 4;
+    d[5] = (adc_t & 0x0F) << 4;
+    d[6] = adc_h >> 8;
+    d[7] = adc_h & 0xFF;
+}
+
+static void load_calibration(sim_bme280 *m) {
+    uint8_t *c = &m->regs[0x88];
+    const uint16_t words[12] = {T1, (uint16_t)T2, (uint16_t)T3, P1, (uint16_t)P2, (uint16_t)P3,
+                                (uint16_t)P4, (uint16_t)P5, (uint16_t)P6, (uint16_t)P7,
+                                (uint16_t)P8, (uint16_t)P9};
+    for (int i = 0; i < 12; i++) {
+        c[2 * i] = words[i] & 0xFF;
+        c[2 * i + 1] = words[i] >> 8;
+    }
+    m->regs[0xA1] = H1;
+    m->regs[0xE1] = (uint16_t)H2 & 0xFF;
+    m->regs[0xE2] = (uint16_t)H2 >> 8;
+    m->regs[0xE3] = H3;
+    m->regs[0xE4] = (uint8_t)(H4 >> 4);
+    m->regs[0xE5] = (uint8_t)((H4 & 0x0F) | (H5 & 0x0F) << 4);
+    m->regs[0xE6] = (uint8_t)(H5 >> 4);
+    m->regs[0xE7] = (uint8_t)H6;
+    m->regs[0xD0] = 0x60;
+}
+
+static bool bme280_write(sim_device *dev, const uint8_t *src, size_t len) {
+    sim_bme280 *m = dev->model;
+    if (len == 0) return true;
+
+    m->pointer = src[0];
+    // Register/value pairs
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint8_t reg = src[i], value = src[i + 1];
+        if (reg == 0xE0 && value == 0xB6) {
+            memset(m->regs, 0, sizeof(m->regs));
+            load_calibration(m);
+            m->reset_until_us = host_time_us + BME280_RESET_US;
+        } else if (reg == 0xF4) {
+            m->regs[0xF4] = value;
+            if ((value & 0x03) == 0x01 || (value & 0x03) == 0x02) {
+                // Forced mode: one conversion, then back to sleep
+                m->measuring_until_us = host_time_us + BME280_MEASURE_US;
+                m->regs[0xF4] &= ~0x03;
+            }
+        } else if (reg == 0xF2 || reg == 0xF5) {
+            m->regs[reg] = value;
+        }
+    }
+    return true;
+}
+
+static bool bme280_read(sim_device *dev, uint8_t *dst, size_t len) {
+    sim_bme280 *m = dev->model;
+
+    // Data registers update when the conversion ends
+    if (m->measuring_until_us != 0 && host_time_us >= m->measuring_until_us) {
+        convert(m);
+        m->measuring_until_us = 0;
+    }
+    m->regs[0xF3] = (m->measuring_until_us != 0 ? 0x08 : 0x00) |
+                    (host_time_us < m->reset_until_us ? 0x01 : 0x00);
+
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = m->regs[(uint8_t)(m->pointer + i)];
+    }
+    return true;
+}
+
+void sim_bme280_init(sim_bme280 *m, uint8_t address) {
+    memset(m, 0, sizeof(*m));
+    m->dev.address = address;
+    m->dev.write = bme280_write;
+    m->dev.read = bme280_read;
+    m->dev.model = m;
+    m->temp_c = 20.0;
+    m->humidity = 50.0;
+    m->pressure_pa = 101325.0;
+    load_calibration(m);
+}
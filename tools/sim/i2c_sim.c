@@ -0,0 +1,72 @@
+/**
+ * Simulated I2C bus for host tests
+ */
+
+#include "host.h"
+#include "pico/stdlib.h"
+#include "i2c_sim.h"
+
+sim_bus_stats sim_stats;
+
+static sim_device *devices[SIM_MAX_DEVICES];
+static int device_count = 0;
+
+static sim_device *find(uint8_t address) {
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i]->address == address && !devices[i]->unplugged) return devices[i];
+    }
+    return NULL;
+}
+
+static int bus_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)nostop;
+    sim_device *dev = find(addr);
+    sim_stats.transactions++;
+    sim_stats.bytes += 1 + len;
+    if (dev == NULL || !dev->write(dev, src, len)) {
+        sim_stats.naks++;
+        return PICO_ERROR_GENERIC;
+    }
+    return (int)len;
+}
+
+static int bus_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)nostop;
+    sim_device *dev = find(addr);
+    sim_stats.transactions++;
+    sim_stats.bytes += 1 + len;
+    if (dev == NULL || !dev->read(dev, dst, len)) {
+        sim_stats.naks++;
+        return PICO_ERROR_GENERIC;
+    }
+    return (int)len;
+}
+
+void sim_i2c_attach(sim_device *dev) {
+    if (device_count < SIM_MAX_DEVICES) {
+        devices[device_count++] = dev;
+    }
+    host_i2c_write = bus_write;
+    host_i2c_read = bus_read;
+}
+
+void sim_i2c_detach_all(void) {
+    device_count = 0;
+}
+
+uint64_t sim_i2c_busy_us(uint32_t clock_hz) {
+    // 9 clocks per byte (with ACK) plus start and stop
+    uint64_t clocks = (uint64_t)sim_stats.bytes * 9 + (uint64_t)sim_stats.transactions * 2;
+    return clocks * 1000000 / clock_hz;
+}
+
+uint8_t sim_crc8(const uint8_t *data, int len) {
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
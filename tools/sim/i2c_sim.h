@@ -0,0 +1,165 @@
+/**
+ * Simulated I2C bus for host tests
+ *
+ * Register-level models of I2C devices attach to the host I2C hooks (see
+ * host.h). Each model sees the raw bytes of every transaction addressed
+ * to it and answers or NAKs like the real part, with timing taken from
+ * the virtual clock, so drivers run unmodified against them.
+ */
+
+#ifndef I2C_SIM_H
+#define I2C_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SIM_MAX_DEVICES 8
+
+typedef struct sim_device sim_device;
+
+struct sim_device {
+    uint8_t address;
+    // Return false to NAK
+    bool (*write)(sim_device *dev, const uint8_t *src, size_t len);
+    bool (*read)(sim_device *dev, uint8_t *dst, size_t len);
+    void *model;
+    bool unplugged;     // NAKs everything, as if taken off the bus
+};
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t naks;
+} sim_bus_stats;
+
+extern sim_bus_stats sim_stats;
+
+// Put a device on the bus (and install the host hooks)
+void sim_i2c_attach(sim_device *dev);
+void sim_i2c_detach_all(void);
+
+// Bus time of the traffic so far at a given clock, in microseconds
+uint64_t sim_i2c_busy_us(uint32_t clock_hz);
+
+// Sensirion CRC-8, for the models' responses
+uint8_t sim_crc8(const uint8_t *data, int len);
+
+// Models, each with the physical values it measures
+typedef struct {
+    sim_device dev;
+    double temp_c;
+    double humidity;
+    bool is_sht4x;          // Command set: SHT4x (1 byte) or SHT3x (2 bytes)
+    uint64_t ready_us;      // Conversion done, 0 if none running
+    uint8_t response[6];
+    int response_len;
+    double latched_temp_c, latched_humidity;
+} sim_sht;
+
+typedef struct {
+    sim_device dev;
+    double temp_c;
+    double humidity;
+    double co2_ppm;
+    bool periodic;
+    uint64_t started_us;        // Start of periodic measurement
+    uint32_t taken;             // Measurements read out
+    uint64_t busy_until_us;     // Stop in progress
+    uint64_t response_us;       // Response readable from
+    uint8_t response[9];
+    int response_len;
+    double latched_temp_c, latched_humidity, latched_co2;
+} sim_scd4x;
+
+typedef struct {
+    sim_device dev;
+    double temp_c;
+    double humidity;
+    double pressure_pa;
+    uint8_t regs[256];
+    uint8_t pointer;
+    uint64_t measuring_until_us;
+    uint64_t reset_until_us;
+    double latched_temp_c, latched_humidity, latched_pressure;
+} sim_bme280;
+
+// SSD1306 controller and the panel behind it
+#define SIM_SSD1306_WIDTH 128
+#define SIM_SSD1306_PAGES 8
+
+typedef enum {
+    SIM_SSD1306_HORIZONTAL,
+    SIM_SSD1306_VERTICAL,
+    SIM_SSD1306_PAGE
+} sim_ssd1306_mode;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;         // Including the address byte of each I2C transaction
+    uint32_t data_bytes;    // Written to GDDRAM
+    uint32_t command_bytes;
+} sim_ssd1306_stats;
+
+typedef struct {
+    sim_device dev;
+    uint8_t panel_height;   // Rows on the glass, 32 or 64
+    uint8_t cs_pin, dc_pin; // On SPI
+    uint8_t gddram[SIM_SSD1306_PAGES][SIM_SSD1306_WIDTH];
+
+    // Command parser, carries over between transactions like the chip
+    uint8_t command[7];
+    int command_len;
+
+    // Addressing
+    sim_ssd1306_mode mode;
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t col, page;
+
+    // Hardware configuration
+    bool display_on;
+    bool charge_pump;
+    bool inverse;
+    bool entire_on;         // 0xA5, all pixels on regardless of GDDRAM
+    bool seg_remap;         // 0xA1, column 127 to SEG0
+    bool com_scan_dec;      // 0xC8, scan from COM[N-1] to COM0
+    uint8_t mux;            // Multiplex ratio - 1
+    uint8_t offset;         // Vertical display offset
+    uint8_t start_line;
+    uint8_t com_pins;       // 0xDA setting
+    uint8_t contrast;
+
+    uint32_t unknown_commands;
+    sim_ssd1306_stats total;
+    sim_ssd1306_stats frame;    // Since the last sim_ssd1306_new_frame()
+} sim_ssd1306;
+
+void sim_sht_init(sim_sht *m, uint8_t address, bool is_sht4x);
+void sim_scd4x_init(sim_scd4x *m);
+// Idle, as after power-up (the init state is running, as after a soft reboot)
+void sim_scd4x_power_on(sim_scd4x *m);
+void sim_bme280_init(sim_bme280 *m, uint8_t address);
+
+// In its reset state, like after power-up
+void sim_ssd1306_init(sim_ssd1306 *m, uint8_t address, uint8_t panel_height);
+
+// Drive it over 4-wire SPI instead of I2C (installs the host SPI hook):
+// bytes written while cs_pin is low are data if dc_pin is high, commands
+// if it is low
+void sim_ssd1306_attach_spi(sim_ssd1306 *m, unsigned int cs_pin, unsigned int dc_pin);
+
+// Start counting a new frame's traffic
+void sim_ssd1306_new_frame(sim_ssd1306 *m);
+
+/**
+ * What the panel shows, one byte per pixel (0 or 1), row by row
+ *
+ * Drawn as seen on the usual modules, which mount the glass so that the
+ * remapped settings (0xA1, 0xC8) put GDDRAM column 0, row 0 top left.
+ */
+void sim_ssd1306_render(const sim_ssd1306 *m, uint8_t *pixels);
+
+// Write a rendered image as binary PBM; false on I/O errors
+bool sim_ssd1306_write_pbm(const sim_ssd1306 *m, const char *path);
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * SCD4x model
+ *
+ * Periodic measurement mode with a new result every 5 s. Responses are
+ * readable 1 ms after their command; commands that are not allowed in the
+ * current mode, and anything sent while a stop is in progress, are NAKed.
+ */
+
+#include <string.h>
+#include "host.h"
+#include "i2c_sim.h"
+
+#define SCD4X_INTERVAL_US 5000000
+#define SCD4X_STOP_US 500000
+#define SCD4X_COMMAND_US 1000
+
+static void put_word(sim_scd4x *m, uint16_t word) {
+    uint8_t *p = &m->response[m->response_len];
+    p[0] = word >> 8;
+    p[1] = word & 0xFF;
+    p[2] = sim_crc8(p, 2);
+    m->response_len += 3;
+}
+
+// Measurements finished since periodic mode started
+static uint32_t measurements_done(const sim_scd4x *m) {
+    return m->periodic ? (uint32_t)((host_time_us - m->started_us) / SCD4X_INTERVAL_US) : 0;
+}
+
+static uint16_t ticks(double value, double offset, double span) {
+    double t = (value + offset) * 65535 / span;
+    return t < 0 ? 0 : t > 65535 ? 65535 : (uint16_t)(t + 0.5);
+}
+
+static bool scd4x_write(sim_device *dev, const uint8_t *src, size_t len) {
+    sim_scd4x *m = dev->model;
+    if (len != 2 || host_time_us < m->busy_until_us) return false;
+
+    uint16_t cmd = (uint16_t)(src[0] << 8 | src[1]);
+    m->response_len = 0;
+    m->response_us = host_time_us + SCD4X_COMMAND_US;
+
+    switch (cmd) {
+    case 0x21B1:    // start_periodic_measurement
+        if (m->periodic) return false;
+        m->periodic = true;
+        m->started_us = host_time_us;
+        m->taken = 0;
+        return true;
+    case 0x3F86:    // stop_periodic_measurement
+        m->periodic = false;
+        m->busy_until_us = host_time_us + SCD4X_STOP_US;
+        return true;
+    case 0x3682:    // get_serial_number
+        if (m->periodic) return false;
+        put_word(m, 0xABCD);
+        put_word(m, 0x1234);
+        put_word(m, 0x5678);
+        return true;
+    case 0xE4B8:    // get_data_ready_status
+        put_word(m, measurements_done(m) > m->taken ? 0x8006 : 0x8000);
+        return true;
+    case 0xEC05:    // read_measurement
+        if (measurements_done(m) <= m->taken) return true;     // Nothing to read, NAK on read
+        m->taken = measurements_done(m);
+        m->latched_co2 = m->co2_ppm;
+        m->latched_temp_c = m->temp_c;
+        m->latched_humidity = m->humidity;
+        put_word(m, (uint16_t)(m->co2_ppm + 0.5));
+        put_word(m, ticks(m->temp_c, 45, 175));
+        put_word(m, ticks(m->humidity, 0, 100));
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool scd4x_read(sim_device *dev, uint8_t *dst, size_t len) {
+    sim_scd4x *m = dev->model;
+    if (host_time_us < m->response_us || len > (size_t)m->response_len) return false;
+    memcpy(dst, m->response, len);
+    m->response_len = 0;
+    return true;
+}
+
+void sim_scd4x_power_on(sim_scd4x *m) {
+    m->periodic = false;
+    m->taken = 0;
+    m->busy_until_us = 0;
+    m->response_len = 0;
+}
+
+void sim_scd4x_init(sim_scd4x *m) {
+    memset(m, 0, sizeof(*m));
+    m->dev.address = 0x62;
+    m->dev.write = scd4x_write;
+    m->dev.read = scd4x_read;
+    m->dev.model = m;
+    m->temp_c = 22.0;
+    m->humidity = 40.0;
+    m->co2_ppm = 600;
+    // Left running from before a reset, as after a soft reboot
+    m->periodic = true;
+}
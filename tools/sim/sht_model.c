@@ -0,0 +1,91 @@
+/**
+ * SHT4x / SHT3x model
+ *
+ * SHT4x takes 1-byte commands, SHT3x 2-byte ones; each NAKs the other's.
+ * A measurement is readable once its conversion time has passed, reading
+ * before that (or with nothing to read) is NAKed.
+ */
+
+#include <string.h>
+#include "host.h"
+#include "i2c_sim.h"
+
+#define SHT4X_MEASURE_US 8300
+#define SHT3X_MEASURE_US 12500
+
+static uint16_t clamp_ticks(double ticks) {
+    if (ticks < 0) return 0;
+    if (ticks > 65535) return 65535;
+    return (uint16_t)(ticks + 0.5);
+}
+
+static void put_word(sim_sht *m, uint16_t word) {
+    uint8_t *p = &m->response[m->response_len];
+    p[0] = word >> 8;
+    p[1] = word & 0xFF;
+    p[2] = sim_crc8(p, 2);
+    m->response_len += 3;
+}
+
+static bool sht_write(sim_device *dev, const uint8_t *src, size_t len) {
+    sim_sht *m = dev->model;
+    m->response_len = 0;
+    m->ready_us = 0;
+
+    if (m->is_sht4x) {
+        if (len != 1) return false;
+        if (src[0] == 0xFD) {
+            m->ready_us = host_time_us + SHT4X_MEASURE_US;
+        } else if (src[0] == 0x89) {
+            put_word(m, 0x1234);
+            put_word(m, 0x5678);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    if (len != 2) return len < 2;   // A lone first byte is ACKed and ignored
+    uint16_t cmd = (uint16_t)(src[0] << 8 | src[1]);
+    if (cmd == 0x2400) {
+        m->ready_us = host_time_us + SHT3X_MEASURE_US;
+    } else if (cmd == 0xF32D) {
+        put_word(m, 0x8010);
+    } else if (cmd != 0x30A2) {
+        return false;
+    }
+    return true;
+}
+
+static bool sht_read(sim_device *dev, uint8_t *dst, size_t len) {
+    sim_sht *m = dev->model;
+
+    if (m->ready_us != 0) {
+        if (host_time_us < m->ready_us) return false;   // Still converting
+        m->latched_temp_c = m->temp_c;
+        m->latched_humidity = m->humidity;
+        uint16_t t = clamp_ticks((m->temp_c + 45) * 65535 / 175);
+        uint16_t rh = m->is_sht4x ? clamp_ticks((m->humidity + 6) * 65535 / 125)
+                                  : clamp_ticks(m->humidity * 65535 / 100);
+        m->response_len = 0;
+        put_word(m, t);
+        put_word(m, rh);
+        m->ready_us = 0;
+    }
+    if (m->response_len == 0 || len > (size_t)m->response_len) return false;
+
+    memcpy(dst, m->response, len);
+    m->response_len = 0;
+    return true;
+}
+
+void sim_sht_init(sim_sht *m, uint8_t address, bool is_sht4x) {
+    memset(m, 0, sizeof(*m));
+    m->dev.address = address;
+    m->dev.write = sht_write;
+    m->dev.read = sht_read;
+    m->dev.model = m;
+    m->is_sht4x = is_sht4x;
+    m->temp_c = 21.0;
+    m->humidity = 45.0;
+}
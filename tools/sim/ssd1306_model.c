@@ -0,0 +1,265 @@
+/**
+ * SSD1306 model
+ *
+ * Interprets the I2C byte stream like the controller: control bytes
+ * (continuation and data/command bits), multi-byte commands that may be
+ * split across transactions, the three addressing modes with their column
+ * and page windows, and the hardware configuration that decides how
+ * GDDRAM reaches the glass (segment remap, COM scan direction, multiplex
+ * ratio, start line, display offset and COM pin layout). Reads are NAKed,
+ * the controller is write-only on I2C.
+ *
+ * On 4-wire SPI there are no control bytes: the D/C line tells commands
+ * from data, and only bytes sent with chip select low count.
+ *
+ * GDDRAM powers up with a fixed noise pattern, so anything the driver
+ * forgets to clear shows up in the snapshots.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host.h"
+#include "i2c_sim.h"
+
+#define CONTROL_CONTINUATION 0x80   // Another control byte follows the next byte
+#define CONTROL_DATA 0x40           // Following bytes go to GDDRAM
+
+// Bytes in a command, including the command itself
+static int command_length(uint8_t cmd) {
+    switch (cmd) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 2;
+    case 0x21: case 0x22: case 0xA3:
+        return 3;
+    case 0x29: case 0x2A:
+        return 6;
+    case 0x26: case 0x27:
+        return 7;
+    default:
+        return 1;
+    }
+}
+
+static void execute(sim_ssd1306 *m) {
+    const uint8_t *c = m->command;
+
+    if (c[0] <= 0x0F) {
+        if (m->mode == SIM_SSD1306_PAGE) m->col = (m->col & 0xF0) | c[0];
+    } else if (c[0] <= 0x1F) {
+        if (m->mode == SIM_SSD1306_PAGE) m->col = (uint8_t)((m->col & 0x0F) | (c[0] & 0x07) << 4);
+    } else if (c[0] >= 0x40 && c[0] <= 0x7F) {
+        m->start_line = c[0] & 0x3F;
+    } else if (c[0] >= 0xB0 && c[0] <= 0xB7) {
+        if (m->mode == SIM_SSD1306_PAGE) m->page = c[0] & 0x07;
+    } else {
+        switch (c[0]) {
+        case 0x20:
+            // 3 is invalid and ignored by the chip
+            if ((c[1] & 0x03) != 3) m->mode = (sim_ssd1306_mode)(c[1] & 0x03);
+            break;
+        case 0x21:
+            m->col_start = m->col = c[1] & 0x7F;
+            m->col_end = c[2] & 0x7F;
+            break;
+        case 0x22:
+            m->page_start = m->page = c[1] & 0x07;
+            m->page_end = c[2] & 0x07;
+            break;
+        case 0x81: m->contrast = c[1]; break;
+        case 0x8D: m->charge_pump = (c[1] & 0x04) != 0; break;
+        case 0xA0: case 0xA1: m->seg_remap = c[0] & 1; break;
+        case 0xA4: case 0xA5: m->entire_on = c[0] & 1; break;
+        case 0xA6: case 0xA7: m->inverse = c[0] & 1; break;
+        case 0xA8: if ((c[1] & 0x3F) >= 15) m->mux = c[1] & 0x3F; break;
+        case 0xAE: case 0xAF: m->display_on = c[0] & 1; break;
+        case 0xC0: case 0xC8: m->com_scan_dec = (c[0] & 0x08) != 0; break;
+        case 0xD3: m->offset = c[1] & 0x3F; break;
+        case 0xDA: m->com_pins = c[1] & 0x32; break;
+        // Timing, voltages, scrolling and NOP change nothing on a snapshot
+        case 0xA3: case 0xD5: case 0xD9: case 0xDB: case 0xE3:
+        case 0x26: case 0x27: case 0x29: case 0x2A: case 0x2E: case 0x2F:
+            break;
+        default:
+            m->unknown_commands++;
+            break;
+        }
+    }
+}
+
+static void command_byte(sim_ssd1306 *m, uint8_t byte) {
+    m->command[m->command_len++] = byte;
+    m->frame.command_bytes++;
+    m->total.command_bytes++;
+    if (m->command_len == command_length(m->command[0])) {
+        execute(m);
+        m->command_len = 0;
+    }
+}
+
+static void data_byte(sim_ssd1306 *m, uint8_t byte) {
+    m->gddram[m->page][m->col] = byte;
+    m->frame.data_bytes++;
+    m->total.data_bytes++;
+
+    switch (m->mode) {
+    case SIM_SSD1306_HORIZONTAL:
+        if (m->col++ >= m->col_end) {
+            m->col = m->col_start;
+            if (m->page++ >= m->page_end) m->page = m->page_start;
+        }
+        break;
+    case SIM_SSD1306_VERTICAL:
+        if (m->page++ >= m->page_end) {
+            m->page = m->page_start;
+            if (m->col++ >= m->col_end) m->col = m->col_start;
+        }
+        break;
+    case SIM_SSD1306_PAGE:
+        // Wraps within the page, the page pointer stays
+        m->col = (m->col + 1) & 0x7F;
+        break;
+    }
+}
+
+static bool ssd1306_write(sim_device *dev, const uint8_t *src, size_t len) {
+    sim_ssd1306 *m = dev->model;
+    m->frame.transactions++;
+    m->total.transactions++;
+    m->frame.bytes += 1 + len;
+    m->total.bytes += 1 + len;
+
+    size_t i = 0;
+    while (i < len) {
+        uint8_t control = src[i++];
+        bool data = (control & CONTROL_DATA) != 0;
+        // Without continuation the rest of the transaction is all one kind
+        size_t n = control & CONTROL_CONTINUATION ? 1 : len - i;
+        for (; n > 0 && i < len; n--, i++) {
+            if (data) data_byte(m, src[i]);
+            else command_byte(m, src[i]);
+        }
+    }
+    return true;
+}
+
+// The panel on SPI, the host hook has no context
+static sim_ssd1306 *spi_panel = NULL;
+
+static void ssd1306_spi_write(const uint8_t *src, size_t len) {
+    sim_ssd1306 *m = spi_panel;
+    if (m == NULL || host_gpio_out[m->cs_pin]) {
+        return;     // Not selected
+    }
+    m->frame.transactions++;
+    m->total.transactions++;
+    m->frame.bytes += len;
+    m->total.bytes += len;
+
+    bool data = host_gpio_out[m->dc_pin];
+    for (size_t i = 0; i < len; i++) {
+        if (data) data_byte(m, src[i]);
+        else command_byte(m, src[i]);
+    }
+}
+
+void sim_ssd1306_attach_spi(sim_ssd1306 *m, unsigned int cs_pin, unsigned int dc_pin) {
+    m->cs_pin = cs_pin;
+    m->dc_pin = dc_pin;
+    spi_panel = m;
+    host_spi_write = ssd1306_spi_write;
+}
+
+static bool ssd1306_read(sim_device *dev, uint8_t *dst, size_t len) {
+    (void)dev; (void)dst; (void)len;
+    return false;
+}
+
+void sim_ssd1306_init(sim_ssd1306 *m, uint8_t address, uint8_t panel_height) {
+    memset(m, 0, sizeof(*m));
+    m->dev.address = address;
+    m->dev.write = ssd1306_write;
+    m->dev.read = ssd1306_read;
+    m->dev.model = m;
+    m->panel_height = panel_height == 64 ? 64 : 32;
+
+    // Datasheet reset values
+    m->mode = SIM_SSD1306_PAGE;
+    m->col_end = SIM_SSD1306_WIDTH - 1;
+    m->page_end = SIM_SSD1306_PAGES - 1;
+    m->mux = 63;
+    m->com_pins = 0x12;
+    m->contrast = 0x7F;
+
+    uint32_t noise = 0x12345678;
+    for (int p = 0; p < SIM_SSD1306_PAGES; p++) {
+        for (int x = 0; x < SIM_SSD1306_WIDTH; x++) {
+            noise = noise * 1664525 + 1013904223;
+            m->gddram[p][x] = noise >> 24;
+        }
+    }
+}
+
+void sim_ssd1306_new_frame(sim_ssd1306 *m) {
+    memset(&m->frame, 0, sizeof(m->frame));
+}
+
+// Pin a COM output drives: sequential, or alternating left/right
+static int com_pin(uint8_t com_pins, int com) {
+    int pin = com_pins & 0x10 ? (com < 32 ? 2 * com : 2 * (com - 32) + 1) : com;
+    if (com_pins & 0x20) pin ^= com_pins & 0x10 ? 1 : 32;      // Left/right remap
+    return pin;
+}
+
+// Row on the glass wired to a pin; 128x64 modules are wired for the
+// alternative layout (0x12), 128x32 ones for the sequential one (0x02)
+static int glass_row(const sim_ssd1306 *m, int pin) {
+    if (m->panel_height == 32) return pin;
+    return pin % 2 == 0 ? pin / 2 : 32 + pin / 2;
+}
+
+void sim_ssd1306_render(const sim_ssd1306 *m, uint8_t *pixels) {
+    int w = SIM_SSD1306_WIDTH, h = m->panel_height;
+    memset(pixels, 0, (size_t)w * h);
+    if (!m->display_on || !m->charge_pump) {
+        return;
+    }
+
+    int rows = m->mux + 1;
+    for (int com = 0; com < rows; com++) {
+        int row = glass_row(m, com_pin(m->com_pins, com));
+        if (row >= h) continue;
+        // The modules mount the glass upside down
+        uint8_t *out = &pixels[(h - 1 - row) * w];
+
+        int scan = m->com_scan_dec ? rows - 1 - com : com;
+        int line = (scan + m->start_line + m->offset) & 63;
+        for (int seg = 0; seg < w; seg++) {
+            int col = m->seg_remap ? w - 1 - seg : seg;
+            bool on = m->entire_on || ((m->gddram[line / 8][col] >> (line % 8)) & 1);
+            out[w - 1 - seg] = on != m->inverse;
+        }
+    }
+}
+
+bool sim_ssd1306_write_pbm(const sim_ssd1306 *m, const char *path) {
+    uint8_t pixels[SIM_SSD1306_WIDTH * 64];
+    sim_ssd1306_render(m, pixels);
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    // PBM is black on white, lit pixels are drawn white like the panel
+    fprintf(f, "P4\n%d %d\n", SIM_SSD1306_WIDTH, m->panel_height);
+    for (int y = 0; y < m->panel_height; y++) {
+        for (int x = 0; x < SIM_SSD1306_WIDTH; x += 8) {
+            uint8_t packed = 0;
+            for (int b = 0; b < 8; b++) {
+                if (!pixels[y * SIM_SSD1306_WIDTH + x + b]) packed |= 0x80 >> b;
+            }
+            fputc(packed, f);
+        }
+    }
+    return fclose(f) == 0;
+}
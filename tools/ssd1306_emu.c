@@ -0,0 +1,232 @@
+/**
+ * SSD1306 emulator test
+ *
+ * Drives the firmware's display path (ssd1306.c, the screens and their
+ * widgets) into a model of the controller (tools/sim/ssd1306_model.c),
+ * once on a simulated I2C bus and once on SPI, and checks what reaches
+ * the glass:
+ *
+ *   - the init sequence leaves the controller in the expected mode
+ *   - after every flush the panel shows exactly the framebuffer, upright
+ *   - a full ssd1306_display() of the same framebuffer shows the same
+ *
+ * and reports the bus cost of every frame next to that of a full frame,
+ * with the flush times the driver measured on the virtual clock (I2C at
+ * 400 kHz, SPI at 10 MHz). With -o, every frame is also written as a PBM
+ * snapshot.
+ *
+ * Usage: ssd1306_emu [-v] [-o dir]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "i2c_sim.h"
+#include "sensors.h"
+#include "screens.h"
+#include "ssd1306.h"
+
+#define FRAMES 24
+#define FRAMES_PER_SCREEN 4
+#define STEP_MS 15000
+#define I2C_HZ 400000
+#define SPI_HZ 10000000
+
+static sim_ssd1306 panel;
+static ssd1306_t oled;
+static sensor_data data;
+
+static const ssd1306_spi_pins spi_pins = {.cs = 5, .dc = 4, .reset = 6};
+
+static bool verbose = false;
+static const char *out_dir = NULL;
+
+// Feed the sensors a slowly changing environment
+static void update_data(int step, uint32_t now_ms) {
+    dht_reading r = {
+        .temp_x10 = (int16_t)(215 + (step * 7) % 40),
+        .humidity_x10 = (uint16_t)(480 + (step * 13) % 90),
+        .error = false
+    };
+    r.temp = r.temp_x10 / 10.0f;
+    r.humidity = r.humidity_x10 / 10.0f;
+    sensors_apply_dht(&data, &r, now_ms);
+    sensors_update_warmup(&data, now_ms, 0, 0);
+    sensors_apply_adc(&data, (uint16_t)(1200 + step * 37), now_ms);
+
+    // A BME280's pressure for the comfort screen's bottom row
+    env_reading env = {.valid = 1u << ENV_PRESSURE};
+    env.value[ENV_PRESSURE] = 100800 + (step * 53) % 1200;
+    sensors_apply_env(&data, &env, 1u << ENV_PRESSURE, now_ms);
+}
+
+// Panel image against the framebuffer, pixel by pixel
+static bool check_image(const char *what, int frame) {
+    uint8_t pixels[SIM_SSD1306_WIDTH * 64];
+    sim_ssd1306_render(&panel, pixels);
+    for (int y = 0; y < oled.height; y++) {
+        for (int x = 0; x < oled.width; x++) {
+            bool want = (oled.buffer[(y / 8) * oled.width + x] >> (y % 8)) & 1;
+            if (pixels[y * SIM_SSD1306_WIDTH + x] != want) {
+                fprintf(stderr, "128x%d frame %d (%s): pixel (%d,%d) is %d, framebuffer %d\n",
+                        oled.height, frame, what, x, y, pixels[y * SIM_SSD1306_WIDTH + x], want);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool check_init(void) {
+    bool ok = panel.display_on && panel.charge_pump && panel.mode == SIM_SSD1306_HORIZONTAL &&
+              panel.seg_remap && panel.com_scan_dec && panel.mux == oled.height - 1 &&
+              panel.offset == 0 && panel.start_line == 0 && !panel.inverse &&
+              !panel.entire_on && panel.unknown_commands == 0 && panel.command_len == 0;
+    if (!ok) {
+        fprintf(stderr, "128x%d: unexpected controller state after init\n", oled.height);
+    }
+    return ok;
+}
+
+static bool run_panel(uint8_t height, ssd1306_bus bus) {
+    sim_i2c_detach_all();
+    sim_ssd1306_init(&panel, SSD1306_ADDRESS_1, height);
+    sensors_init(&data);
+
+    bool found;
+    if (bus == SSD1306_BUS_SPI) {
+        sim_ssd1306_attach_spi(&panel, spi_pins.cs, spi_pins.dc);
+        spi_init(spi0, SPI_HZ);
+        found = ssd1306_init_spi(&oled, spi0, &spi_pins, height);
+    } else {
+        sim_i2c_attach(&panel.dev);
+        found = ssd1306_init(&oled, i2c0, height);
+    }
+    if (!found || !check_init()) {
+        return false;
+    }
+    uint32_t init_bytes = panel.total.bytes;
+
+    // Cost of a full frame for comparison
+    sim_ssd1306_new_frame(&panel);
+    ssd1306_display(&oled);
+    sim_ssd1306_stats full = panel.frame;
+    uint32_t full_us = oled.timing.last_us;
+    ssd1306_timing before = oled.timing;
+
+    uint32_t total_bytes = 0, total_transactions = 0, max_us = 0;
+    bool ok = true;
+    if (verbose) {
+        printf("%5s %7s %7s %7s %7s %7s\n", "frame", "screen", "trans", "bytes", "data", "us");
+    }
+
+    for (int frame = 0; frame < FRAMES && ok; frame++) {
+        uint32_t now_ms = frame * STEP_MS;
+        int screen = (frame / FRAMES_PER_SCREEN) % SCREEN_COUNT;
+        update_data(frame, now_ms);
+
+        sim_ssd1306_new_frame(&panel);
+        uint32_t flush_us = 0;
+        if (screens_render(&oled, screen, &data, now_ms)) {
+            ssd1306_flush(&oled);
+            ssd1306_wait(&oled);
+            flush_us = oled.timing.last_us;
+            if (flush_us > max_us) max_us = flush_us;
+        }
+        ok = check_image("flush", frame);
+        total_bytes += panel.frame.bytes;
+        total_transactions += panel.frame.transactions;
+        if (verbose) {
+            printf("%5d %7d %7u %7u %7u %7u\n", frame, screen, (unsigned)panel.frame.transactions,
+                   (unsigned)panel.frame.bytes, (unsigned)panel.frame.data_bytes, (unsigned)flush_us);
+        }
+
+        if (ok && out_dir != NULL) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/oled%d_%s_%02d.pbm", out_dir, height,
+                     bus == SSD1306_BUS_SPI ? "spi" : "i2c", frame);
+            if (!sim_ssd1306_write_pbm(&panel, path)) {
+                fprintf(stderr, "Cannot write %s\n", path);
+                ok = false;
+            }
+        }
+    }
+
+    uint32_t flushes = oled.timing.frames - before.frames;
+    double flush_ms = flushes > 0 ? (oled.timing.total_us - before.total_us) / 1000.0 / flushes : 0;
+
+    // The whole framebuffer again must not change the picture
+    if (ok) {
+        ssd1306_display(&oled);
+        ok = check_image("display", FRAMES - 1);
+    }
+    if (ok && panel.unknown_commands != 0) {
+        fprintf(stderr, "128x%d: %u unknown commands\n", height, (unsigned)panel.unknown_commands);
+        ok = false;
+    }
+
+    printf("128x%d %s: init %u bytes, full frame %u bytes in %u transactions %.2f ms, "
+           "flush %.1f bytes in %.1f transactions per frame (%.0f %% of full) %.2f ms, max %.2f ms\n",
+           height, bus == SSD1306_BUS_SPI ? "SPI" : "I2C", (unsigned)init_bytes,
+           (unsigned)full.bytes, (unsigned)full.transactions, full_us / 1000.0,
+           (double)total_bytes / FRAMES, (double)total_transactions / FRAMES,
+           100.0 * total_bytes / FRAMES / full.bytes, flush_ms, max_us / 1000.0);
+    return ok;
+}
+
+// Page and vertical addressing, which the driver does not use
+static bool check_model(void) {
+    sim_i2c_detach_all();
+    sim_ssd1306_init(&panel, SSD1306_ADDRESS_1, 64);
+    sim_i2c_attach(&panel.dev);
+
+    // Page mode: page 3, column 0x7E, wraps within the page
+    const uint8_t page_mode[] = {0x00, 0x20, 0x02, 0xB3, 0x0E, 0x17};
+    const uint8_t page_data[] = {0x40, 0xA1, 0xA2, 0xA3};
+    // Vertical mode in a 2x2 window, command split across a transaction
+    const uint8_t vertical[] = {0x00, 0x20, 0x01, 0x21, 10};
+    const uint8_t vertical_rest[] = {0x80, 11, 0x00, 0x22, 4, 5};
+    const uint8_t vertical_data[] = {0x40, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5};
+
+    i2c_write_blocking(i2c0, SSD1306_ADDRESS_1, page_mode, sizeof(page_mode), false);
+    i2c_write_blocking(i2c0, SSD1306_ADDRESS_1, page_data, sizeof(page_data), false);
+    i2c_write_blocking(i2c0, SSD1306_ADDRESS_1, vertical, sizeof(vertical), false);
+    i2c_write_blocking(i2c0, SSD1306_ADDRESS_1, vertical_rest, sizeof(vertical_rest), false);
+    i2c_write_blocking(i2c0, SSD1306_ADDRESS_1, vertical_data, sizeof(vertical_data), false);
+
+    // The fifth vertical byte wraps back to the window's first cell
+    bool ok = panel.gddram[3][126] == 0xA1 && panel.gddram[3][127] == 0xA2 &&
+              panel.gddram[3][0] == 0xA3 &&
+              panel.gddram[4][10] == 0xB5 && panel.gddram[5][10] == 0xB2 &&
+              panel.gddram[4][11] == 0xB3 && panel.gddram[5][11] == 0xB4 &&
+              panel.page == 5 && panel.col == 10 && panel.unknown_commands == 0;
+    if (!ok) {
+        fprintf(stderr, "Model addressing check failed\n");
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [-v] [-o dir]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    host_i2c_hz = I2C_HZ;
+    bool ok = check_model();
+    ok = ok && run_panel(32, SSD1306_BUS_I2C);
+    ok = ok && run_panel(64, SSD1306_BUS_I2C);
+    ok = ok && run_panel(32, SSD1306_BUS_SPI);
+    ok = ok && run_panel(64, SSD1306_BUS_SPI);
+    printf(ok ? "Panel matched the framebuffer on every frame\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
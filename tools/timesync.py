@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Keep a device's clock synchronised with this host.
+
+Sends "sync" requests over the serial console (see wallclock.h) with the
+host's Unix time in microseconds and hands back the receive time of each
+reply with the next request, so the device can estimate its offset and
+drift. Every other line from the device is printed as it arrives; with
+"--data" the device also streams timestamped samples ("#D" lines).
+
+Usage: timesync.py /dev/ttyACM0 [--interval 10] [--data]
+
+Needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import sys
+import time
+
+import serial
+
+
+def now_us():
+    return time.time_ns() // 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--interval", type=float, default=10.0,
+                        help="seconds between sync exchanges")
+    parser.add_argument("--data", action="store_true",
+                        help="ask the device to stream timestamped samples")
+    args = parser.parse_args()
+
+    port = serial.Serial(args.port, args.baud, timeout=0.05)
+    if args.data:
+        port.write(b"data on\n")
+
+    pending_t1 = None       # Request waiting for its reply
+    completed = None        # (t1, t4) of the last reply, sent with the next request
+    next_sync = 0.0
+    buffer = b""
+
+    while True:
+        if time.monotonic() >= next_sync:
+            t1 = now_us()
+            request = f"sync {t1}"
+            if completed is not None:
+                request += f" {completed[0]} {completed[1]}"
+            port.write(request.encode() + b"\n")
+            pending_t1 = t1
+            next_sync = time.monotonic() + args.interval
+
+        chunk = port.read(256)
+        t4 = now_us()
+        if not chunk:
+            continue
+        buffer += chunk
+
+        while b"\n" in buffer:
+            raw, buffer = buffer.split(b"\n", 1)
+            line = raw.decode(errors="replace").rstrip("\r")
+            fields = line.split()
+            if len(fields) == 4 and fields[0] == "#S" and int(fields[1]) == pending_t1:
+                t1, t2, t3 = (int(f) for f in fields[1:])
+                offset = ((t1 - t2) + (t4 - t3)) // 2
+                rtt = (t4 - t1) - (t3 - t2)
+                print(f"sync: offset {offset} us, round trip {rtt} us", file=sys.stderr)
+                completed = (t1, t4)
+                pending_t1 = None
+            else:
+                print(line)
+
+
+if __name__ == "__main__":
+    main()
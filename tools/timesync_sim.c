@@ -0,0 +1,116 @@
+/**
+ * Clock synchronisation simulator
+ *
+ * Runs the timesync estimator (timesync.c) against simulated devices
+ * whose clocks have a random offset and drift, over a link with random,
+ * asymmetric delays like USB serial. Reports how far the device's idea
+ * of host time is from the truth between exchanges.
+ *
+ * Usage: timesync_sim [devices] [hours] [sync_interval_s]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "timesync.h"
+
+// Simulated link: fixed latency plus exponential jitter, in microseconds
+#define LINK_BASE_US 300.0
+#define LINK_JITTER_US 400.0
+#define LINK_SPIKE_CHANCE 0.05      // Occasional host scheduling hiccup
+#define LINK_SPIKE_US 20000.0
+#define DEVICE_DELAY_US 150.0       // Between receive and reply on the device
+
+#define MAX_DRIFT_PPM 100.0
+#define CHECK_INTERVAL_US 1000000.0
+
+typedef struct {
+    double offset_us;       // Device clock at host time 0
+    double rate;            // Device seconds per host second
+} sim_clock;
+
+static double uniform(void) {
+    return (rand() + 0.5) / ((double)RAND_MAX + 1.0);
+}
+
+static double link_delay(void) {
+    double d = LINK_BASE_US - LINK_JITTER_US * log(uniform());
+    if (uniform() < LINK_SPIKE_CHANCE) d += LINK_SPIKE_US * uniform();
+    return d;
+}
+
+static int64_t device_time(const sim_clock *clk, double host_us) {
+    return (int64_t)(clk->offset_us + host_us * clk->rate);
+}
+
+int main(int argc, char **argv) {
+    int devices = argc > 1 ? atoi(argv[1]) : 8;
+    double hours = argc > 2 ? atof(argv[2]) : 24;
+    double interval_us = (argc > 3 ? atof(argv[3]) : 10) * 1e6;
+    double end_us = hours * 3600e6;
+
+    srand(1);
+    double worst_all = 0;
+
+    printf("%-7s %12s %12s %10s %10s %10s\n",
+           "device", "drift ppb", "est ppb", "mean us", "p99 us", "max us");
+
+    for (int d = 0; d < devices; d++) {
+        sim_clock clk = {
+            .offset_us = uniform() * 3600e6,
+            .rate = 1.0 + (uniform() * 2 - 1) * MAX_DRIFT_PPM * 1e-6
+        };
+        timesync ts;
+        timesync_init(&ts);
+
+        static double errors[1 << 20];
+        int n_errors = 0;
+        double next_check = 60e6;   // Judge after the first minute
+
+        for (double host = 0; host < end_us; host += interval_us) {
+            // One exchange
+            double t1 = host;
+            double recv = t1 + link_delay();
+            double send = recv + DEVICE_DELAY_US;
+            double t4 = send + link_delay();
+            timesync_add(&ts, (int64_t)t1, device_time(&clk, recv),
+                         device_time(&clk, send), (int64_t)t4);
+
+            // Error of the device's host time until the next exchange
+            for (; next_check < host + interval_us && next_check < end_us;
+                 next_check += CHECK_INTERVAL_US) {
+                if (next_check < host) continue;
+                int64_t est;
+                if (timesync_to_host(&ts, device_time(&clk, next_check), &est) &&
+                    n_errors < (int)(sizeof(errors) / sizeof(errors[0]))) {
+                    errors[n_errors++] = fabs((double)est - next_check);
+                }
+            }
+        }
+
+        // Sort for the percentile
+        double sum = 0, max = 0;
+        for (int i = 0; i < n_errors; i++) {
+            sum += errors[i];
+            if (errors[i] > max) max = errors[i];
+        }
+        int above = 0;
+        double p99 = 0;
+        for (double lim = 0; lim <= max; lim += 10) {
+            above = 0;
+            for (int i = 0; i < n_errors; i++) if (errors[i] > lim) above++;
+            if (above <= n_errors / 100) {
+                p99 = lim;
+                break;
+            }
+        }
+
+        printf("%-7d %12.0f %12ld %10.0f %10.0f %10.0f\n", d,
+               (1.0 / clk.rate - 1.0) * 1e9, (long)timesync_drift_ppb(&ts),
+               n_errors ? sum / n_errors : 0, p99, max);
+        if (max > worst_all) worst_all = max;
+    }
+
+    printf("Worst error over all devices: %.2f ms\n", worst_all / 1000);
+    return worst_all < 5000 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""
+Build the token database for tokenized logging.
+
+Scans C sources for LOG_ERROR/LOG_WARN/LOG_INFO/LOG_DEBUG calls (see
+log.h), hashes each format string the same way LOG_HASH does and writes
+a CSV with one line per format string:
+
+    token,level,location,format
+
+The firmware build runs this over its sources, so the database always
+matches the binary. Exits non-zero if two different strings share a
+token.
+
+Usage: tokendb.py -o tokens.csv file.c [more.c ...]
+"""
+
+import argparse
+import csv
+import re
+import sys
+
+HASH_LEN = 80           # LOG_HASH_LEN in log.h
+HASH_K = 65599
+
+LEVELS = {"ERROR": 1, "WARN": 2, "INFO": 3, "DEBUG": 4}
+
+# Macro name, then one or more adjacent string literals
+CALL = re.compile(r'\bLOG_(ERROR|WARN|INFO|DEBUG)\s*\(\s*((?:"(?:[^"\\]|\\.)*"\s*)+)', re.S)
+LITERAL = re.compile(r'"((?:[^"\\]|\\.)*)"', re.S)
+
+ESCAPES = {"n": 10, "t": 9, "r": 13, "0": 0, "\\": 92, '"': 34, "'": 39,
+           "a": 7, "b": 8, "f": 12, "v": 11, "?": 63}
+
+
+def unescape(text):
+    """Bytes of a C string literal body."""
+    out = bytearray()
+    raw = text.encode()
+    i = 0
+    while i < len(raw):
+        c = raw[i]
+        if c != 0x5C:
+            out.append(c)
+            i += 1
+            continue
+        esc = chr(raw[i + 1])
+        if esc == "x":
+            j = i + 2
+            while j < len(raw) and chr(raw[j]) in "0123456789abcdefABCDEF":
+                j += 1
+            out.append(int(raw[i + 2:j], 16) & 0xFF)
+            i = j
+        elif esc in "01234567":
+            j = i + 1
+            while j < len(raw) and j < i + 4 and chr(raw[j]) in "01234567":
+                j += 1
+            out.append(int(raw[i + 1:j], 8) & 0xFF)
+            i = j
+        else:
+            out.append(ESCAPES[esc])
+            i += 2
+    return bytes(out)
+
+
+def token(fmt):
+    """Same value as LOG_HASH(fmt)."""
+    h = len(fmt)
+    k = 1
+    for c in fmt[:HASH_LEN]:
+        k = (k * HASH_K) & 0xFFFFFFFF
+        h = (h + c * k) & 0xFFFFFFFF
+    return h
+
+
+def scan(path):
+    if path.endswith("log.h"):
+        return      # Only the macro definitions
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+    # Comments could hold example calls
+    source = re.sub(r"/\*.*?\*/", lambda m: re.sub(r"[^\n]", " ", m.group()), source, flags=re.S)
+    source = re.sub(r"//[^\n]*", "", source)
+    for m in CALL.finditer(source):
+        fmt = b"".join(unescape(lit) for lit in LITERAL.findall(m.group(2)))
+        line = source.count("\n", 0, m.start()) + 1
+        yield LEVELS[m.group(1)], f"{path}:{line}", fmt
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("sources", nargs="+")
+    args = parser.parse_args()
+
+    entries = {}
+    ok = True
+    for path in args.sources:
+        for level, location, fmt in scan(path):
+            t = token(fmt)
+            if t in entries and entries[t][2] != fmt:
+                print(f"{location}: token {t:08x} collides with {entries[t][1]}", file=sys.stderr)
+                ok = False
+                continue
+            entries.setdefault(t, (level, location, fmt))
+
+    with open(args.output, "w", newline="", encoding="utf-8") as f:
+        writer = csv.writer(f)
+        for t, (level, location, fmt) in sorted(entries.items()):
+            writer.writerow([f"{t:08x}", level, location, fmt.decode("utf-8", "replace")])
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
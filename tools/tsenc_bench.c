@@ -0,0 +1,205 @@
+/**
+ * Host benchmark for the compressed time-series encoder
+ *
+ * Encodes sample traces with tsenc, checks that decoding gives back
+ * the exact input and reports storage and speed per sample.
+ *
+ * Trace files are CSV with one sample per line:
+ *   t_ms,temp_x10,humidity_x10,co2_ppm
+ * Lines that do not start with a digit (headers, comments) are skipped.
+ *
+ * Usage:
+ *   tsenc_bench trace.csv [more.csv ...]
+ *   tsenc_bench --synthetic 100000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "../tsenc.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+// Size of the sensor_data struct the firmware would otherwise store
+#define RAW_SAMPLE_BYTES 16
+
+typedef struct {
+    tsenc_sample *samples;
+    size_t count;
+    size_t capacity;
+} trace;
+
+static void trace_push(trace *tr, const tsenc_sample *s) {
+    if (tr->count == tr->capacity) {
+        tr->capacity = tr->capacity ? tr->capacity * 2 : 1024;
+        tr->samples = realloc(tr->samples, tr->capacity * sizeof(tsenc_sample));
+        if (tr->samples == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    tr->samples[tr->count++] = *s;
+}
+
+// Field by field: the struct has padding that decoding does not write
+static bool same_sample(const tsenc_sample *a, const tsenc_sample *b) {
+    return a->t_ms == b->t_ms && a->temp_x10 == b->temp_x10 &&
+           a->humidity_x10 == b->humidity_x10 && a->co2_ppm == b->co2_ppm;
+}
+
+static bool load_csv(const char *path, trace *tr) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (!isdigit((unsigned char)line[0])) continue;
+
+        unsigned long t;
+        int temp;
+        unsigned hum, co2;
+        if (sscanf(line, "%lu,%d,%u,%u", &t, &temp, &hum, &co2) == 4) {
+            tsenc_sample s = {(uint32_t)t, (int16_t)temp, (uint16_t)hum, (uint16_t)co2};
+            trace_push(tr, &s);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Slow indoor drift plus sensor noise, sampled about every 2 s with jitter,
+// and the odd sample where the DHT22 had no reading
+static void make_synthetic(trace *tr, size_t n) {
+    double temp = 245, hum = 480, co2 = 450;
+    uint32_t t = 0;
+    srand(1);
+    for (size_t i = 0; i < n; i++) {
+        t += 2000 + (rand() % 5) - 2;
+        temp += ((rand() % 3) - 1) * 0.3;
+        hum += ((rand() % 3) - 1) * 0.5;
+        co2 += ((rand() % 21) - 10) + (i % 3000 < 600 ? 1.5 : -0.3);
+        if (co2 < 400) co2 = 400;
+        tsenc_sample s = {t, (int16_t)temp, (uint16_t)hum, (uint16_t)co2};
+        if (rand() % 500 == 0) {
+            s.temp_x10 = TSENC_NO_TEMP;
+            s.humidity_x10 = TSENC_NO_HUMIDITY;
+        }
+        trace_push(tr, &s);
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long cycles(void) {
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int run(const char *name, const trace *tr) {
+    size_t max_blocks = tr->count + 1;
+    tsenc_block *blocks = malloc(max_blocks * sizeof(tsenc_block));
+    tsenc_sample *decoded = malloc(tr->count * sizeof(tsenc_sample));
+    if (blocks == NULL || decoded == NULL) {
+        perror("malloc");
+        return 1;
+    }
+
+    // Encode
+    tsenc_encoder enc;
+    size_t nblocks = 1;
+    double t0 = now_ns();
+    unsigned long long c0 = cycles();
+    tsenc_encoder_init(&enc, &blocks[0]);
+    for (size_t i = 0; i < tr->count; i++) {
+        if (!tsenc_append(&enc, &tr->samples[i])) {
+            tsenc_encoder_init(&enc, &blocks[nblocks++]);
+            tsenc_append(&enc, &tr->samples[i]);
+        }
+    }
+    unsigned long long enc_cycles = cycles() - c0;
+    double enc_ns = now_ns() - t0;
+
+    // Decode
+    size_t n = 0;
+    t0 = now_ns();
+    c0 = cycles();
+    for (size_t b = 0; b < nblocks; b++) {
+        tsenc_reader rd;
+        tsenc_reader_init(&rd, &blocks[b]);
+        while (tsenc_read(&rd, &decoded[n])) n++;
+    }
+    unsigned long long dec_cycles = cycles() - c0;
+    double dec_ns = now_ns() - t0;
+
+    // Verify
+    bool same = n == tr->count;
+    for (size_t i = 0; same && i < n; i++) {
+        same = same_sample(&decoded[i], &tr->samples[i]);
+    }
+    if (!same) {
+        fprintf(stderr, "%s: round trip mismatch\n", name);
+        return 1;
+    }
+
+    size_t payload_bits = 0;
+    for (size_t b = 0; b < nblocks; b++) payload_bits += blocks[b].nbits;
+
+    double count = (double)tr->count;
+    printf("%s\n", name);
+    printf("  samples            %zu in %zu blocks\n", tr->count, nblocks);
+    printf("  bytes/sample       %.2f stored, %.2f payload (raw struct %d)\n",
+           nblocks * sizeof(tsenc_block) / count, payload_bits / 8.0 / count,
+           RAW_SAMPLE_BYTES);
+    printf("  encode             %.1f ns/sample", enc_ns / count);
+#ifdef HAVE_RDTSC
+    printf(", %.0f cycles/sample", enc_cycles / count);
+#endif
+    printf("\n  decode             %.1f ns/sample", dec_ns / count);
+#ifdef HAVE_RDTSC
+    printf(", %.0f cycles/sample", dec_cycles / count);
+#endif
+    printf("\n");
+
+    (void)enc_cycles;
+    (void)dec_cycles;
+    free(blocks);
+    free(decoded);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace.csv [...] | --synthetic N\n", argv[0]);
+        return 2;
+    }
+
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        trace tr = {0};
+        if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc) {
+            make_synthetic(&tr, strtoul(argv[++i], NULL, 10));
+            status |= run("synthetic", &tr);
+        } else if (load_csv(argv[i], &tr)) {
+            status |= run(argv[i], &tr);
+        } else {
+            status = 1;
+        }
+        free(tr.samples);
+    }
+    return status;
+}
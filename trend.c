@@ -0,0 +1,129 @@
+/**
+ * Online trend estimation
+ */
+
+#include <string.h>
+#include "trend.h"
+
+// Sums with every t moved by d
+static trend_sums sums_shift(const trend_sums *s, int64_t d) {
+    trend_sums r = {
+        .n = s->n,
+        .t = s->t + s->n * d,
+        .y = s->y,
+        .tt = s->tt + 2 * d * s->t + s->n * d * d,
+        .ty = s->ty + d * s->y
+    };
+    return r;
+}
+
+static void sums_add(trend_sums *a, const trend_sums *b, int sign) {
+    a->n += sign * b->n;
+    a->t += sign * b->t;
+    a->y += sign * b->y;
+    a->tt += sign * b->tt;
+    a->ty += sign * b->ty;
+}
+
+// Move the open bucket with sequence number seq into the ring
+static void window_close_bucket(trend_window *w, uint32_t seq, bool evicted) {
+    trend_sums *slot = &w->ring[seq % TREND_BUCKETS];
+    int64_t bucket_ms = w->clock.bucket_ms;
+
+    // The slot holds the bucket leaving the window, which starts at the
+    // origin of the totals; the next bucket becomes the origin
+    if (evicted) {
+        sums_add(&w->total, slot, -1);
+        w->total = sums_shift(&w->total, -bucket_ms);
+    }
+
+    *slot = w->open;
+    trend_sums shifted = sums_shift(slot, (int64_t)(w->clock.closed - 1) * bucket_ms);
+    sums_add(&w->total, &shifted, 1);
+    memset(&w->open, 0, sizeof(w->open));
+}
+
+// Roll the window forward to the bucket containing now_ms
+static void window_advance(trend_window *w, uint32_t now_ms) {
+    if (!bucket_ring_keep(&w->clock, now_ms)) {
+        bucket_ring clock = w->clock;
+        memset(w, 0, sizeof(*w));
+        w->clock = clock;
+    }
+    uint32_t seq;
+    bool evicted;
+    while (bucket_ring_close(&w->clock, now_ms, &seq, &evicted)) {
+        window_close_bucket(w, seq, evicted);
+    }
+}
+
+void trend_init(trend_window *w, uint32_t window_ms) {
+    memset(w, 0, sizeof(*w));
+    bucket_ring_init(&w->clock, window_ms, TREND_BUCKETS);
+}
+
+void trend_add(trend_window *w, int32_t value, uint32_t now_ms) {
+    window_advance(w, now_ms);
+
+    // Early samples count at the start of the open bucket
+    uint32_t open_start_ms = w->clock.open_start_ms;
+    int64_t t = (int32_t)(now_ms - open_start_ms) > 0 ? now_ms - open_start_ms : 0;
+    trend_sums *b = &w->open;
+    b->n++;
+    b->t += t;
+    b->y += value;
+    b->tt += t * t;
+    b->ty += t * value;
+}
+
+bool trend_get(trend_window *w, uint32_t now_ms, trend_fit *out) {
+    if (!w->clock.started) {
+        return false;
+    }
+    window_advance(w, now_ms);
+
+    // Everything relative to the start of the oldest closed bucket
+    int64_t origin_offset = (int64_t)w->clock.closed * w->clock.bucket_ms;
+    trend_sums s = sums_shift(&w->open, origin_offset);
+    sums_add(&s, &w->total, 1);
+    if (s.n < TREND_MIN_SAMPLES) {
+        return false;
+    }
+
+    // n^2 times the variance of the sample times
+    int64_t spread = s.n * s.tt - s.t * s.t;
+    if (spread < s.n * s.n * (int64_t)TREND_MIN_SPREAD_MS * TREND_MIN_SPREAD_MS) {
+        return false;
+    }
+
+    double slope = (double)(s.n * s.ty - s.t * s.y) / (double)spread;  // Per ms
+    double mean_t = (double)s.t / s.n;
+    double mean_y = (double)s.y / s.n;
+    double now_t = (double)(now_ms - w->clock.open_start_ms) + origin_offset;
+
+    out->count = (uint32_t)s.n;
+    out->slope_per_min = (float)(slope * 60000.0);
+    out->level = (float)(mean_y + slope * (now_t - mean_t));
+    return true;
+}
+
+int16_t trend_minutes_to(const trend_fit *fit, float threshold) {
+    float gap = threshold - fit->level;
+    if (gap == 0.0f) {
+        return 0;
+    }
+    // Heading towards the threshold means the slope has the gap's sign
+    if (gap * fit->slope_per_min <= 0.0f) {
+        return -1;
+    }
+    float minutes = gap / fit->slope_per_min;
+    return minutes > TREND_MAX_MINUTES ? -1 : (int16_t)(minutes + 0.5f);
+}
+
+trend_direction trend_classify(trend_direction prev, float slope_per_min, float on, float off) {
+    if (slope_per_min >= on) return TREND_RISING;
+    if (slope_per_min <= -on) return TREND_FALLING;
+    if (prev == TREND_RISING && slope_per_min >= off) return TREND_RISING;
+    if (prev == TREND_FALLING && slope_per_min <= -off) return TREND_FALLING;
+    return TREND_STEADY;
+}
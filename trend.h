@@ -0,0 +1,92 @@
+/**
+ * Online trend estimation
+ *
+ * Least-squares line through the samples of a sliding time window, for
+ * the rate of change of a channel and when it will reach a threshold.
+ * Like the statistics windows (stats.h) the window is a ring of
+ * TREND_BUCKETS fixed-width time buckets plus the one being filled
+ * (buckets.h), so it covers the same time span whatever the sample rate:
+ *
+ *   - each bucket keeps n, sum t, sum y, sum t^2 and sum t*y with t in ms
+ *     from the bucket's start
+ *   - the window totals are kept relative to the start of the oldest
+ *     bucket; a closing bucket is shifted into that origin and added, an
+ *     expiring one subtracted and the totals shifted to the next origin
+ *
+ * Every update is O(1) and memory is fixed. The sums are exact 64-bit
+ * integers; only the final fit is done in floating point.
+ */
+
+#ifndef TREND_H
+#define TREND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "buckets.h"
+
+#define TREND_BUCKETS 30
+
+// Samples and spread of their times (standard deviation) needed for a fit
+#define TREND_MIN_SAMPLES 5
+#define TREND_MIN_SPREAD_MS 30000
+
+// Threshold crossings further out than this are not reported
+#define TREND_MAX_MINUTES 240
+
+typedef struct {
+    int64_t n;
+    int64_t t;      // Sum of t
+    int64_t y;      // Sum of y
+    int64_t tt;     // Sum of t^2
+    int64_t ty;     // Sum of t*y
+} trend_sums;
+
+typedef struct {
+    bucket_ring clock;
+    trend_sums open;                    // Relative to clock.open_start_ms
+    trend_sums ring[TREND_BUCKETS];     // Closed buckets, each relative to its own start
+    trend_sums total;                   // Closed buckets, relative to the oldest one's start
+} trend_window;
+
+typedef enum {
+    TREND_STEADY,
+    TREND_RISING,
+    TREND_FALLING
+} trend_direction;
+
+typedef struct {
+    uint32_t count;         // Samples in the fit
+    float slope_per_min;    // Units per minute
+    float level;            // Value of the fitted line now
+} trend_fit;
+
+// The window spans window_ms (split into TREND_BUCKETS buckets)
+void trend_init(trend_window *w, uint32_t window_ms);
+
+// Add a sample taken at now_ms
+void trend_add(trend_window *w, int32_t value, uint32_t now_ms);
+
+/**
+ * Fit a line to the window as of now_ms
+ *
+ * @return false if there are too few samples, or they are too close
+ *         together in time, for a meaningful slope
+ */
+bool trend_get(trend_window *w, uint32_t now_ms, trend_fit *out);
+
+/**
+ * Minutes until the fitted line crosses a threshold
+ *
+ * @return -1 if the line is moving away from the threshold (or flat), or
+ *         would take more than TREND_MAX_MINUTES to get there
+ */
+int16_t trend_minutes_to(const trend_fit *fit, float threshold);
+
+/**
+ * Direction with hysteresis: a slope of at least `on` units per minute
+ * either way starts rising or falling, it stays until the slope drops
+ * below `off`
+ */
+trend_direction trend_classify(trend_direction prev, float slope_per_min, float on, float off);
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * Compressed time-series encoding for sensor history
+ *
+ * Block layout (MSB first):
+ *   first sample: t_ms (32) temp (16) humidity (16) co2 (16)
+ *   each further sample:
+ *     timestamp delta-of-delta
+ *       '0'                    dod == 0
+ *       '10'   + 7 bits        zig-zag dod < 2^7
+ *       '110'  + 9 bits        zig-zag dod < 2^9
+ *       '1110' + 12 bits       zig-zag dod < 2^12
+ *       '1111' + 32 bits       anything else
+ *     then for temp, humidity and co2 the zig-zag delta from the previous value
+ *       '0'                    unchanged
+ *       '10'  + 4 bits
+ *       '110' + 8 bits
+ *       '111' + 17 bits
+ */
+
+#include <string.h>
+#include "tsenc.h"
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void put_bits(tsenc_block *block, uint32_t value, int n) {
+    uint16_t pos = block->nbits;
+    while (n > 0) {
+        int room = 8 - (pos & 7);
+        int take = n < room ? n : room;
+        uint8_t bits = (value >> (n - take)) & ((1u << take) - 1);
+        block->data[pos >> 3] |= bits << (room - take);
+        pos += take;
+        n -= take;
+    }
+    block->nbits = pos;
+}
+
+static uint32_t get_bits(tsenc_reader *rd, int n) {
+    uint32_t value = 0;
+    uint16_t pos = rd->bit_pos;
+    while (n > 0) {
+        int room = 8 - (pos & 7);
+        int take = n < room ? n : room;
+        uint8_t byte = rd->block->data[pos >> 3];
+        value = (value << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        pos += take;
+        n -= take;
+    }
+    rd->bit_pos = pos;
+    return value;
+}
+
+// Number of bits the timestamp field needs for a given delta-of-delta
+static int dod_bits(uint32_t zz) {
+    if (zz == 0) return 1;
+    if (zz < (1u << 7)) return 2 + 7;
+    if (zz < (1u << 9)) return 3 + 9;
+    if (zz < (1u << 12)) return 4 + 12;
+    return 4 + 32;
+}
+
+static int value_bits(uint32_t zz) {
+    if (zz == 0) return 1;
+    if (zz < (1u << 4)) return 2 + 4;
+    if (zz < (1u << 8)) return 3 + 8;
+    return 3 + 17;
+}
+
+static void put_dod(tsenc_block *block, uint32_t zz) {
+    switch (dod_bits(zz)) {
+    case 1:       put_bits(block, 0x0, 1); break;
+    case 2 + 7:   put_bits(block, 0x2, 2); put_bits(block, zz, 7); break;
+    case 3 + 9:   put_bits(block, 0x6, 3); put_bits(block, zz, 9); break;
+    case 4 + 12:  put_bits(block, 0xE, 4); put_bits(block, zz, 12); break;
+    default:      put_bits(block, 0xF, 4); put_bits(block, zz, 32); break;
+    }
+}
+
+static void put_value(tsenc_block *block, uint32_t zz) {
+    switch (value_bits(zz)) {
+    case 1:       put_bits(block, 0x0, 1); break;
+    case 2 + 4:   put_bits(block, 0x2, 2); put_bits(block, zz, 4); break;
+    case 3 + 8:   put_bits(block, 0x6, 3); put_bits(block, zz, 8); break;
+    default:      put_bits(block, 0x7, 3); put_bits(block, zz, 17); break;
+    }
+}
+
+static uint32_t get_dod(tsenc_reader *rd) {
+    if (get_bits(rd, 1) == 0) return 0;
+    if (get_bits(rd, 1) == 0) return get_bits(rd, 7);
+    if (get_bits(rd, 1) == 0) return get_bits(rd, 9);
+    if (get_bits(rd, 1) == 0) return get_bits(rd, 12);
+    return get_bits(rd, 32);
+}
+
+static uint32_t get_value(tsenc_reader *rd) {
+    if (get_bits(rd, 1) == 0) return 0;
+    if (get_bits(rd, 1) == 0) return get_bits(rd, 4);
+    if (get_bits(rd, 1) == 0) return get_bits(rd, 8);
+    return get_bits(rd, 17);
+}
+
+void tsenc_encoder_init(tsenc_encoder *enc, tsenc_block *block) {
+    memset(block, 0, sizeof(*block));
+    memset(enc, 0, sizeof(*enc));
+    enc->block = block;
+}
+
+bool tsenc_append(tsenc_encoder *enc, const tsenc_sample *s) {
+    tsenc_block *block = enc->block;
+
+    if (block->count == 0) {
+        put_bits(block, s->t_ms, 32);
+        put_bits(block, (uint16_t)s->temp_x10, 16);
+        put_bits(block, s->humidity_x10, 16);
+        put_bits(block, s->co2_ppm, 16);
+        block->t_first = s->t_ms;
+    } else {
+        int32_t delta = (int32_t)(s->t_ms - enc->prev.t_ms);
+        uint32_t zz_t = zigzag(delta - enc->prev_delta);
+        uint32_t zz_temp = zigzag((int32_t)s->temp_x10 - enc->prev.temp_x10);
+        uint32_t zz_hum = zigzag((int32_t)s->humidity_x10 - enc->prev.humidity_x10);
+        uint32_t zz_co2 = zigzag((int32_t)s->co2_ppm - enc->prev.co2_ppm);
+
+        int needed = dod_bits(zz_t) + value_bits(zz_temp) +
+                     value_bits(zz_hum) + value_bits(zz_co2);
+        if (block->nbits + needed > TSENC_BLOCK_BITS) {
+            return false;
+        }
+
+        put_dod(block, zz_t);
+        put_value(block, zz_temp);
+        put_value(block, zz_hum);
+        put_value(block, zz_co2);
+        enc->prev_delta = delta;
+    }
+
+    block->t_last = s->t_ms;
+    block->count++;
+    enc->prev = *s;
+    return true;
+}
+
+void tsenc_reader_init(tsenc_reader *rd, const tsenc_block *block) {
+    memset(rd, 0, sizeof(*rd));
+    rd->block = block;
+}
+
+bool tsenc_read(tsenc_reader *rd, tsenc_sample *out) {
+    if (rd->index >= rd->block->count) {
+        return false;
+    }
+
+    if (rd->index == 0) {
+        rd->prev.t_ms = get_bits(rd, 32);
+        rd->prev.temp_x10 = (int16_t)get_bits(rd, 16);
+        rd->prev.humidity_x10 = get_bits(rd, 16);
+        rd->prev.co2_ppm = get_bits(rd, 16);
+    } else {
+        int32_t delta = rd->prev_delta + unzigzag(get_dod(rd));
+        rd->prev.t_ms += (uint32_t)delta;
+        rd->prev_delta = delta;
+        rd->prev.temp_x10 += unzigzag(get_value(rd));
+        rd->prev.humidity_x10 += unzigzag(get_value(rd));
+        rd->prev.co2_ppm += unzigzag(get_value(rd));
+    }
+
+    rd->index++;
+    *out = rd->prev;
+    return true;
+}
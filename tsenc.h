@@ -0,0 +1,72 @@
+/**
+ * Compressed time-series encoding for sensor history
+ *
+ * Gorilla-style append-only encoder for the three sensor channels.
+ * Timestamps are stored as delta-of-delta, readings as zig-zag deltas
+ * of fixed-point values. Samples are bit-packed into fixed-size blocks
+ * that carry their own starting point, so any block can be decoded
+ * without looking at the ones before it.
+ */
+
+#ifndef TSENC_H
+#define TSENC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Payload bytes per block (block struct is 128 bytes in total)
+#define TSENC_BLOCK_BYTES 116
+#define TSENC_BLOCK_BITS (TSENC_BLOCK_BYTES * 8)
+
+// Stored for a quantity that had no reading
+#define TSENC_NO_TEMP INT16_MIN
+#define TSENC_NO_HUMIDITY UINT16_MAX
+#define TSENC_NO_CO2 0
+
+// One sample in fixed point
+typedef struct {
+    uint32_t t_ms;          // Milliseconds since boot
+    int16_t temp_x10;       // Temperature in tenths of a degree C
+    uint16_t humidity_x10;  // Relative humidity in tenths of a percent
+    uint16_t co2_ppm;       // CO2 estimate in ppm
+} tsenc_sample;
+
+// A self-contained block of encoded samples
+typedef struct {
+    uint32_t t_first;       // Timestamp of the first sample
+    uint32_t t_last;        // Timestamp of the last sample
+    uint16_t count;         // Number of samples in the block
+    uint16_t nbits;         // Number of payload bits used
+    uint8_t data[TSENC_BLOCK_BYTES];
+} tsenc_block;
+
+// Encoder state for the block currently being filled
+typedef struct {
+    tsenc_block *block;
+    tsenc_sample prev;
+    int32_t prev_delta;
+} tsenc_encoder;
+
+// Sequential decoder over one block
+typedef struct {
+    const tsenc_block *block;
+    uint16_t bit_pos;
+    uint16_t index;
+    tsenc_sample prev;
+    int32_t prev_delta;
+} tsenc_reader;
+
+void tsenc_encoder_init(tsenc_encoder *enc, tsenc_block *block);
+
+/**
+ * Append a sample to the current block
+ *
+ * @return false if the block has no room left; the sample is not written
+ *         and the caller should start a new block
+ */
+bool tsenc_append(tsenc_encoder *enc, const tsenc_sample *s);
+
+void tsenc_reader_init(tsenc_reader *rd, const tsenc_block *block);
+bool tsenc_read(tsenc_reader *rd, tsenc_sample *out);
+
+#endif
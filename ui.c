@@ -0,0 +1,74 @@
+/**
+ * Display UI state machine
+ */
+
+#include <stdio.h>
+#include "log.h"
+#include "screens.h"
+#include "ui.h"
+
+// Version of the data a screen shows
+static uint32_t screen_version(int screen, const sensor_data *data) {
+    switch (screen) {
+    case SCREEN_TEMP:
+    case SCREEN_HUMIDITY:
+        return data->dht_version;
+    case SCREEN_COMFORT:
+        return data->dht_version + data->env_version;   // Pressure row
+    case SCREEN_AQI:
+        return data->co2_version;
+    default:
+        return data->stats_version;
+    }
+}
+
+void ui_init(ui_state *ui, uint32_t now_ms) {
+    ui->screen = SCREEN_TEMP;
+    ui->screen_before_press = SCREEN_TEMP;
+    ui->auto_cycle = true;
+    ui->next_cycle_ms = now_ms + UI_CYCLE_MS;
+    ui->shown_screen = -1;
+    ui->shown_version = 0;
+}
+
+void ui_button(ui_state *ui, button_event event, uint32_t now_ms) {
+    if (event == BUTTON_PRESS) {
+        ui->screen_before_press = ui->screen;
+        ui->screen = (ui->screen + 1) % SCREEN_COUNT;
+        ui->next_cycle_ms = now_ms + UI_CYCLE_MS;
+    } else if (event == BUTTON_LONG) {
+        ui->screen = ui->screen_before_press;
+        ui->auto_cycle = !ui->auto_cycle;
+        ui->next_cycle_ms = now_ms + UI_CYCLE_MS;
+        if (ui->auto_cycle) {
+            LOG_INFO("Screens cycling");
+        } else {
+            LOG_INFO("Screen pinned");
+        }
+    }
+}
+
+void ui_tick(ui_state *ui, uint32_t now_ms) {
+    if (ui->auto_cycle && (int32_t)(now_ms - ui->next_cycle_ms) >= 0) {
+        ui->screen = (ui->screen + 1) % SCREEN_COUNT;
+        ui->next_cycle_ms = now_ms + UI_CYCLE_MS;
+    }
+}
+
+bool ui_next_deadline(const ui_state *ui, uint32_t *deadline_ms) {
+    if (!ui->auto_cycle) {
+        return false;
+    }
+    *deadline_ms = ui->next_cycle_ms;
+    return true;
+}
+
+bool ui_needs_render(const ui_state *ui, const sensor_data *data) {
+    return ui->screen != ui->shown_screen ||
+           screen_version(ui->screen, data) != ui->shown_version;
+}
+
+void ui_rendered(ui_state *ui, const sensor_data *data) {
+    ui->shown_screen = ui->screen;
+    ui->shown_version = screen_version(ui->screen, data);
+}
@@ -0,0 +1,49 @@
+/**
+ * Display UI state machine
+ *
+ * Decides which screen is shown and when it has to be redrawn:
+ *
+ *   - a button press moves to the next screen straight away
+ *   - a long press pins the screen that was shown before the press
+ *     (stops auto-cycling), or resumes auto-cycling if already pinned
+ *   - while auto-cycling, the next screen comes up every UI_CYCLE_MS,
+ *     restarted by every press
+ *
+ * A screen is only re-rendered when the selection changes or the data it
+ * shows changes (tracked with the version counters in sensor_data).
+ */
+
+#ifndef UI_H
+#define UI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "button.h"
+#include "sensors.h"
+
+#define UI_CYCLE_MS 3000
+
+typedef struct {
+    int screen;                 // Selected screen
+    int screen_before_press;    // Restored by a long press
+    bool auto_cycle;
+    uint32_t next_cycle_ms;
+    int shown_screen;           // Screen on the panel, -1 if none yet
+    uint32_t shown_version;     // Data version it was rendered from
+} ui_state;
+
+void ui_init(ui_state *ui, uint32_t now_ms);
+void ui_button(ui_state *ui, button_event event, uint32_t now_ms);
+
+// Advance the auto-cycle if it is due
+void ui_tick(ui_state *ui, uint32_t now_ms);
+
+// Deadline for the next ui_tick() that can change anything
+bool ui_next_deadline(const ui_state *ui, uint32_t *deadline_ms);
+
+bool ui_needs_render(const ui_state *ui, const sensor_data *data);
+
+// Record that the selected screen was rendered from the current data
+void ui_rendered(ui_state *ui, const sensor_data *data);
+
+#endif
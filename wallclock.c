@@ -0,0 +1,164 @@
+/**
+ * Wall clock for sample timestamps
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "timesync.h"
+#include "wallclock.h"
+
+#ifdef WALLCLOCK_RTC
+#include "hardware/rtc.h"
+#endif
+
+static timesync sync_state;
+
+// Last exchange, completed by the next request
+static int64_t last_t1 = 0;
+static uint64_t last_t2 = 0;
+static uint64_t last_t3 = 0;
+static bool have_last = false;
+
+#ifdef WALLCLOCK_RTC
+static bool rtc_valid = false;
+static int64_t rtc_set_at_s = -1;
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static int64_t days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void rtc_set_unix(int64_t unix_s) {
+    int64_t days = unix_s / 86400;
+    int secs = unix_s % 86400;
+
+    // Inverse of days_from_civil
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int doe = z - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    int day = doy - (153 * mp + 2) / 5 + 1;
+    int month = mp + (mp < 10 ? 3 : -9);
+    int year = yoe + era * 400 + (month <= 2);
+
+    datetime_t dt = {
+        .year = year,
+        .month = month,
+        .day = day,
+        .dotw = (days + 4) % 7,     // 1970-01-01 was a Thursday
+        .hour = secs / 3600,
+        .min = secs / 60 % 60,
+        .sec = secs % 60
+    };
+    rtc_set_datetime(&dt);
+    rtc_valid = true;
+}
+
+static bool rtc_unix(int64_t *unix_s) {
+    datetime_t dt;
+    if (!rtc_valid || !rtc_get_datetime(&dt)) {
+        return false;
+    }
+    *unix_s = days_from_civil(dt.year, dt.month, dt.day) * 86400 +
+              dt.hour * 3600 + dt.min * 60 + dt.sec;
+    return true;
+}
+#endif
+
+void wallclock_init(void) {
+    timesync_init(&sync_state);
+#ifdef WALLCLOCK_RTC
+    rtc_init();
+#endif
+}
+
+void wallclock_sync(const char *args, uint64_t rx_us) {
+    char *end;
+    int64_t t1 = strtoll(args, &end, 10);
+    if (end == args) {
+        printf("Usage: sync <t1> [<prev_t1> <prev_t4>]\n");
+        return;
+    }
+
+    // Complete the previous exchange if the host sent its receive time
+    const char *rest = end;
+    int64_t prev_t1 = strtoll(rest, &end, 10);
+    if (end != rest && have_last && prev_t1 == last_t1) {
+        rest = end;
+        int64_t prev_t4 = strtoll(rest, &end, 10);
+        if (end != rest) {
+            timesync_add(&sync_state, last_t1, last_t2, last_t3, prev_t4);
+        }
+    }
+
+    last_t1 = t1;
+    last_t2 = rx_us;
+    last_t3 = time_us_64();
+    have_last = true;
+    printf("#S %lld %llu %llu\n", (long long)t1, (unsigned long long)last_t2,
+           (unsigned long long)last_t3);
+
+#ifdef WALLCLOCK_RTC
+    // Keep the RTC on the synchronised time, once a minute is plenty
+    int64_t wall_us;
+    if (timesync_to_host(&sync_state, last_t3, &wall_us) &&
+        wall_us / 1000000 / 60 != rtc_set_at_s / 60) {
+        rtc_set_at_s = wall_us / 1000000;
+        rtc_set_unix(rtc_set_at_s);
+    }
+#endif
+}
+
+void wallclock_set(const char *args) {
+#ifdef WALLCLOCK_RTC
+    char *end;
+    int64_t unix_s = strtoll(args, &end, 10);
+    if (end == args || unix_s <= 0) {
+        printf("Usage: time <unix_seconds>\n");
+        return;
+    }
+    rtc_set_unix(unix_s);
+#else
+    (void)args;
+    printf("No RTC, build with WALLCLOCK_RTC or use sync\n");
+#endif
+}
+
+bool wallclock_from_local(uint64_t local_us, int64_t *wall_us) {
+    if (timesync_to_host(&sync_state, (int64_t)local_us, wall_us)) {
+        return true;
+    }
+#ifdef WALLCLOCK_RTC
+    // RTC seconds, placed at the time of the sample
+    int64_t unix_s;
+    if (rtc_unix(&unix_s)) {
+        *wall_us = unix_s * 1000000 - (int64_t)(time_us_64() - local_us);
+        return true;
+    }
+#endif
+    return false;
+}
+
+void wallclock_print(void) {
+    uint64_t now_us = time_us_64();
+    int64_t wall_us;
+    printf("Uptime: %llu us\n", (unsigned long long)now_us);
+    if (sync_state.valid) {
+        timesync_to_host(&sync_state, (int64_t)now_us, &wall_us);
+        printf("Synced: %lld us, offset %lld us, drift %ld ppb, %u exchanges\n",
+               (long long)wall_us, (long long)sync_state.offset_us,
+               (long)timesync_drift_ppb(&sync_state), sync_state.count);
+    } else if (wallclock_from_local(now_us, &wall_us)) {
+        printf("RTC: %lld s\n", (long long)(wall_us / 1000000));
+    } else {
+        printf("No wall clock yet\n");
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * Wall clock for sample timestamps
+ *
+ * Samples are stamped with the 64-bit microsecond timer at acquisition.
+ * A host can synchronise the device with the "sync" console command
+ * (see timesync.h), after which local timestamps convert to host time,
+ * normally Unix time in microseconds:
+ *
+ *   host:   sync <t1> [<prev_t1> <prev_t4>]
+ *   device: #S <t1> <t2> <t3>
+ *
+ * The host sends its clock as t1, and with each request the t1 and the
+ * receive time t4 of the previous exchange, so one line each way is a
+ * complete exchange. tools/timesync.py implements the host side.
+ *
+ * Built with WALLCLOCK_RTC, the RP2040 RTC is set from the synchronised
+ * time and keeps a (1 s resolution) wall clock if the host goes away.
+ * "time <unix_seconds>" sets it by hand.
+ */
+
+#ifndef WALLCLOCK_H
+#define WALLCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void wallclock_init(void);
+
+// Handle the arguments of a "sync" command received at rx_us
+void wallclock_sync(const char *args, uint64_t rx_us);
+
+// Handle the arguments of a "time" command
+void wallclock_set(const char *args);
+
+/**
+ * Convert a local timestamp to wall-clock microseconds
+ *
+ * @return false if no wall clock is available yet
+ */
+bool wallclock_from_local(uint64_t local_us, int64_t *wall_us);
+
+// Print the clock state
+void wallclock_print(void);
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * Retained-mode widgets for the SSD1306 framebuffer
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "gfx.h"
+#include "widget.h"
+
+void widget_invalidate(widget *w) {
+    w->shown = false;
+    w->have_value = false;
+    w->icon = NULL;
+    w->text[0] = '\0';
+}
+
+void widget_hide(ssd1306_t *disp, widget *w) {
+    if (w->shown) {
+        gfx_fill_rect(disp, w->box_x, w->box_y, w->box_w, w->box_h, GFX_CLEAR);
+    }
+    widget_invalidate(w);
+}
+
+// Replace the drawn text, erasing the old box first
+static void draw_text(ssd1306_t *disp, widget *w, const char *text) {
+    widget_hide(disp, w);
+
+    int len = strlen(text);
+    int scale = (w->flags & WIDGET_2X) ? 2 : 1;
+    int width = len > 0 ? len * 6 * scale - scale : 0;   // No spacing after the last char
+    int x = w->x;
+    if (w->flags & WIDGET_CENTER) {
+        // Same centring as the fixed-pitch layout: pitch * chars, not ink width
+        x = (disp->width - len * 6 * scale) / 2;
+        if (x < 0) x = 0;
+    }
+
+    if (scale == 2) {
+        draw_string_2x(disp, x, w->y, text);
+    } else {
+        draw_string(disp, x, w->y, text);
+    }
+
+    w->shown = true;
+    w->box_x = x;
+    w->box_y = w->y;
+    w->box_w = width;
+    w->box_h = 8 * scale;
+    ssd1306_mark_dirty(disp, w->box_x, w->box_y, w->box_w, w->box_h);
+    strncpy(w->text, text, WIDGET_TEXT_MAX - 1);
+    w->text[WIDGET_TEXT_MAX - 1] = '\0';
+}
+
+void widget_text(ssd1306_t *disp, widget *w, const char *text) {
+    if (w->shown && !w->have_value && strncmp(w->text, text, WIDGET_TEXT_MAX - 1) == 0) {
+        return;
+    }
+    draw_text(disp, w, text);
+}
+
+void widget_field(ssd1306_t *disp, widget *w, int32_t value) {
+    if (w->shown && w->have_value && w->value == value) {
+        return;
+    }
+
+    // Prefix, sign, 10 digits, point, decimals, suffix
+    char text[2 * WIDGET_AFFIX_MAX + 12 + WIDGET_DECIMALS_MAX + 1];
+    const char *prefix = w->prefix ? w->prefix : "";
+    const char *suffix = w->suffix ? w->suffix : "";
+    int decimals = w->decimals < WIDGET_DECIMALS_MAX ? w->decimals : WIDGET_DECIMALS_MAX;
+    if (decimals == 0) {
+        snprintf(text, sizeof(text), "%s%ld%s", prefix, (long)value, suffix);
+    } else {
+        uint32_t div = 1;
+        for (int i = 0; i < decimals; i++) div *= 10;
+        uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+        snprintf(text, sizeof(text), "%s%s%lu.%0*lu%s", prefix, value < 0 ? "-" : "",
+                 (unsigned long)(mag / div), decimals, (unsigned long)(mag % div), suffix);
+    }
+
+    draw_text(disp, w, text);
+    w->have_value = true;
+    w->value = value;
+}
+
+void widget_bar(ssd1306_t *disp, widget *w, uint8_t percent) {
+    if (percent > 100) percent = 100;
+    if (w->shown && w->value == percent) {
+        return;
+    }
+
+    int old_fill = w->shown ? w->w * w->value / 100 : 0;
+    int new_fill = w->w * percent / 100;
+
+    // Only the part between the old and new fill changes
+    if (new_fill > old_fill) {
+        gfx_fill_rect(disp, w->x + old_fill, w->y, new_fill - old_fill, w->h, GFX_SET);
+    } else if (new_fill < old_fill) {
+        gfx_fill_rect(disp, w->x + new_fill, w->y, old_fill - new_fill, w->h, GFX_CLEAR);
+    }
+
+    w->shown = true;
+    w->value = percent;
+    w->box_x = w->x;
+    w->box_y = w->y;
+    w->box_w = w->w;
+    w->box_h = w->h;
+}
+
+void widget_icon(ssd1306_t *disp, widget *w, const uint8_t *bitmap) {
+    if (bitmap == NULL) {
+        widget_hide(disp, w);
+        return;
+    }
+    if (w->shown && w->icon == bitmap) {
+        return;
+    }
+
+    widget_hide(disp, w);
+    gfx_blit(disp, w->x, w->y, bitmap, 8, 8, GFX_SET);
+
+    w->shown = true;
+    w->icon = bitmap;
+    w->box_x = w->x;
+    w->box_y = w->y;
+    w->box_w = 8;
+    w->box_h = 8;
+}
@@ -0,0 +1,69 @@
+/**
+ * Retained-mode widgets for the SSD1306 framebuffer
+ *
+ * A widget remembers what it last drew and where. Setting it to the same
+ * content again does nothing at all; new content erases the old bounding
+ * box, draws the new one and marks both dirty, so ssd1306_flush() only
+ * sends the changed columns. Numeric fields compare the raw value and
+ * only format text when it changed.
+ *
+ * Widgets are plain structs, usually static and set up with designated
+ * initialisers. Widgets drawn on one screen must not overlap.
+ */
+
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+#define WIDGET_TEXT_MAX 24
+#define WIDGET_DECIMALS_MAX 4   // Larger field decimals are shown as this many
+#define WIDGET_AFFIX_MAX 8      // Longest field prefix or suffix
+
+// Layout flags
+#define WIDGET_2X 0x01          // Double size text
+#define WIDGET_CENTER 0x02      // x is ignored, text is centred on the panel
+
+typedef enum {
+    WIDGET_TEXT,                // Free text label
+    WIDGET_FIELD,               // prefix + fixed-point number + suffix
+    WIDGET_BAR,                 // Horizontal bar filled to a percentage
+    WIDGET_ICON                 // 8x8 bitmap, one byte per column
+} widget_type;
+
+typedef struct {
+    // Layout, set once
+    widget_type type;
+    int16_t x;
+    int16_t y;
+    uint8_t w;                  // Bar size
+    uint8_t h;
+    uint8_t flags;
+    uint8_t decimals;           // Field: digits after the decimal point
+    const char *prefix;         // Field: text before the number, WIDGET_AFFIX_MAX at most
+    const char *suffix;         // Field: text after the number, WIDGET_AFFIX_MAX at most
+
+    // Cache of what is on the panel
+    bool shown;
+    bool have_value;
+    int32_t value;              // Field value, bar percentage
+    const uint8_t *icon;
+    char text[WIDGET_TEXT_MAX];
+    int16_t box_x, box_y;       // Bounding box of the drawn content
+    uint8_t box_w, box_h;
+} widget;
+
+// Forget the cache, e.g. after the framebuffer was cleared
+void widget_invalidate(widget *w);
+
+void widget_text(ssd1306_t *disp, widget *w, const char *text);
+void widget_field(ssd1306_t *disp, widget *w, int32_t value);
+void widget_bar(ssd1306_t *disp, widget *w, uint8_t percent);
+void widget_icon(ssd1306_t *disp, widget *w, const uint8_t *bitmap);
+
+// Erase the widget from the panel
+void widget_hide(ssd1306_t *disp, widget *w);
+
+#endif